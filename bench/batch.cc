@@ -0,0 +1,49 @@
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "bench.h"
+#include "cpp_tree_sitter/batch.h"
+
+namespace {
+
+auto Measure(const uint32_t thread_count, const ts::bench::Options &options,
+             const std::vector<std::string_view> &sources) -> void {
+  auto batch_parser = ts::BatchParser{ts::BatchOptions{thread_count, 0,
+                                                       ts::Parser::kNoTimeout}};
+  const auto language = ts::Language::FromRaw(options.language);
+  auto checksum = std::atomic<uint64_t>{0};
+  const auto callback = [&checksum](const size_t, ts::Tree &&tree) {
+    if (!tree.IsNull()) {
+      checksum.fetch_add(tree.RootNode().DescendantCount(),
+                         std::memory_order_relaxed);
+    }
+  };
+
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    batch_parser.ParseAll(language, sources, callback, false);
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+
+  const auto variant = "threads=" + std::to_string(thread_count);
+  ts::bench::Report("batch", variant, seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum.load() / options.iterations);
+}
+
+} // namespace
+
+auto ts::bench::RunBatch(const ts::bench::Options &options) -> int {
+  const auto sources =
+      std::vector<std::string_view>{options.inputs.begin(),
+                                    options.inputs.end()};
+  const auto max_thread_count =
+      std::max(std::thread::hardware_concurrency(), 1u);
+  for (uint32_t thread_count = 1; thread_count < max_thread_count;
+       thread_count *= 2) {
+    Measure(thread_count, options, sources);
+  }
+  Measure(max_thread_count, options, sources);
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "bench.h"
+
+#include <dlfcn.h>
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ts::bench;
+
+namespace {
+
+struct Row {
+  std::string case_name;
+  std::string variant;
+  double seconds;
+  uint64_t bytes;
+  uint64_t peak_rss_bytes;
+  uint64_t checksum;
+};
+
+bool is_json_report = false;
+std::vector<Row> rows;
+
+auto PrintJsonString(const std::string_view string) noexcept -> void {
+  std::putchar('"');
+  for (const auto c : string) {
+    if (c == '"' || c == '\\') {
+      std::printf("\\%c", c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      std::printf("\\u%04x", static_cast<unsigned>(c));
+    } else {
+      std::putchar(c);
+    }
+  }
+  std::putchar('"');
+}
+
+auto MegabytesPerSecond(const uint64_t bytes, const double seconds) noexcept
+    -> double {
+  const auto megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+  return seconds > 0 ? megabytes / seconds : 0.0;
+}
+
+} // namespace
+
+// Stopwatch
+// --------
+
+ts::bench::Stopwatch::Stopwatch() noexcept
+    : start_{std::chrono::steady_clock::now()} {}
+
+auto ts::bench::Stopwatch::ElapsedSeconds() const noexcept -> double {
+  const auto elapsed = std::chrono::steady_clock::now() - start_;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+// Utilities
+// --------
+
+auto ts::bench::LoadLanguage(const std::string &path,
+                             const std::string &symbol) noexcept
+    -> const TSLanguage * {
+  const auto handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    std::cerr << "dlopen: " << dlerror() << '\n';
+    return nullptr;
+  }
+  using LanguageFn = auto (*)() -> const TSLanguage *;
+  const auto language_fn =
+      reinterpret_cast<LanguageFn>(dlsym(handle, symbol.c_str()));
+  if (language_fn == nullptr) {
+    std::cerr << "dlsym: " << dlerror() << '\n';
+    return nullptr;
+  }
+  return language_fn();
+}
+
+auto ts::bench::ReadFile(const std::string &path,
+                         std::string &contents) noexcept -> bool {
+  auto file = std::ifstream{path, std::ios::binary};
+  if (!file) {
+    return false;
+  }
+  auto stream = std::ostringstream{};
+  stream << file.rdbuf();
+  contents = std::move(stream).str();
+  return true;
+}
+
+auto ts::bench::TotalBytes(const ts::bench::Options &options) noexcept
+    -> uint64_t {
+  uint64_t bytes = 0;
+  for (const auto &input : options.inputs) {
+    bytes += input.size();
+  }
+  return bytes;
+}
+
+auto ts::bench::ParseInputs(const ts::bench::Options &options) noexcept
+    -> std::vector<ts::Tree> {
+  auto parser = ts::Parser{};
+  parser.SetLanguage(ts::Language::FromRaw(options.language));
+  auto trees = std::vector<ts::Tree>{};
+  trees.reserve(options.inputs.size());
+  for (const auto &input : options.inputs) {
+    trees.push_back(parser.ParseString(ts::Tree::Null(), input));
+  }
+  return trees;
+}
+
+auto ts::bench::PeakRssBytes() noexcept -> uint64_t {
+  // `VmHWM` follows `ResetPeakRss`, while `ru_maxrss` only grows.
+  auto status = std::ifstream{"/proc/self/status"};
+  auto line = std::string{};
+  while (std::getline(status, line)) {
+    if (line.starts_with("VmHWM:")) {
+      return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+    }
+  }
+  auto usage = rusage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+auto ts::bench::ResetPeakRss() noexcept -> void {
+  auto clear_refs = std::ofstream{"/proc/self/clear_refs"};
+  clear_refs << "5";
+}
+
+auto ts::bench::Report(const std::string_view case_name,
+                       const std::string_view variant, const double seconds,
+                       const uint64_t bytes, const uint64_t checksum) noexcept
+    -> void {
+  const auto peak_rss_bytes = ts::bench::PeakRssBytes();
+  ts::bench::ResetPeakRss();
+  if (is_json_report) {
+    rows.push_back(Row{std::string{case_name}, std::string{variant}, seconds,
+                       bytes, peak_rss_bytes, checksum});
+    return;
+  }
+  std::printf("%-12.*s %-16.*s %10.3f ms %10.2f MB/s %8.1f MB peak  "
+              "checksum=%llu\n",
+              static_cast<int>(case_name.size()), case_name.data(),
+              static_cast<int>(variant.size()), variant.data(),
+              seconds * 1000.0, MegabytesPerSecond(bytes, seconds),
+              static_cast<double>(peak_rss_bytes) / (1024.0 * 1024.0),
+              static_cast<unsigned long long>(checksum));
+}
+
+auto ts::bench::EnableJsonReport() noexcept -> void { is_json_report = true; }
+
+auto ts::bench::PrintJsonReport(const std::string_view grammar,
+                                const std::string_view symbol,
+                                const ts::bench::Options &options) noexcept
+    -> void {
+  std::printf("{\"grammar\":");
+  PrintJsonString(grammar);
+  std::printf(",\"symbol\":");
+  PrintJsonString(symbol);
+  std::printf(",\"files\":%zu,\"bytes\":%llu,\"iterations\":%u,"
+              "\"results\":[",
+              options.inputs.size(),
+              static_cast<unsigned long long>(ts::bench::TotalBytes(options)),
+              options.iterations);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const auto &row = rows[i];
+    std::printf("%s\n  {\"case\":", i == 0 ? "" : ",");
+    PrintJsonString(row.case_name);
+    std::printf(",\"variant\":");
+    PrintJsonString(row.variant);
+    std::printf(",\"ms\":%.6f,\"mb_per_s\":%.3f,\"peak_rss_bytes\":%llu,"
+                "\"checksum\":%llu}",
+                row.seconds * 1000.0,
+                MegabytesPerSecond(row.bytes, row.seconds),
+                static_cast<unsigned long long>(row.peak_rss_bytes),
+                static_cast<unsigned long long>(row.checksum));
+  }
+  std::printf("]}\n");
+}
+
+// Cases
+// --------
+
+auto ts::bench::RunSuite(const ts::bench::Options &options) -> int {
+  for (const auto run : {ts::bench::RunParse, ts::bench::RunEdit,
+                         ts::bench::RunWalk, ts::bench::RunQuery}) {
+    if (const auto status = run(options); status != 0) {
+      return status;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef CPP_TREE_SITTER_BENCH_BENCH_H
+#define CPP_TREE_SITTER_BENCH_BENCH_H
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpp_tree_sitter/api.h"
+
+namespace ts::bench {
+
+// Options
+// --------
+
+struct Options {
+  const TSLanguage *language;
+  std::vector<std::string> inputs;
+  uint32_t iterations;
+  // The source of the query run by the query case.
+  std::string query;
+};
+
+// Case
+// --------
+
+struct Case {
+  std::string_view name;
+  auto (*run)(const ts::bench::Options &options) -> int;
+};
+
+// Stopwatch
+// --------
+
+class Stopwatch {
+public:
+  explicit Stopwatch() noexcept;
+
+  auto ElapsedSeconds() const noexcept -> double;
+
+private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Utilities
+// --------
+
+// Loads `symbol` from the grammar shared library at `path` e.g.)
+// `libtree-sitter-json.so` and `tree_sitter_json`. It returns `nullptr` on
+// failure.
+auto LoadLanguage(const std::string &path, const std::string &symbol) noexcept
+    -> const TSLanguage *;
+
+auto ReadFile(const std::string &path, std::string &contents) noexcept -> bool;
+
+auto TotalBytes(const ts::bench::Options &options) noexcept -> uint64_t;
+
+auto ParseInputs(const ts::bench::Options &options) noexcept
+    -> std::vector<ts::Tree>;
+
+// The high water mark of the resident set size, in bytes.
+auto PeakRssBytes() noexcept -> uint64_t;
+// Lowers the high water mark to the current resident set size, if the kernel
+// supports it, so the next peak belongs to the next case.
+auto ResetPeakRss() noexcept -> void;
+
+// Prints a row, unless the results are printed as JSON at the end. The peak RSS
+// of the row is the one since the previous row.
+auto Report(const std::string_view case_name, const std::string_view variant,
+            const double seconds, const uint64_t bytes,
+            const uint64_t checksum) noexcept -> void;
+
+// Collects the rows instead of printing them.
+auto EnableJsonReport() noexcept -> void;
+// Prints the rows collected since `EnableJsonReport` as one JSON object.
+auto PrintJsonReport(const std::string_view grammar,
+                     const std::string_view symbol,
+                     const ts::bench::Options &options) noexcept -> void;
+
+// Cases
+// --------
+
+auto RunWalk(const ts::bench::Options &options) -> int;
+auto RunPrint(const ts::bench::Options &options) -> int;
+// Each iteration parses every input from scratch, or loads the serialized
+// `ts::FlatTree` of every input.
+auto RunParse(const ts::bench::Options &options) -> int;
+// Each iteration types a space into each input and reparses it.
+auto RunEdit(const ts::bench::Options &options) -> int;
+// Each iteration parses all the inputs with `ts::BatchParser`, once per thread
+// count from 1 to the number of cores.
+auto RunBatch(const ts::bench::Options &options) -> int;
+// Each iteration runs four analysis passes over every tree, either by walking
+// the tree or by scanning a `ts::FlatTree`.
+auto RunFlat(const ts::bench::Options &options) -> int;
+// Each iteration runs `options.query` over every tree, by matches and by
+// captures, then makes a random edit to every input and updates a
+// `ts::IncrementalQueryIndex`, which is checked against a fresh execution.
+auto RunQuery(const ts::bench::Options &options) -> int;
+// Runs parse, edit, walk and query, the cases to compare across versions.
+auto RunSuite(const ts::bench::Options &options) -> int;
+
+} // namespace ts::bench
+
+#endif // CPP_TREE_SITTER_BENCH_BENCH_H
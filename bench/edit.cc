@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+struct Keystroke {
+  uint32_t byte;
+  ts::Point point;
+};
+
+// Picks one position per iteration, spread over the input and moved to the
+// next whitespace so that typing a space there keeps the tree shape. They are
+// in descending order, so typing at one does not shift the others.
+auto PlanKeystrokes(const std::string &input, const uint32_t count)
+    -> std::vector<Keystroke> {
+  auto bytes = std::vector<uint32_t>{};
+  for (uint32_t i = 0; i < count; ++i) {
+    auto byte = static_cast<size_t>(
+        static_cast<uint64_t>(input.size()) * (count - i) / (count + 1));
+    while (byte < input.size() && input[byte] != ' ' && input[byte] != '\n') {
+      ++byte;
+    }
+    bytes.push_back(static_cast<uint32_t>(byte));
+  }
+  std::sort(bytes.begin(), bytes.end());
+
+  auto keystrokes = std::vector<Keystroke>{};
+  auto point = ts::Point{TSPoint{0, 0}};
+  size_t byte = 0;
+  for (const auto target : bytes) {
+    for (; byte < target; ++byte) {
+      if (input[byte] == '\n') {
+        ++point.row;
+        point.column = 0;
+      } else {
+        ++point.column;
+      }
+    }
+    keystrokes.push_back(Keystroke{target, point});
+  }
+  std::reverse(keystrokes.begin(), keystrokes.end());
+  return keystrokes;
+}
+
+auto Type(std::string &text, const Keystroke &keystroke) -> ts::InputEdit {
+  text.insert(keystroke.byte, 1, ' ');
+  auto new_end_point = keystroke.point;
+  ++new_end_point.column;
+  return ts::InputEdit{TSInputEdit{keystroke.byte, keystroke.byte,
+                                   keystroke.byte + 1, keystroke.point,
+                                   keystroke.point, new_end_point}};
+}
+
+auto Checksum(const ts::Tree &tree) -> uint64_t {
+  const auto root = tree.RootNode();
+  return root.EndByte() * 31ull + root.DescendantCount();
+}
+
+enum class Variant { kFull, kIncremental, kChangedRanges };
+
+auto Measure(const std::string_view variant_name, const Variant variant,
+             const ts::bench::Options &options) -> void {
+  auto parser = ts::Parser{};
+  parser.SetLanguage(ts::Language::FromRaw(options.language));
+
+  double seconds = 0;
+  uint64_t checksum = 0;
+  for (const auto &input : options.inputs) {
+    const auto keystrokes = PlanKeystrokes(input, options.iterations);
+    auto text = input;
+    auto tree = parser.ParseString(ts::Tree::Null(), text);
+    for (const auto &keystroke : keystrokes) {
+      const auto input_edit = Type(text, keystroke);
+      const auto stopwatch = ts::bench::Stopwatch{};
+      switch (variant) {
+      case Variant::kFull:
+        tree = parser.ParseString(ts::Tree::Null(), text);
+        break;
+      case Variant::kIncremental:
+        tree.Edit(input_edit);
+        tree = parser.ParseString(std::move(tree), text);
+        break;
+      case Variant::kChangedRanges: {
+        tree.Edit(input_edit);
+        const auto old_tree = tree.Copy();
+        tree = parser.ParseString(std::move(tree), text);
+        checksum += old_tree.ChangedRanges(tree).size();
+        break;
+      }
+      }
+      seconds += stopwatch.ElapsedSeconds();
+      checksum += Checksum(tree);
+    }
+  }
+  // The latency of one keystroke in each input.
+  ts::bench::Report("edit", variant_name, seconds / options.iterations,
+                    ts::bench::TotalBytes(options), checksum);
+}
+
+} // namespace
+
+auto ts::bench::RunEdit(const ts::bench::Options &options) -> int {
+  Measure("full", Variant::kFull, options);
+  Measure("incremental", Variant::kIncremental, options);
+  Measure("changed_ranges", Variant::kChangedRanges, options);
+  return 0;
+}
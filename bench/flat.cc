@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <vector>
+
+#include "bench.h"
+#include "cpp_tree_sitter/flat.h"
+#include "cpp_tree_sitter/walk.h"
+
+namespace {
+
+// The results of four analysis passes, each of which visits every node:
+// a histogram of named symbols, the maximum depth, the bytes covered by leaves
+// and the number of nodes in a field.
+struct Analysis {
+  std::vector<uint64_t> histogram;
+  uint64_t max_depth = 0;
+  uint64_t leaf_bytes = 0;
+  uint64_t field_count = 0;
+
+  auto Checksum() const -> uint64_t {
+    auto checksum = max_depth * 31 + leaf_bytes * 7 + field_count;
+    for (size_t i = 0; i < histogram.size(); ++i) {
+      checksum += histogram[i] * i;
+    }
+    return checksum;
+  }
+};
+
+auto HistogramByChildIndex(const ts::Node &node, Analysis &analysis) -> void {
+  if (node.IsNamed()) {
+    ++analysis.histogram[node.Symbol()];
+  }
+  const auto child_count = node.ChildCount();
+  for (uint32_t i = 0; i < child_count; ++i) {
+    HistogramByChildIndex(node.Child(i), analysis);
+  }
+}
+
+auto DepthByChildIndex(const ts::Node &node, const uint64_t depth,
+                       Analysis &analysis) -> void {
+  analysis.max_depth = std::max(analysis.max_depth, depth);
+  const auto child_count = node.ChildCount();
+  for (uint32_t i = 0; i < child_count; ++i) {
+    DepthByChildIndex(node.Child(i), depth + 1, analysis);
+  }
+}
+
+auto LeafBytesByChildIndex(const ts::Node &node, Analysis &analysis) -> void {
+  const auto child_count = node.ChildCount();
+  if (child_count == 0) {
+    analysis.leaf_bytes += node.EndByte() - node.StartByte();
+  }
+  for (uint32_t i = 0; i < child_count; ++i) {
+    LeafBytesByChildIndex(node.Child(i), analysis);
+  }
+}
+
+auto FieldsByChildIndex(const ts::Node &node, Analysis &analysis) -> void {
+  const auto child_count = node.ChildCount();
+  for (uint32_t i = 0; i < child_count; ++i) {
+    if (!node.FieldNameForChild(i).empty()) {
+      ++analysis.field_count;
+    }
+    FieldsByChildIndex(node.Child(i), analysis);
+  }
+}
+
+auto AnalyzeNodes(const ts::Tree &tree, Analysis &analysis) -> void {
+  const auto root = tree.RootNode();
+  HistogramByChildIndex(root, analysis);
+  DepthByChildIndex(root, 0, analysis);
+  LeafBytesByChildIndex(root, analysis);
+  FieldsByChildIndex(root, analysis);
+}
+
+auto AnalyzeCursor(const ts::Tree &tree, Analysis &analysis) -> void {
+  const auto root = tree.RootNode();
+  ts::WalkPreOrder(root, [&analysis](const ts::TreeCursor &cursor) {
+    const auto node = cursor.CurrentNode();
+    if (node.IsNamed()) {
+      ++analysis.histogram[node.Symbol()];
+    }
+    return ts::WalkAction::kContinue;
+  });
+  ts::WalkPreOrder(root, [&analysis](const ts::TreeCursor &cursor) {
+    analysis.max_depth =
+        std::max<uint64_t>(analysis.max_depth, cursor.CurrentDepth());
+    return ts::WalkAction::kContinue;
+  });
+  ts::WalkPreOrder(root, [&analysis](const ts::TreeCursor &cursor) {
+    const auto node = cursor.CurrentNode();
+    if (node.ChildCount() == 0) {
+      analysis.leaf_bytes += node.EndByte() - node.StartByte();
+    }
+    return ts::WalkAction::kContinue;
+  });
+  ts::WalkPreOrder(root, [&analysis](const ts::TreeCursor &cursor) {
+    if (cursor.CurrentFieldId() != 0) {
+      ++analysis.field_count;
+    }
+    return ts::WalkAction::kContinue;
+  });
+}
+
+auto AnalyzeFlat(const ts::FlatTree &flat_tree, Analysis &analysis) -> void {
+  const auto symbols = flat_tree.Symbols();
+  const auto flags = flat_tree.AllFlags();
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    if ((flags[i] & ts::FlatTree::kNamed) != 0) {
+      ++analysis.histogram[symbols[i]];
+    }
+  }
+
+  // A parent precedes its children, so one forward pass computes the depths.
+  const auto parents = flat_tree.Parents();
+  auto depths = std::vector<uint32_t>(parents.size());
+  for (size_t i = 1; i < parents.size(); ++i) {
+    depths[i] = depths[parents[i]] + 1;
+    analysis.max_depth = std::max<uint64_t>(analysis.max_depth, depths[i]);
+  }
+
+  const auto start_bytes = flat_tree.StartBytes();
+  const auto end_bytes = flat_tree.EndBytes();
+  const auto subtree_sizes = flat_tree.SubtreeSizes();
+  for (size_t i = 0; i < subtree_sizes.size(); ++i) {
+    if (subtree_sizes[i] == 1) {
+      analysis.leaf_bytes += end_bytes[i] - start_bytes[i];
+    }
+  }
+
+  for (const auto field_id : flat_tree.FieldIds()) {
+    analysis.field_count += field_id != 0;
+  }
+}
+
+template <typename AnalyzeFn>
+auto Measure(const std::string_view variant,
+             const ts::bench::Options &options,
+             const std::vector<ts::Tree> &trees, AnalyzeFn &&analyze_fn)
+    -> void {
+  auto checksum = uint64_t{0};
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &tree : trees) {
+      auto analysis = Analysis{};
+      analysis.histogram.resize(ts_language_symbol_count(options.language));
+      analyze_fn(tree, analysis);
+      checksum += analysis.Checksum();
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("flat", variant, seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+}
+
+} // namespace
+
+auto ts::bench::RunFlat(const ts::bench::Options &options) -> int {
+  const auto trees = ts::bench::ParseInputs(options);
+
+  Measure("node_child", options, trees, AnalyzeNodes);
+  Measure("cursor", options, trees, AnalyzeCursor);
+  // Includes building the flat tree, so it is the cost of a one-off analysis.
+  Measure("flat_build", options, trees,
+          [](const ts::Tree &tree, Analysis &analysis) {
+            AnalyzeFlat(ts::FlatTree::Build(tree), analysis);
+          });
+
+  auto flat_trees = std::vector<ts::FlatTree>{};
+  for (const auto &tree : trees) {
+    flat_trees.push_back(ts::FlatTree::Build(tree));
+  }
+  Measure("flat", options, trees,
+          [&trees, &flat_trees](const ts::Tree &tree, Analysis &analysis) {
+            AnalyzeFlat(flat_trees[&tree - trees.data()], analysis);
+          });
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+
+#include "bench.h"
+
+namespace {
+
+constexpr ts::bench::Case kCases[] = {
+    {"walk", ts::bench::RunWalk},
+    {"print", ts::bench::RunPrint},
+    {"edit", ts::bench::RunEdit},
+    {"batch", ts::bench::RunBatch},
+    {"flat", ts::bench::RunFlat},
+    {"parse", ts::bench::RunParse},
+    {"query", ts::bench::RunQuery},
+    {"suite", ts::bench::RunSuite},
+};
+
+// Every node, so the query case measures the matching machinery rather than a
+// grammar-specific pattern.
+constexpr std::string_view kDefaultQuery = "(_) @node";
+
+auto PrintUsage() -> void {
+  std::cerr << "usage: cpp_tree_sitter_bench <grammar.so> <language-symbol> "
+               "<case> <file-or-dir>... [--iterations=N] [--min-bytes=N] "
+               "[--query=FILE] [--format=text|json]\n";
+  std::cerr << "cases:";
+  for (const auto &bench_case : kCases) {
+    std::cerr << ' ' << bench_case.name;
+  }
+  std::cerr << '\n';
+}
+
+auto ParseFlag(const std::string_view arg, const std::string_view name,
+               uint64_t &value) -> bool {
+  if (!arg.starts_with(name)) {
+    return false;
+  }
+  const auto digits = arg.substr(name.size());
+  std::from_chars(digits.data(), digits.data() + digits.size(), value);
+  return true;
+}
+
+auto ParseFlag(const std::string_view arg, const std::string_view name,
+               std::string_view &value) -> bool {
+  if (!arg.starts_with(name)) {
+    return false;
+  }
+  value = arg.substr(name.size());
+  return true;
+}
+
+// A directory is a corpus: its regular files, recursively, in a stable order.
+auto ExpandPath(const std::string_view path, std::vector<std::string> &files)
+    -> bool {
+  auto error_code = std::error_code{};
+  if (!std::filesystem::is_directory(path, error_code)) {
+    files.emplace_back(path);
+    return true;
+  }
+  auto corpus_files = std::vector<std::string>{};
+  auto it = std::filesystem::recursive_directory_iterator{path, error_code};
+  for (; !error_code && it != std::filesystem::recursive_directory_iterator{};
+       it.increment(error_code)) {
+    if (it->is_regular_file(error_code)) {
+      corpus_files.push_back(it->path().string());
+    }
+  }
+  if (error_code) {
+    std::cerr << "cannot list " << path << ": " << error_code.message()
+              << '\n';
+    return false;
+  }
+  std::sort(corpus_files.begin(), corpus_files.end());
+  files.insert(files.end(), corpus_files.begin(), corpus_files.end());
+  return true;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  if (argc < 5) {
+    PrintUsage();
+    return 2;
+  }
+
+  auto options = ts::bench::Options{};
+  options.language = ts::bench::LoadLanguage(argv[1], argv[2]);
+  if (options.language == nullptr) {
+    return 1;
+  }
+  const auto case_name = std::string_view{argv[3]};
+
+  uint64_t iterations = 5;
+  uint64_t min_bytes = 0;
+  auto query_path = std::string_view{};
+  auto format = std::string_view{"text"};
+  auto paths = std::vector<std::string>{};
+  for (int i = 4; i < argc; ++i) {
+    const auto arg = std::string_view{argv[i]};
+    if (!ParseFlag(arg, "--iterations=", iterations) &&
+        !ParseFlag(arg, "--min-bytes=", min_bytes) &&
+        !ParseFlag(arg, "--query=", query_path) &&
+        !ParseFlag(arg, "--format=", format) && !ExpandPath(arg, paths)) {
+      return 1;
+    }
+  }
+  if (format != "text" && format != "json") {
+    PrintUsage();
+    return 2;
+  }
+
+  options.query = std::string{kDefaultQuery};
+  if (!query_path.empty() &&
+      !ts::bench::ReadFile(std::string{query_path}, options.query)) {
+    std::cerr << "cannot read " << query_path << '\n';
+    return 1;
+  }
+
+  for (const auto &path : paths) {
+    auto contents = std::string{};
+    if (!ts::bench::ReadFile(path, contents)) {
+      std::cerr << "cannot read " << path << '\n';
+      return 1;
+    }
+    // Replicate small inputs to reach multi-MB sizes.
+    const auto original_size = contents.size();
+    while (original_size > 0 && contents.size() < min_bytes) {
+      contents.append(contents.data(), original_size);
+    }
+    options.inputs.push_back(std::move(contents));
+  }
+  options.iterations = static_cast<uint32_t>(iterations);
+
+  for (const auto &bench_case : kCases) {
+    if (bench_case.name == case_name) {
+      if (format == "json") {
+        ts::bench::EnableJsonReport();
+      }
+      const auto status = bench_case.run(options);
+      if (status == 0 && format == "json") {
+        ts::bench::PrintJsonReport(argv[1], argv[2], options);
+      }
+      return status;
+    }
+  }
+  PrintUsage();
+  return 2;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <string_view>
+
+#include "bench.h"
+#include "cpp_tree_sitter/flat.h"
+
+namespace {
+
+auto LoadErrorName(const ts::FlatTree::LoadError error) -> std::string_view {
+  switch (error) {
+  case ts::FlatTree::LoadError::kNone:
+    return "none";
+  case ts::FlatTree::LoadError::kIo:
+    return "io";
+  case ts::FlatTree::LoadError::kMagic:
+    return "magic";
+  case ts::FlatTree::LoadError::kFormatVersion:
+    return "format version";
+  case ts::FlatTree::LoadError::kLanguageVersion:
+    return "language version";
+  case ts::FlatTree::LoadError::kSymbolCount:
+    return "symbol count";
+  case ts::FlatTree::LoadError::kFieldCount:
+    return "field count";
+  case ts::FlatTree::LoadError::kCorrupt:
+    return "corrupt";
+  }
+  return "unknown";
+}
+
+auto MeasureParse(const ts::bench::Options &options) -> void {
+  auto parser = ts::Parser{};
+  parser.SetLanguage(ts::Language::FromRaw(options.language));
+
+  uint64_t checksum = 0;
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &input : options.inputs) {
+      const auto tree = parser.ParseString(ts::Tree::Null(), input);
+      checksum += tree.RootNode().DescendantCount();
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("parse", "full", seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+}
+
+// Loads the serialized `ts::FlatTree` of each input instead of parsing it.
+auto MeasureFlatLoad(const ts::bench::Options &options) -> int {
+  const auto language = ts::Language::FromRaw(options.language);
+  auto serialized_trees = std::vector<std::string>{};
+  for (const auto &tree : ts::bench::ParseInputs(options)) {
+    serialized_trees.emplace_back(ts::FlatTree::Build(tree).Bytes());
+  }
+
+  uint64_t checksum = 0;
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &serialized_tree : serialized_trees) {
+      auto error = ts::FlatTree::LoadError::kNone;
+      const auto flat_tree =
+          ts::FlatTree::Load(serialized_tree, language, error);
+      if (flat_tree.IsNull()) {
+        std::cerr << "cannot load a flat tree: " << LoadErrorName(error)
+                  << '\n';
+        return 1;
+      }
+      checksum += flat_tree.Size();
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("parse", "flat_load", seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+  return 0;
+}
+
+} // namespace
+
+auto ts::bench::RunParse(const ts::bench::Options &options) -> int {
+  MeasureParse(options);
+  return MeasureFlatLoad(options);
+}
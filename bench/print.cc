@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "cpp_tree_sitter/printer.h"
+
+namespace {
+
+auto Measure(const std::string_view variant, const ts::bench::Options &options,
+             const std::vector<ts::Tree> &trees,
+             const ts::PrintOptions &print_options) -> void {
+  auto printer = ts::TreePrinter{print_options};
+  uint64_t checksum = 0;
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &tree : trees) {
+      printer.Clear();
+      printer.Print(tree);
+      checksum += printer.Buffer().size();
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("print", variant, seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+}
+
+} // namespace
+
+auto ts::bench::RunPrint(const ts::bench::Options &options) -> int {
+  const auto trees = ts::bench::ParseInputs(options);
+
+  uint64_t checksum = 0;
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &tree : trees) {
+      checksum += tree.RootNode().String().StringView().size();
+    }
+  }
+  ts::bench::Report("print", "node_string",
+                    stopwatch.ElapsedSeconds() / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+
+  Measure("s_expression", options, trees, ts::PrintOptions{});
+  Measure("json", options, trees,
+          ts::PrintOptions{ts::PrintFormat::kJson,
+                           ts::PrintField::kFieldName |
+                               ts::PrintField::kByteRange,
+                           true});
+  Measure("verbose", options, trees,
+          ts::PrintOptions{ts::PrintFormat::kVerbose, ts::PrintField::kAll,
+                           false});
+  return 0;
+}
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bench.h"
+#include "cpp_tree_sitter/incremental.h"
+#include "cpp_tree_sitter/parallel.h"
+#include "cpp_tree_sitter/query.h"
+
+namespace {
+
+enum class Variant { kMatches, kCaptures };
+
+auto Measure(const std::string_view variant_name, const Variant variant,
+             const ts::bench::Options &options, const ts::Query &query,
+             const std::vector<ts::Tree> &trees) -> void {
+  auto query_cursor = ts::QueryCursor{};
+  uint64_t checksum = 0;
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &tree : trees) {
+      query_cursor.Exec(query, tree.RootNode());
+      switch (variant) {
+      case Variant::kMatches: {
+        auto match = ts::QueryMatch{};
+        while (query_cursor.NextMatch(match)) {
+          checksum += match.PatternIndex() + match.Captures().size();
+        }
+        break;
+      }
+      case Variant::kCaptures: {
+        auto match_capture = ts::QueryMatchCapture{};
+        while (query_cursor.NextCapture(match_capture)) {
+          checksum += match_capture.Capture().Node().StartByte();
+        }
+        break;
+      }
+      }
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("query", variant_name, seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+}
+
+// The checksum equals the one of "matches" if the sharded matches are the same.
+auto MeasureParallel(const ts::bench::Options &options, const ts::Query &query,
+                     const std::vector<ts::Tree> &trees) -> void {
+  auto executor = ts::ParallelQueryExecutor{ts::ParallelQueryOptions{}};
+  auto matches = ts::QueryMatchList{};
+  uint64_t checksum = 0;
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &tree : trees) {
+      executor.Matches(query, tree.RootNode(), matches);
+      for (size_t j = 0; j < matches.Size(); ++j) {
+        checksum += matches.PatternIndex(j) + matches.Captures(j).size();
+      }
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("query", "matches_parallel", seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+}
+
+auto PointAt(const std::string &text, const size_t byte) -> TSPoint {
+  auto point = TSPoint{0, 0};
+  for (size_t i = 0; i < byte; ++i) {
+    if (text[i] == '\n') {
+      ++point.row;
+      point.column = 0;
+    } else {
+      ++point.column;
+    }
+  }
+  return point;
+}
+
+// Replaces `deleted_size` bytes of `text` at `start_byte` with `inserted`.
+auto Replace(std::string &text, const size_t start_byte,
+             const size_t deleted_size, const std::string_view inserted)
+    -> ts::InputEdit {
+  const auto start_point = PointAt(text, start_byte);
+  const auto old_end_point = PointAt(text, start_byte + deleted_size);
+  text.replace(start_byte, deleted_size, inserted);
+  const auto new_end_point = PointAt(text, start_byte + inserted.size());
+  return ts::InputEdit{TSInputEdit{
+      static_cast<uint32_t>(start_byte),
+      static_cast<uint32_t>(start_byte + deleted_size),
+      static_cast<uint32_t>(start_byte + inserted.size()), start_point,
+      old_end_point, new_end_point}};
+}
+
+enum class EditKind { kRandom, kHeader };
+
+// A random edit of `text`, parsed into `tree`. The same seed makes the same
+// edits.
+auto EditRandomly(const EditKind edit_kind, std::string &text,
+                  const ts::Tree &tree, std::mt19937 &random)
+    -> ts::InputEdit {
+  switch (edit_kind) {
+  case EditKind::kRandom: {
+    // Inserts a short text at a random byte or deletes a few bytes there.
+    static constexpr std::string_view kInsertions[] = {" ", "x", "\n", "(",
+                                                       ")", "{", "}", "0"};
+    const auto start_byte = random() % (text.size() + 1);
+    if (random() % 2 == 0 || start_byte == text.size()) {
+      return Replace(text, start_byte, 0,
+                     kInsertions[random() % std::size(kInsertions)]);
+    }
+    return Replace(text, start_byte,
+                   std::min<size_t>(random() % 3 + 1, text.size() - start_byte),
+                   "");
+  }
+  case EditKind::kHeader: {
+    // Types a space after the first token of a random top-level node, e.g.)
+    // after `fn` in a function header, where the smallest node covering the
+    // edit is a child of the root.
+    const auto root_node = tree.RootNode();
+    const auto child_count = root_node.ChildCount();
+    uint32_t start_byte = 0;
+    if (child_count > 0) {
+      auto node =
+          root_node.Child(static_cast<uint32_t>(random() % child_count));
+      while (node.ChildCount() > 0) {
+        node = node.Child(0);
+      }
+      start_byte = node.EndByte();
+    }
+    return Replace(text, start_byte, 0, " ");
+  }
+  }
+  return Replace(text, 0, 0, "");
+}
+
+// The pattern, capture id, bytes and start point of each capture of a match.
+using MatchKey = std::vector<
+    std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>>;
+
+// The matches of `index`, sorted so that two indexes with the same matches
+// give the same keys.
+auto MatchKeys(const ts::IncrementalQueryIndex &index)
+    -> std::vector<MatchKey> {
+  auto keys = std::vector<MatchKey>{};
+  keys.reserve(index.Size());
+  for (size_t i = 0; i < index.Size(); ++i) {
+    auto &key = keys.emplace_back();
+    for (const auto &capture : index.Captures(i)) {
+      const auto &range = capture.range;
+      key.emplace_back(index.PatternIndex(i), capture.index, range.start_byte,
+                       range.end_byte, range.start_point.row,
+                       range.start_point.column);
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+// Each iteration makes a random edit to each input and updates its
+// `ts::IncrementalQueryIndex`. Only the updates are timed, and the checksum is
+// the number of bytes the query is executed over again per update. After each
+// update, the index is checked against a fresh execution over the whole tree,
+// and it returns false at the first difference.
+auto MeasureIncremental(const std::string_view variant_name,
+                        const EditKind edit_kind,
+                        const ts::bench::Options &options,
+                        const ts::Query &query) -> bool {
+  auto parser = ts::Parser{};
+  parser.SetLanguage(ts::Language::FromRaw(options.language));
+  auto random = std::mt19937{0};
+
+  double seconds = 0;
+  uint64_t checksum = 0;
+  for (const auto &input : options.inputs) {
+    auto text = input;
+    auto tree = parser.ParseString(ts::Tree::Null(), text);
+    auto index = ts::IncrementalQueryIndex{query};
+    index.Reset(tree, text);
+    for (uint32_t i = 0; i < options.iterations; ++i) {
+      const auto input_edit = EditRandomly(edit_kind, text, tree, random);
+      tree.Edit(input_edit);
+      index.Edit(input_edit);
+      auto new_tree = parser.ParseString(tree.Copy(), text);
+      const auto stopwatch = ts::bench::Stopwatch{};
+      index.Update(tree, new_tree, text);
+      seconds += stopwatch.ElapsedSeconds();
+
+      auto fresh_index = ts::IncrementalQueryIndex{query};
+      fresh_index.Reset(new_tree, text);
+      if (MatchKeys(index) != MatchKeys(fresh_index)) {
+        std::cerr << "the incremental query index differs from a fresh "
+                     "execution after "
+                  << input_edit << '\n';
+        return false;
+      }
+      checksum += index.Stats().executed_bytes;
+      tree = std::move(new_tree);
+    }
+  }
+  // The latency of one update in each input.
+  ts::bench::Report("query", variant_name, seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    checksum / options.iterations);
+  return true;
+}
+
+} // namespace
+
+auto ts::bench::RunQuery(const ts::bench::Options &options) -> int {
+  uint32_t error_offset = 0;
+  auto error_type = ts::QueryError{};
+  const auto query =
+      ts::Query::New(ts::Language::FromRaw(options.language), options.query,
+                     error_offset, error_type);
+  if (query.IsNull()) {
+    std::cerr << "invalid query at offset " << error_offset << '\n';
+    return 1;
+  }
+
+  const auto trees = ts::bench::ParseInputs(options);
+  Measure("matches", Variant::kMatches, options, query, trees);
+  Measure("captures", Variant::kCaptures, options, query, trees);
+  MeasureParallel(options, query, trees);
+  if (!MeasureIncremental("incremental", EditKind::kRandom, options, query) ||
+      !MeasureIncremental("header_edit", EditKind::kHeader, options,
+                          query)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench.h"
+#include "cpp_tree_sitter/walk.h"
+
+namespace {
+
+struct Tally {
+  uint64_t nodes = 0;
+  uint64_t symbols = 0;
+
+  auto Add(const ts::Node &node) -> void {
+    ++nodes;
+    symbols += node.Symbol();
+  }
+  auto Checksum() const -> uint64_t { return nodes * 31 + symbols; }
+};
+
+// The traversal every caller wrote before `ts::TreeCursor` existed.
+auto WalkByChildIndex(const ts::Node &node, Tally &tally) -> void {
+  tally.Add(node);
+  const auto child_count = node.ChildCount();
+  for (uint32_t i = 0; i < child_count; ++i) {
+    WalkByChildIndex(node.Child(i), tally);
+  }
+}
+
+auto WalkBySibling(const ts::Node &node, Tally &tally) -> void {
+  tally.Add(node);
+  for (auto child = node.Child(0); !child.IsNull();
+       child = child.NextSibling()) {
+    WalkBySibling(child, tally);
+  }
+}
+
+template <typename WalkFn>
+auto Measure(const std::string_view variant,
+             const ts::bench::Options &options,
+             const std::vector<ts::Tree> &trees, WalkFn &&walk_fn) -> void {
+  auto tally = Tally{};
+  const auto stopwatch = ts::bench::Stopwatch{};
+  for (uint32_t i = 0; i < options.iterations; ++i) {
+    for (const auto &tree : trees) {
+      walk_fn(tree.RootNode(), tally);
+    }
+  }
+  const auto seconds = stopwatch.ElapsedSeconds();
+  ts::bench::Report("walk", variant, seconds / options.iterations,
+                    ts::bench::TotalBytes(options),
+                    tally.Checksum() / options.iterations);
+}
+
+} // namespace
+
+auto ts::bench::RunWalk(const ts::bench::Options &options) -> int {
+  const auto trees = ts::bench::ParseInputs(options);
+
+  Measure("node_child", options, trees, WalkByChildIndex);
+  Measure("node_sibling", options, trees, WalkBySibling);
+  Measure("cursor", options, trees,
+          [](const ts::Node &root, Tally &tally) {
+            ts::WalkPreOrder(root, [&tally](const ts::TreeCursor &cursor) {
+              tally.Add(cursor.CurrentNode());
+              return ts::WalkAction::kContinue;
+            });
+          });
+  return 0;
+}
@@ -0,0 +1,218 @@
+#include "alloc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+#include "tree_sitter/api.h"
+
+namespace {
+
+// Allocator
+// --------
+
+// Every block starts with its size, because `free` does not get the size but
+// `std::pmr::memory_resource::deallocate` needs it.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+std::atomic<std::pmr::memory_resource *> resource{nullptr};
+
+thread_local ts::AllocationStats thread_allocation_stats{};
+
+[[noreturn]] auto AbortAllocation(const size_t size) noexcept -> void {
+  std::fprintf(stderr, "tree-sitter failed to allocate %zu bytes", size);
+  std::abort();
+}
+
+auto Malloc(const size_t size) noexcept -> void * {
+  if (size > SIZE_MAX - kHeaderSize) {
+    AbortAllocation(size);
+  }
+  const auto block = static_cast<char *>(
+      resource.load(std::memory_order_relaxed)
+          ->allocate(size + kHeaderSize, kHeaderSize));
+  if (block == nullptr) {
+    AbortAllocation(size);
+  }
+  std::memcpy(block, &size, sizeof(size));
+  ++thread_allocation_stats.allocation_count;
+  thread_allocation_stats.allocated_bytes += size;
+  return block + kHeaderSize;
+}
+
+auto Free(void *pointer) noexcept -> void {
+  if (pointer == nullptr) {
+    return;
+  }
+  const auto block = static_cast<char *>(pointer) - kHeaderSize;
+  size_t size;
+  std::memcpy(&size, block, sizeof(size));
+  ++thread_allocation_stats.free_count;
+  thread_allocation_stats.freed_bytes += size;
+  resource.load(std::memory_order_relaxed)
+      ->deallocate(block, size + kHeaderSize, kHeaderSize);
+}
+
+auto Calloc(const size_t count, const size_t size) noexcept -> void * {
+  if (size != 0 && count > SIZE_MAX / size) {
+    AbortAllocation(SIZE_MAX);
+  }
+  const auto pointer = Malloc(count * size);
+  std::memset(pointer, 0, count * size);
+  return pointer;
+}
+
+auto Realloc(void *pointer, const size_t size) noexcept -> void * {
+  if (pointer == nullptr) {
+    return Malloc(size);
+  }
+  size_t old_size;
+  std::memcpy(&old_size, static_cast<char *>(pointer) - kHeaderSize,
+              sizeof(old_size));
+  const auto new_pointer = Malloc(size);
+  std::memcpy(new_pointer, pointer, std::min(old_size, size));
+  Free(pointer);
+  return new_pointer;
+}
+
+// PoolResource
+// --------
+
+constexpr size_t kClassSizes[] = {
+    16,  32,  48,  64,  80,  96,  112, 128, 160, 192,
+    224, 256, 320, 384, 448, 512, 640, 768, 896, 1024,
+};
+
+constexpr auto ClassIndex(const size_t bytes) noexcept -> size_t {
+  const auto size = std::max<size_t>(bytes, 1);
+  if (size <= 128) {
+    return (size + 15) / 16 - 1;
+  }
+  if (size <= 256) {
+    return 8 + (size - 128 + 31) / 32 - 1;
+  }
+  if (size <= 512) {
+    return 12 + (size - 256 + 63) / 64 - 1;
+  }
+  return 16 + (size - 512 + 127) / 128 - 1;
+}
+
+static_assert(ClassIndex(1) == 0 && ClassIndex(16) == 0 && ClassIndex(17) == 1);
+static_assert(ClassIndex(128) == 7 && ClassIndex(129) == 8);
+static_assert(ClassIndex(257) == 12 && ClassIndex(1024) == 19);
+static_assert(kClassSizes[ClassIndex(1000)] >= 1000);
+
+std::atomic<uint32_t> next_thread_slot{0};
+
+thread_local const uint32_t thread_slot =
+    next_thread_slot.fetch_add(1, std::memory_order_relaxed);
+
+} // namespace
+
+// SetAllocator
+// --------
+
+auto ts::SetAllocator(std::pmr::memory_resource *new_resource) noexcept
+    -> void {
+  resource.store(new_resource, std::memory_order_relaxed);
+  if (new_resource == nullptr) {
+    ts_set_allocator(nullptr, nullptr, nullptr, nullptr);
+    return;
+  }
+  ts_set_allocator(Malloc, Calloc, Realloc, Free);
+}
+
+// AllocationStats
+// --------
+
+auto ts::ThreadAllocationStats() noexcept -> ts::AllocationStats {
+  return thread_allocation_stats;
+}
+
+auto ts::ResetThreadAllocationStats() noexcept -> void {
+  thread_allocation_stats = ts::AllocationStats{};
+}
+
+// PoolResource
+// --------
+
+ts::PoolResource::PoolResource(std::pmr::memory_resource *upstream) noexcept
+    : upstream_{upstream}, arenas_{}, arena_mask_{0} {
+  static_assert(std::size(kClassSizes) == kClassCount);
+  static_assert(kClassSizes[kClassCount - 1] == kMaxBlockSize);
+  const auto arena_count = std::bit_ceil(
+      std::clamp(std::thread::hardware_concurrency(), 1u, 64u));
+  arenas_ = std::make_unique<ts::PoolResource::Arena[]>(arena_count);
+  arena_mask_ = arena_count - 1;
+  for (size_t i = 0; i < arena_count; ++i) {
+    std::fill(std::begin(arenas_[i].free_lists),
+              std::end(arenas_[i].free_lists), nullptr);
+    arenas_[i].slab_cursor = nullptr;
+    arenas_[i].slab_end = nullptr;
+  }
+}
+
+ts::PoolResource::~PoolResource() noexcept {
+  for (size_t i = 0; i <= arena_mask_; ++i) {
+    for (const auto slab : arenas_[i].slabs) {
+      upstream_->deallocate(slab, kSlabSize, kBlockAlignment);
+    }
+  }
+}
+
+auto ts::PoolResource::do_allocate(const size_t bytes, const size_t alignment)
+    -> void * {
+  if (bytes > kMaxBlockSize || alignment > kBlockAlignment) {
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  const auto class_index = ClassIndex(bytes);
+  auto &arena = ThreadArena();
+  auto lock = std::lock_guard{arena.mutex};
+  if (const auto block = arena.free_lists[class_index]; block != nullptr) {
+    arena.free_lists[class_index] = block->next;
+    return block;
+  }
+
+  const auto block_size = kClassSizes[class_index];
+  if (static_cast<size_t>(arena.slab_end - arena.slab_cursor) < block_size) {
+    // The rest of the current slab is abandoned.
+    const auto slab =
+        static_cast<char *>(upstream_->allocate(kSlabSize, kBlockAlignment));
+    arena.slabs.push_back(slab);
+    arena.slab_cursor = slab;
+    arena.slab_end = slab + kSlabSize;
+  }
+  const auto block = arena.slab_cursor;
+  arena.slab_cursor += block_size;
+  return block;
+}
+
+auto ts::PoolResource::do_deallocate(void *block, const size_t bytes,
+                                     const size_t alignment) -> void {
+  if (bytes > kMaxBlockSize || alignment > kBlockAlignment) {
+    upstream_->deallocate(block, bytes, alignment);
+    return;
+  }
+
+  const auto class_index = ClassIndex(bytes);
+  auto &arena = ThreadArena();
+  auto lock = std::lock_guard{arena.mutex};
+  const auto free_block = static_cast<ts::PoolResource::FreeBlock *>(block);
+  free_block->next = arena.free_lists[class_index];
+  arena.free_lists[class_index] = free_block;
+}
+
+auto ts::PoolResource::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept -> bool {
+  return this == &other;
+}
+
+auto ts::PoolResource::ThreadArena() noexcept -> ts::PoolResource::Arena & {
+  return arenas_[thread_slot & arena_mask_];
+}
@@ -0,0 +1,94 @@
+#ifndef CPP_TREE_SITTER_ALLOC_H
+#define CPP_TREE_SITTER_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace ts {
+
+// SetAllocator
+// --------
+
+// Routes every allocation of the Tree-sitter core through `resource`. If
+// `resource` is `nullptr`, the default `malloc` based allocator is restored.
+// Call it before any parser, tree or query exists, because memory allocated by
+// one allocator cannot be freed by another. `resource` must outlive every
+// object allocated through it.
+auto SetAllocator(std::pmr::memory_resource *resource) noexcept -> void;
+
+// AllocationStats
+// --------
+
+// Counted by the allocator installed with `ts::SetAllocator`, for the calling
+// thread only. A parse runs on one thread, so resetting the stats before it
+// and reading them after gives the allocations of that parse.
+struct AllocationStats {
+  uint64_t allocation_count = 0;
+  uint64_t allocated_bytes = 0;
+  uint64_t free_count = 0;
+  uint64_t freed_bytes = 0;
+};
+
+auto ThreadAllocationStats() noexcept -> ts::AllocationStats;
+auto ResetThreadAllocationStats() noexcept -> void;
+
+// PoolResource
+// --------
+
+// A size class pool for the small, short-lived allocations of the Tree-sitter
+// core, e.g. subtrees, stack nodes and small arrays. Each thread allocates
+// from one of several arenas, so parser threads rarely share a lock. Freed
+// blocks return to the arena of the freeing thread, and slabs are released
+// only when the resource is destroyed.
+// Larger or over-aligned blocks are passed to `upstream`.
+class PoolResource final : public std::pmr::memory_resource {
+public:
+  static constexpr size_t kMaxBlockSize = 1024;
+  static constexpr size_t kSlabSize = 64 * 1024;
+
+  explicit PoolResource(std::pmr::memory_resource *upstream =
+                            std::pmr::new_delete_resource()) noexcept;
+  PoolResource(const ts::PoolResource &) = delete;
+  PoolResource(ts::PoolResource &&) = delete;
+  ~PoolResource() noexcept override;
+
+  auto operator=(const ts::PoolResource &) -> ts::PoolResource & = delete;
+  auto operator=(ts::PoolResource &&) -> ts::PoolResource & = delete;
+
+private:
+  static constexpr size_t kBlockAlignment = 16;
+  // 16 bytes apart up to 128, then 32, 64 and 128 bytes apart up to 1024.
+  static constexpr size_t kClassCount = 20;
+
+  struct FreeBlock {
+    ts::PoolResource::FreeBlock *next;
+  };
+
+  struct alignas(64) Arena {
+    std::mutex mutex;
+    ts::PoolResource::FreeBlock *free_lists[ts::PoolResource::kClassCount];
+    char *slab_cursor;
+    char *slab_end;
+    std::vector<void *> slabs;
+  };
+
+  auto do_allocate(size_t bytes, size_t alignment) -> void * override;
+  auto do_deallocate(void *block, size_t bytes, size_t alignment)
+      -> void override;
+  auto do_is_equal(const std::pmr::memory_resource &other) const noexcept
+      -> bool override;
+
+  auto ThreadArena() noexcept -> ts::PoolResource::Arena &;
+
+  std::pmr::memory_resource *upstream_;
+  std::unique_ptr<ts::PoolResource::Arena[]> arenas_;
+  size_t arena_mask_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_ALLOC_H
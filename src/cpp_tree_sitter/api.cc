@@ -1,10 +1,23 @@
 #include "api.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <ctime>
 #include <iostream>
+#include <mutex>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "input.h"
+#include "names.h"
+#include "printer.h"
 
 using namespace ts;
 
+static_assert(std::ranges::forward_range<ts::ChangedRanges>);
+
 // CStringDeleter
 // --------
 
@@ -12,7 +25,8 @@ void ts::CStringDeleter::operator()(char *c_string_raw) const noexcept {
   if (c_string_raw == nullptr) {
     return;
   }
-  free(c_string_raw);
+  // Freed with the allocator set by `ts::SetAllocator`.
+  ts_free_buffer(c_string_raw);
 }
 
 // String
@@ -50,6 +64,90 @@ auto ts::operator<<(std::ostream &os, const ts::Point &point)
   return os;
 }
 
+// Range
+// --------
+
+ts::Range::Range(const TSRange &ts_range) noexcept
+    : TSRange{ts_range.start_point, ts_range.end_point, ts_range.start_byte,
+              ts_range.end_byte} {}
+
+auto ts::Range::AsRaw() noexcept -> TSRange & { return *this; }
+
+auto ts::operator<<(std::ostream &os, const ts::Range &range)
+    -> std::ostream & {
+  os << "Range{";
+  os << "start_point=" << ts::Point{range.start_point};
+  os << ", ";
+  os << "end_point=" << ts::Point{range.end_point};
+  os << ", ";
+  os << "start_byte=" << range.start_byte;
+  os << ", ";
+  os << "end_byte=" << range.end_byte;
+  os << "}";
+  return os;
+}
+
+// InputEdit
+// --------
+
+ts::InputEdit::InputEdit(const TSInputEdit &ts_input_edit) noexcept
+    : TSInputEdit{ts_input_edit} {}
+
+auto ts::InputEdit::AsRaw() noexcept -> TSInputEdit & { return *this; }
+
+auto ts::InputEdit::EditByte(const uint32_t byte) const noexcept -> uint32_t {
+  if (byte >= old_end_byte) {
+    return byte - old_end_byte + new_end_byte;
+  }
+  if (byte > start_byte) {
+    return new_end_byte;
+  }
+  return byte;
+}
+
+auto ts::InputEdit::EditPoint(const TSPoint point,
+                              const uint32_t byte) const noexcept -> TSPoint {
+  if (byte >= old_end_byte) {
+    return TSPoint{point.row - old_end_point.row + new_end_point.row,
+                   point.row == old_end_point.row
+                       ? point.column - old_end_point.column +
+                             new_end_point.column
+                       : point.column};
+  }
+  if (byte > start_byte) {
+    return new_end_point;
+  }
+  return point;
+}
+
+auto ts::InputEdit::EditByteRanges(
+    std::vector<std::pair<uint32_t, uint32_t>> &byte_ranges) const noexcept
+    -> void {
+  for (auto &[range_start_byte, range_end_byte] : byte_ranges) {
+    range_start_byte = EditByte(range_start_byte);
+    range_end_byte = EditByte(range_end_byte);
+  }
+  byte_ranges.emplace_back(start_byte, new_end_byte);
+}
+
+auto ts::operator<<(std::ostream &os, const ts::InputEdit &input_edit)
+    -> std::ostream & {
+  os << "InputEdit{";
+  os << "start_byte=" << input_edit.start_byte;
+  os << ", ";
+  os << "old_end_byte=" << input_edit.old_end_byte;
+  os << ", ";
+  os << "new_end_byte=" << input_edit.new_end_byte;
+  os << ", ";
+  os << "start_point=" << ts::Point{input_edit.start_point};
+  os << ", ";
+  os << "old_end_point=" << ts::Point{input_edit.old_end_point};
+  os << ", ";
+  os << "new_end_point=" << ts::Point{input_edit.new_end_point};
+  os << "}";
+  return os;
+}
+
 // Node
 // --------
 
@@ -89,6 +187,10 @@ auto ts::Node::GrammarType() const noexcept -> std::string_view {
   return std::string_view{grammar_type != nullptr ? grammar_type : ""};
 }
 
+auto ts::Node::Language() const noexcept -> ts::Language {
+  return ts::Language{ts_node_language(ts_node_)};
+}
+
 auto ts::Node::String() const noexcept -> ts::String {
   return ts::String{ts::CStringPtr{ts_node_string(ts_node_)}};
 }
@@ -226,8 +328,14 @@ auto ts::Node::NamedDescendantForPointRange(const ts::Point start,
       ts_node_named_descendant_for_point_range(ts_node_, start, end)};
 }
 
+auto ts::Node::Edit(const ts::InputEdit &input_edit) noexcept -> void {
+  ts_node_edit(&ts_node_, &input_edit);
+}
+
 auto ts::Node::AsRaw() noexcept -> TSNode & { return ts_node_; }
 
+auto ts::Node::AsRaw() const noexcept -> const TSNode & { return ts_node_; }
+
 auto ts::operator<<(std::ostream &os, const ts::Node &node) -> std::ostream & {
   os << "Node{";
   os << "start_byte=" << node.StartByte();
@@ -276,11 +384,65 @@ void ts::TSTreeDeleter::operator()(TSTree *ts_tree_raw) const noexcept {
   ts_tree_delete(ts_tree_raw);
 }
 
+// TSRangesDeleter
+// --------
+
+void ts::TSRangesDeleter::operator()(TSRange *ts_ranges_raw) const noexcept {
+  ts_free_buffer(ts_ranges_raw);
+}
+
+// ChangedRanges
+// --------
+
+ts::ChangedRanges::Iterator::Iterator(const TSRange *ts_range) noexcept
+    : ts_range_{ts_range} {}
+
+auto ts::ChangedRanges::Iterator::operator*() const noexcept -> ts::Range {
+  return ts::Range{*ts_range_};
+}
+
+auto ts::ChangedRanges::Iterator::operator++() noexcept -> Iterator & {
+  ++ts_range_;
+  return *this;
+}
+
+auto ts::ChangedRanges::Iterator::operator++(int) noexcept -> Iterator {
+  auto previous = *this;
+  ++ts_range_;
+  return previous;
+}
+
+ts::ChangedRanges::ChangedRanges(ts::TSRangesPtr &&ts_ranges,
+                                 const uint32_t size) noexcept
+    : ts_ranges_{std::move(ts_ranges)}, size_{size} {}
+
+auto ts::ChangedRanges::begin() const noexcept -> Iterator {
+  return Iterator{ts_ranges_.get()};
+}
+
+auto ts::ChangedRanges::end() const noexcept -> Iterator {
+  return Iterator{ts_ranges_.get() + size_};
+}
+
+auto ts::ChangedRanges::size() const noexcept -> uint32_t { return size_; }
+
+auto ts::ChangedRanges::empty() const noexcept -> bool { return size_ == 0; }
+
+auto ts::ChangedRanges::operator[](const uint32_t index) const noexcept
+    -> ts::Range {
+  assert(index < size_ && "ChangedRanges::operator[]: index out of range");
+  return ts::Range{ts_ranges_.get()[index]};
+}
+
 // Tree
 // --------
 
 ts::Tree::Tree(ts::TSTreePtr &&ts_tree) noexcept
-    : ts_tree_{std::move(ts_tree)} {}
+    : ts_tree_{std::move(ts_tree)}, source_{nullptr} {}
+
+ts::Tree::Tree(ts::TSTreePtr &&ts_tree,
+               std::shared_ptr<const ts::MappedFile> &&source) noexcept
+    : ts_tree_{std::move(ts_tree)}, source_{std::move(source)} {}
 
 auto ts::Tree::IsNull() const noexcept -> bool {
   return ts_tree_.get() == nullptr;
@@ -300,51 +462,61 @@ auto ts::Tree::PrintDotGraph(const int file_descriptor) const noexcept -> void {
   ts_tree_print_dot_graph(ts_tree_.get(), file_descriptor);
 }
 
-auto printRec(std::ostream &os, const ts::Node &parent_node,
-              const uint32_t current_index, const uint32_t level) -> void {
-  for (uint32_t i = 0; i < level; ++i) {
-    os << "  ";
-  }
-  const auto field_name = parent_node.FieldNameForChild(current_index);
-  os << "Child{";
-  os << "index=";
-  os << current_index;
-  os << ", ";
-  if (!field_name.empty()) {
-    os << "field_name=";
-    os << field_name;
-    os << ", ";
-  }
-  os << "node=";
-  const auto current_node = parent_node.Child(current_index);
-  os << current_node << "}\n";
-  const auto child_count = current_node.ChildCount();
-  for (uint32_t i = 0; i < child_count; ++i) {
-    printRec(os, current_node, i, level + 1);
-  }
-};
+auto ts::Tree::Copy() const noexcept -> ts::Tree {
+  assert(!IsNull() && "Tree::Copy: tree is null");
+  return ts::Tree{ts::TSTreePtr{ts_tree_copy(ts_tree_.get())},
+                  std::shared_ptr<const ts::MappedFile>{source_}};
+}
 
-auto ts::operator<<(std::ostream &os, const ts::Tree &tree) -> std::ostream & {
-  os << "Tree{";
-  if (tree.IsNull()) {
-    os << "null";
-    os << "}";
-    return os;
-  }
+auto ts::Tree::Edit(const ts::InputEdit &input_edit) noexcept -> void {
+  assert(!IsNull() && "Tree::Edit: tree is null");
+  ts_tree_edit(ts_tree_.get(), &input_edit);
+}
+
+auto ts::Tree::ChangedRanges(const ts::Tree &new_tree) const noexcept
+    -> ts::ChangedRanges {
+  assert(!IsNull() && "Tree::ChangedRanges: tree is null");
+  assert(!new_tree.IsNull() && "Tree::ChangedRanges: new_tree is null");
+  uint32_t size = 0;
+  const auto ts_ranges = ts_tree_get_changed_ranges(
+      ts_tree_.get(), new_tree.ts_tree_.get(), &size);
+  return ts::ChangedRanges{ts::TSRangesPtr{ts_ranges}, size};
+}
 
-  os << "root_node=";
-  const auto root_node = tree.RootNode();
-  os << root_node << "}";
-  const auto child_count = root_node.ChildCount();
-  if (child_count == 0) {
-    return os;
+auto ts::Tree::IncludedRanges() const noexcept -> std::vector<ts::Range> {
+  assert(!IsNull() && "Tree::IncludedRanges: tree is null");
+  uint32_t count = 0;
+  const auto ts_ranges =
+      ts::TSRangesPtr{ts_tree_included_ranges(ts_tree_.get(), &count)};
+  auto ranges = std::vector<ts::Range>{};
+  ranges.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    ranges.emplace_back(ts_ranges.get()[i]);
   }
+  return ranges;
+}
 
-  os << '\n';
-  for (uint32_t i = 0; i < child_count; ++i) {
-    printRec(os, root_node, i, 1);
+auto ts::Tree::Source() const noexcept -> std::string_view {
+  assert(!IsNull() && "Tree::Source: tree is null");
+  if (source_.get() == nullptr) {
+    return std::string_view{};
   }
+  return source_->Text();
+}
+
+auto ts::Tree::Text(const ts::Node &node) const noexcept -> std::string_view {
+  const auto source = Source();
+  const auto start_byte = std::min<size_t>(node.StartByte(), source.size());
+  const auto end_byte = std::min<size_t>(node.EndByte(), source.size());
+  return source.substr(start_byte, end_byte - start_byte);
+}
 
+auto ts::operator<<(std::ostream &os, const ts::Tree &tree) -> std::ostream & {
+  auto printer = ts::TreePrinter{ts::PrintOptions{
+      ts::PrintFormat::kVerbose, ts::PrintField::kAll, false}};
+  printer.Print(tree);
+  const auto buffer = printer.Buffer();
+  os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
   return os;
 }
 
@@ -352,6 +524,140 @@ auto ts::Tree::Null() noexcept -> ts::Tree {
   return ts::Tree{ts::TSTreePtr{nullptr}};
 }
 
+// TreeCursor
+// --------
+
+auto NullTsTreeCursor() noexcept -> TSTreeCursor {
+  return TSTreeCursor{nullptr, nullptr, {0, 0}};
+}
+
+ts::TreeCursor::TreeCursor(const ts::Node &node) noexcept
+    : ts_tree_cursor_{ts_tree_cursor_new(node.AsRaw())} {}
+
+ts::TreeCursor::TreeCursor(TSTreeCursor &&ts_tree_cursor) noexcept
+    : ts_tree_cursor_{std::move(ts_tree_cursor)} {}
+
+ts::TreeCursor::TreeCursor(ts::TreeCursor &&other) noexcept
+    : ts_tree_cursor_{
+          std::exchange(other.ts_tree_cursor_, NullTsTreeCursor())} {}
+
+ts::TreeCursor::~TreeCursor() noexcept {
+  if (IsNull()) {
+    return;
+  }
+  ts_tree_cursor_delete(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::operator=(ts::TreeCursor &&other) noexcept
+    -> ts::TreeCursor & {
+  if (this == &other) {
+    return *this;
+  }
+  if (!IsNull()) {
+    ts_tree_cursor_delete(&ts_tree_cursor_);
+  }
+  ts_tree_cursor_ = std::exchange(other.ts_tree_cursor_, NullTsTreeCursor());
+  return *this;
+}
+
+auto ts::TreeCursor::Reset(const ts::Node &node) noexcept -> void {
+  assert(!IsNull() && "TreeCursor::Reset: cursor is null");
+  ts_tree_cursor_reset(&ts_tree_cursor_, node.AsRaw());
+}
+
+auto ts::TreeCursor::ResetTo(const ts::TreeCursor &other) noexcept -> void {
+  assert(!IsNull() && "TreeCursor::ResetTo: cursor is null");
+  assert(!other.IsNull() && "TreeCursor::ResetTo: other cursor is null");
+  ts_tree_cursor_reset_to(&ts_tree_cursor_, &other.ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::CurrentNode() const noexcept -> ts::Node {
+  assert(!IsNull() && "TreeCursor::CurrentNode: cursor is null");
+  return ts::Node{ts_tree_cursor_current_node(&ts_tree_cursor_)};
+}
+
+auto ts::TreeCursor::CurrentFieldName() const noexcept -> std::string_view {
+  assert(!IsNull() && "TreeCursor::CurrentFieldName: cursor is null");
+  const auto field_name = ts_tree_cursor_current_field_name(&ts_tree_cursor_);
+  return std::string_view{field_name != nullptr ? field_name : ""};
+}
+
+auto ts::TreeCursor::CurrentFieldId() const noexcept -> ts::FieldId {
+  assert(!IsNull() && "TreeCursor::CurrentFieldId: cursor is null");
+  return ts_tree_cursor_current_field_id(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::CurrentDescendantIndex() const noexcept -> uint32_t {
+  assert(!IsNull() && "TreeCursor::CurrentDescendantIndex: cursor is null");
+  return ts_tree_cursor_current_descendant_index(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::CurrentDepth() const noexcept -> uint32_t {
+  assert(!IsNull() && "TreeCursor::CurrentDepth: cursor is null");
+  return ts_tree_cursor_current_depth(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::GotoParent() noexcept -> bool {
+  assert(!IsNull() && "TreeCursor::GotoParent: cursor is null");
+  return ts_tree_cursor_goto_parent(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::GotoNextSibling() noexcept -> bool {
+  assert(!IsNull() && "TreeCursor::GotoNextSibling: cursor is null");
+  return ts_tree_cursor_goto_next_sibling(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::GotoPreviousSibling() noexcept -> bool {
+  assert(!IsNull() && "TreeCursor::GotoPreviousSibling: cursor is null");
+  return ts_tree_cursor_goto_previous_sibling(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::GotoFirstChild() noexcept -> bool {
+  assert(!IsNull() && "TreeCursor::GotoFirstChild: cursor is null");
+  return ts_tree_cursor_goto_first_child(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::GotoLastChild() noexcept -> bool {
+  assert(!IsNull() && "TreeCursor::GotoLastChild: cursor is null");
+  return ts_tree_cursor_goto_last_child(&ts_tree_cursor_);
+}
+
+auto ts::TreeCursor::GotoDescendant(
+    const uint32_t goal_descendant_index) noexcept -> void {
+  assert(!IsNull() && "TreeCursor::GotoDescendant: cursor is null");
+  ts_tree_cursor_goto_descendant(&ts_tree_cursor_, goal_descendant_index);
+}
+
+auto ts::TreeCursor::GotoFirstChildForByte(const uint32_t goal_byte) noexcept
+    -> int64_t {
+  assert(!IsNull() && "TreeCursor::GotoFirstChildForByte: cursor is null");
+  return ts_tree_cursor_goto_first_child_for_byte(&ts_tree_cursor_, goal_byte);
+}
+
+auto ts::TreeCursor::GotoFirstChildForPoint(const ts::Point goal_point) noexcept
+    -> int64_t {
+  assert(!IsNull() && "TreeCursor::GotoFirstChildForPoint: cursor is null");
+  return ts_tree_cursor_goto_first_child_for_point(&ts_tree_cursor_,
+                                                   goal_point);
+}
+
+auto ts::TreeCursor::Copy() const noexcept -> ts::TreeCursor {
+  assert(!IsNull() && "TreeCursor::Copy: cursor is null");
+  return ts::TreeCursor{ts_tree_cursor_copy(&ts_tree_cursor_)};
+}
+
+auto ts::TreeCursor::IsNull() const noexcept -> bool {
+  return ts_tree_cursor_.tree == nullptr;
+}
+
+auto ts::TreeCursor::AsRaw() noexcept -> TSTreeCursor & {
+  return ts_tree_cursor_;
+}
+
+auto ts::TreeCursor::AsRaw() const noexcept -> const TSTreeCursor & {
+  return ts_tree_cursor_;
+}
+
 // Logger
 // --------
 
@@ -415,8 +721,7 @@ auto ts::Language::SymbolName(const ts::Symbol symbol) const noexcept
 auto ts::Language::SymbolForName(const std::string_view name,
                                  const bool is_named) const noexcept
     -> ts::Symbol {
-  return ts_language_symbol_for_name(ts_language_, name.data(), name.size(),
-                                     is_named);
+  return ts::NameIndex::For(ts_language_).SymbolForName(name, is_named);
 }
 
 auto ts::Language::FieldCount() const noexcept -> uint32_t {
@@ -431,7 +736,7 @@ auto ts::Language::FieldNameForId(const ts::FieldId field_id) const noexcept
 
 auto ts::Language::FieldIdForName(const std::string_view name) const noexcept
     -> ts::FieldId {
-  return ts_language_field_id_for_name(ts_language_, name.data(), name.size());
+  return ts::NameIndex::For(ts_language_).FieldIdForName(name);
 }
 
 auto ts::Language::SymbolType(const ts::Symbol symbol) const noexcept
@@ -458,6 +763,263 @@ auto ts::Language::FromRaw(const TSLanguage *const ts_language) noexcept
   return ts::Language{ts_language};
 }
 
+// Input
+// --------
+
+auto ts::Input::Encoding() const noexcept -> ts::InputEncoding {
+  return ts_input_.encoding;
+}
+
+auto ts::Input::AsRaw() const noexcept -> const TSInput & { return ts_input_; }
+
+// CancellationToken
+// --------
+
+class ts::CancellationToken::State {
+public:
+  explicit State(const Clock::time_point deadline) noexcept
+      : flag_{0}, deadline_{deadline}, mutex_{}, children_{} {}
+
+  auto Cancel() noexcept -> void {
+    if (std::atomic_ref{flag_}.exchange(1, std::memory_order_acq_rel) != 0) {
+      return;
+    }
+    auto children = std::vector<std::weak_ptr<State>>{};
+    {
+      auto lock = std::lock_guard{mutex_};
+      children.swap(children_);
+    }
+    for (const auto &child : children) {
+      if (const auto child_state = child.lock(); child_state != nullptr) {
+        child_state->Cancel();
+      }
+    }
+  }
+
+  auto AddChild(const std::shared_ptr<State> &child) noexcept -> void {
+    auto lock = std::lock_guard{mutex_};
+    // `Cancel` sets the flag before taking the lock, so a child added after
+    // that is cancelled here instead.
+    if (IsFlagSet()) {
+      std::atomic_ref{child->flag_}.store(1, std::memory_order_release);
+      return;
+    }
+    if (children_.size() == children_.capacity()) {
+      std::erase_if(children_, [](const std::weak_ptr<State> &child) {
+        return child.expired();
+      });
+    }
+    children_.push_back(child);
+  }
+
+  auto IsFlagSet() const noexcept -> bool {
+    return std::atomic_ref{const_cast<size_t &>(flag_)}.load(
+               std::memory_order_acquire) != 0;
+  }
+
+  auto Flag() const noexcept -> const size_t * { return &flag_; }
+  auto Deadline() const noexcept -> Clock::time_point { return deadline_; }
+
+private:
+  alignas(std::atomic_ref<size_t>::required_alignment) size_t flag_;
+  const Clock::time_point deadline_;
+  std::mutex mutex_;
+  std::vector<std::weak_ptr<State>> children_;
+};
+
+ts::CancellationToken::CancellationToken() noexcept
+    : CancellationToken{kNoDeadline} {}
+
+ts::CancellationToken::CancellationToken(
+    const Clock::time_point deadline) noexcept
+    : state_{std::make_shared<State>(deadline)} {}
+
+ts::CancellationToken::CancellationToken(
+    std::shared_ptr<State> &&state) noexcept
+    : state_{std::move(state)} {}
+
+auto ts::CancellationToken::Child(
+    const Clock::time_point deadline) const noexcept -> ts::CancellationToken {
+  assert(!IsNull() && "CancellationToken::Child: token is null");
+  auto child = std::make_shared<State>(std::min(deadline, state_->Deadline()));
+  state_->AddChild(child);
+  return ts::CancellationToken{std::move(child)};
+}
+
+auto ts::CancellationToken::Cancel() const noexcept -> void {
+  assert(!IsNull() && "CancellationToken::Cancel: token is null");
+  state_->Cancel();
+}
+
+auto ts::CancellationToken::IsCancelled() const noexcept -> bool {
+  assert(!IsNull() && "CancellationToken::IsCancelled: token is null");
+  return state_->IsFlagSet() || (state_->Deadline() != kNoDeadline &&
+                                 Clock::now() >= state_->Deadline());
+}
+
+auto ts::CancellationToken::Deadline() const noexcept -> Clock::time_point {
+  assert(!IsNull() && "CancellationToken::Deadline: token is null");
+  return state_->Deadline();
+}
+
+auto ts::CancellationToken::IsNull() const noexcept -> bool {
+  return state_ == nullptr;
+}
+
+auto ts::CancellationToken::AsRaw() const noexcept -> const size_t * {
+  assert(!IsNull() && "CancellationToken::AsRaw: token is null");
+  return state_->Flag();
+}
+
+auto ts::CancellationToken::Null() noexcept -> ts::CancellationToken {
+  return ts::CancellationToken{std::shared_ptr<State>{nullptr}};
+}
+
+namespace {
+
+// Tree-sitter has no deadline, so the timeout of the parser is shortened to
+// the time left until the deadline of its token during a parse. A parse
+// stopped by the token, by its flag or by its deadline, is not resumable: the
+// token is marked cancelled and the parser is reset, so the next parse starts
+// over.
+class DeadlineScope {
+public:
+  explicit DeadlineScope(TSParser *ts_parser,
+                         const ts::CancellationToken &token) noexcept
+      : ts_parser_{ts_parser}, token_{token},
+        timeout_micros_{ts_parser_timeout_micros(ts_parser)},
+        has_deadline_{!token.IsNull() &&
+                      token.Deadline() != ts::CancellationToken::kNoDeadline} {
+    if (!has_deadline_) {
+      return;
+    }
+    const auto now = ts::CancellationToken::Clock::now();
+    if (now >= token.Deadline()) {
+      token.Cancel();
+      return;
+    }
+    const auto remaining_micros = static_cast<uint64_t>(
+        std::chrono::ceil<std::chrono::microseconds>(token.Deadline() - now)
+            .count());
+    ts_parser_set_timeout_micros(
+        ts_parser_, timeout_micros_ == ts::Parser::kNoTimeout
+                        ? remaining_micros
+                        : std::min(timeout_micros_, remaining_micros));
+  }
+  DeadlineScope(const DeadlineScope &) = delete;
+  DeadlineScope(DeadlineScope &&) = delete;
+  ~DeadlineScope() noexcept {
+    if (has_deadline_) {
+      ts_parser_set_timeout_micros(ts_parser_, timeout_micros_);
+    }
+    if (!token_.IsNull() && token_.IsCancelled()) {
+      token_.Cancel();
+      ts_parser_reset(ts_parser_);
+    }
+  }
+
+  auto operator=(const DeadlineScope &) -> DeadlineScope & = delete;
+  auto operator=(DeadlineScope &&) -> DeadlineScope & = delete;
+
+private:
+  TSParser *ts_parser_;
+  const ts::CancellationToken &token_;
+  uint64_t timeout_micros_;
+  bool has_deadline_;
+};
+
+auto ThreadCpuTime() noexcept -> std::chrono::nanoseconds {
+  auto time = timespec{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds{time.tv_sec} +
+         std::chrono::nanoseconds{time.tv_nsec};
+}
+
+// Fills `parse_stats`, if it is not null, when a parse call returns.
+class ParseStatsScope {
+public:
+  explicit ParseStatsScope(const TSParser *ts_parser,
+                           ts::ParseStats *parse_stats) noexcept
+      : ts_parser_{ts_parser}, parse_stats_{parse_stats},
+        start_{std::chrono::steady_clock::now()},
+        cpu_start_{parse_stats != nullptr ? ThreadCpuTime()
+                                          : std::chrono::nanoseconds{0}} {}
+  ParseStatsScope(const ParseStatsScope &) = delete;
+  ParseStatsScope(ParseStatsScope &&) = delete;
+  ~ParseStatsScope() noexcept {
+    if (parse_stats_ == nullptr) {
+      return;
+    }
+    const auto &counters = *ts_parser_parse_stats(ts_parser_);
+    parse_stats_->wall_time = std::chrono::steady_clock::now() - start_;
+    parse_stats_->cpu_time = ThreadCpuTime() - cpu_start_;
+    parse_stats_->lexed_bytes = counters.lexed_bytes;
+    parse_stats_->reused_bytes = counters.reused_bytes;
+    parse_stats_->consumed_bytes = counters.consumed_bytes;
+    parse_stats_->token_count = counters.token_count;
+    parse_stats_->node_count = counters.node_count;
+    parse_stats_->reused_subtree_count = counters.reused_subtree_count;
+    parse_stats_->error_recovery_count = counters.error_recovery_count;
+    parse_stats_->max_version_count = counters.max_version_count;
+    parse_stats_->error_cost = counters.error_cost;
+    parse_stats_->did_time_out = counters.did_time_out;
+    parse_stats_->was_cancelled = counters.was_cancelled;
+  }
+
+  auto operator=(const ParseStatsScope &) -> ParseStatsScope & = delete;
+  auto operator=(ParseStatsScope &&) -> ParseStatsScope & = delete;
+
+private:
+  const TSParser *ts_parser_;
+  ts::ParseStats *parse_stats_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::nanoseconds cpu_start_;
+};
+
+} // namespace
+
+// ParseStats
+// --------
+
+auto ts::ParseStats::ReuseRatio() const noexcept -> double {
+  const auto total_bytes = lexed_bytes + reused_bytes;
+  return total_bytes != 0 ? static_cast<double>(reused_bytes) /
+                                static_cast<double>(total_bytes)
+                          : 0.0;
+}
+
+auto ts::operator<<(std::ostream &os, const ts::ParseStats &parse_stats)
+    -> std::ostream & {
+  os << "ParseStats{";
+  os << "wall_time_ns=" << parse_stats.wall_time.count();
+  os << ", ";
+  os << "cpu_time_ns=" << parse_stats.cpu_time.count();
+  os << ", ";
+  os << "lexed_bytes=" << parse_stats.lexed_bytes;
+  os << ", ";
+  os << "reused_bytes=" << parse_stats.reused_bytes;
+  os << ", ";
+  os << "consumed_bytes=" << parse_stats.consumed_bytes;
+  os << ", ";
+  os << "token_count=" << parse_stats.token_count;
+  os << ", ";
+  os << "node_count=" << parse_stats.node_count;
+  os << ", ";
+  os << "reused_subtree_count=" << parse_stats.reused_subtree_count;
+  os << ", ";
+  os << "error_recovery_count=" << parse_stats.error_recovery_count;
+  os << ", ";
+  os << "max_version_count=" << parse_stats.max_version_count;
+  os << ", ";
+  os << "error_cost=" << parse_stats.error_cost;
+  os << ", ";
+  os << "did_time_out=" << parse_stats.did_time_out;
+  os << ", ";
+  os << "was_cancelled=" << parse_stats.was_cancelled;
+  os << "}";
+  return os;
+}
+
 // TSParserDeleter
 // --------
 
@@ -469,7 +1031,10 @@ void ts::TSParserDeleter::operator()(TSParser *ts_parser_raw) const noexcept {
 // Parser
 // --------
 
-ts::Parser::Parser() noexcept : ts_parser_{ts_parser_new()} {}
+ts::Parser::Parser() noexcept
+    : ts_parser_{ts_parser_new()},
+      cancellation_token_{ts::CancellationToken::Null()}, logger_{nullptr},
+      parse_stats_{nullptr} {}
 
 auto ts::Parser::Language() const noexcept -> ts::Language {
   assert(!IsNull() && "Parser::Language: parser is null");
@@ -485,6 +1050,10 @@ auto ts::Parser::ParseString(ts::Tree &&old_tree,
                              const std::string_view string) const noexcept
     -> ts::Tree {
   assert(!IsNull() && "Parser::ParseString: parser is null");
+  const auto deadline_scope =
+      DeadlineScope{ts_parser_.get(), cancellation_token_};
+  const auto parse_stats_scope =
+      ParseStatsScope{ts_parser_.get(), parse_stats_.get()};
   const auto old_tree_raw = old_tree.IntoRaw();
   const auto new_tree = ts_parser_parse_string(
       ts_parser_.get(), old_tree_raw.get(), string.data(), string.size());
@@ -495,6 +1064,10 @@ auto ts::Parser::ParseStringEncoding(
     ts::Tree &&old_tree, const std::string_view string,
     const ts::InputEncoding encoding) const noexcept -> ts::Tree {
   assert(!IsNull() && "Parser::ParseStringEncoding: parser is null");
+  const auto deadline_scope =
+      DeadlineScope{ts_parser_.get(), cancellation_token_};
+  const auto parse_stats_scope =
+      ParseStatsScope{ts_parser_.get(), parse_stats_.get()};
   const auto old_tree_raw = old_tree.IntoRaw();
   const auto new_tree =
       ts_parser_parse_string_encoding(ts_parser_.get(), old_tree_raw.get(),
@@ -502,6 +1075,80 @@ auto ts::Parser::ParseStringEncoding(
   return Tree{TSTreePtr{new_tree}};
 }
 
+auto ts::Parser::ParseInput(ts::Tree &&old_tree,
+                            const ts::Input &input) const noexcept
+    -> ts::Tree {
+  assert(!IsNull() && "Parser::ParseInput: parser is null");
+  const auto deadline_scope =
+      DeadlineScope{ts_parser_.get(), cancellation_token_};
+  const auto parse_stats_scope =
+      ParseStatsScope{ts_parser_.get(), parse_stats_.get()};
+  const auto old_tree_raw = old_tree.IntoRaw();
+  const auto new_tree =
+      ts_parser_parse(ts_parser_.get(), old_tree_raw.get(), input.AsRaw());
+  return ts::Tree{ts::TSTreePtr{new_tree}};
+}
+
+auto ts::Parser::ParseFile(ts::Tree &&old_tree,
+                           const std::string &path) const noexcept
+    -> ts::Tree {
+  assert(!IsNull() && "Parser::ParseFile: parser is null");
+  auto mapped_file = ts::MappedFile::Open(path);
+  if (mapped_file.IsNull()) {
+    return ts::Tree::Null();
+  }
+  auto source =
+      std::make_shared<const ts::MappedFile>(std::move(mapped_file));
+  const auto deadline_scope =
+      DeadlineScope{ts_parser_.get(), cancellation_token_};
+  const auto parse_stats_scope =
+      ParseStatsScope{ts_parser_.get(), parse_stats_.get()};
+  const auto old_tree_raw = old_tree.IntoRaw();
+  // The lexer reads the file once from the start, but the tree keeps it for
+  // the random reads of `ts::Tree::Text` after the parse.
+  source->Advise(ts::MappedFile::Access::kSequential);
+  const auto new_tree =
+      ts_parser_parse(ts_parser_.get(), old_tree_raw.get(),
+                      ts::Input{*source}.AsRaw());
+  source->Advise(ts::MappedFile::Access::kNormal);
+  if (new_tree == nullptr) {
+    return ts::Tree::Null();
+  }
+  return ts::Tree{ts::TSTreePtr{new_tree}, std::move(source)};
+}
+
+auto ts::Parser::SetIncludedRanges(
+    const std::span<const ts::Range> ranges) const noexcept -> bool {
+  assert(!IsNull() && "Parser::SetIncludedRanges: parser is null");
+  const auto ts_ranges = std::vector<TSRange>{ranges.begin(), ranges.end()};
+  return ts_parser_set_included_ranges(ts_parser_.get(), ts_ranges.data(),
+                                       static_cast<uint32_t>(ts_ranges.size()));
+}
+
+auto ts::Parser::IncludedRanges() const noexcept -> std::vector<ts::Range> {
+  assert(!IsNull() && "Parser::IncludedRanges: parser is null");
+  uint32_t count = 0;
+  const auto ts_ranges = ts_parser_included_ranges(ts_parser_.get(), &count);
+  auto ranges = std::vector<ts::Range>{};
+  ranges.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    ranges.emplace_back(ts_ranges[i]);
+  }
+  return ranges;
+}
+
+auto ts::Parser::ParseIncrementally(ts::Tree &&old_tree,
+                                    const std::string_view string)
+    const noexcept -> ts::ParseTask {
+  assert(!IsNull() && "Parser::ParseIncrementally: parser is null");
+  return ts::ParseTask{*this, std::move(old_tree), string};
+}
+
+auto ts::Parser::Reset() const noexcept -> void {
+  assert(!IsNull() && "Parser::Reset: parser is null");
+  ts_parser_reset(ts_parser_.get());
+}
+
 auto ts::Parser::SetTimeoutMicros(const uint64_t timeout_micros) const noexcept
     -> void {
   assert(!IsNull() && "Parser::SetTimeoutMicros: parser is null");
@@ -515,28 +1162,42 @@ auto ts::Parser::TimeoutMicros() const noexcept -> uint64_t {
 
 auto ts::Parser::EnableCancellation() noexcept -> void {
   assert(!IsNull() && "Parser::EnableCancellation: parser is null");
-  if (cancellation_flag_.get() != nullptr) {
+  if (!cancellation_token_.IsNull()) {
     return;
   }
-  cancellation_flag_ = std::make_unique<size_t>(0);
-  ts_parser_set_cancellation_flag(ts_parser_.get(), cancellation_flag_.get());
+  SetCancellationToken(ts::CancellationToken{});
 }
 
 auto ts::Parser::Cancel() noexcept -> void {
   assert(!IsNull() && "Parser::Cancel: parser is null");
-  assert(cancellation_flag_.get() != nullptr &&
-         "Parser::Cancel: cancellation_flag is null. Please enable "
+  assert(!cancellation_token_.IsNull() &&
+         "Parser::Cancel: cancellation_token is null. Please enable "
          "cancellation before canceling.");
-  *cancellation_flag_ = 1;
+  cancellation_token_.Cancel();
 }
 
 auto ts::Parser::DisableCancellation() noexcept -> void {
   assert(!IsNull() && "Parser::DisableCancellation: parser is null");
-  if (cancellation_flag_.get() == nullptr) {
+  if (cancellation_token_.IsNull()) {
     return;
   }
   ts_parser_set_cancellation_flag(ts_parser_.get(), nullptr);
-  cancellation_flag_.reset();
+  cancellation_token_ = ts::CancellationToken::Null();
+}
+
+auto ts::Parser::SetCancellationToken(
+    const ts::CancellationToken &token) noexcept -> void {
+  assert(!IsNull() && "Parser::SetCancellationToken: parser is null");
+  assert(!token.IsNull() && "Parser::SetCancellationToken: token is null");
+  cancellation_token_ = token;
+  ts_parser_set_cancellation_flag(ts_parser_.get(),
+                                  cancellation_token_.AsRaw());
+}
+
+auto ts::Parser::AccessCancellationToken() const noexcept
+    -> const ts::CancellationToken & {
+  assert(!IsNull() && "Parser::AccessCancellationToken: parser is null");
+  return cancellation_token_;
 }
 
 auto ts::Parser::SetLogger(ts::LoggerPtr &&logger) noexcept -> void {
@@ -571,6 +1232,126 @@ auto ts::Parser::PrintDotGraphs(const int file_descriptor) const noexcept
   ts_parser_print_dot_graphs(ts_parser_.get(), file_descriptor);
 }
 
+auto ts::Parser::EnableParseStats() noexcept -> void {
+  assert(!IsNull() && "Parser::EnableParseStats: parser is null");
+  if (parse_stats_ != nullptr) {
+    return;
+  }
+  parse_stats_ = std::make_unique<ts::ParseStats>();
+}
+
+auto ts::Parser::DisableParseStats() noexcept -> void {
+  assert(!IsNull() && "Parser::DisableParseStats: parser is null");
+  parse_stats_.reset();
+}
+
+auto ts::Parser::AccessParseStats() const noexcept -> const ts::ParseStats & {
+  assert(!IsNull() && "Parser::AccessParseStats: parser is null");
+  assert(parse_stats_ != nullptr &&
+         "Parser::AccessParseStats: parse_stats is null. Please enable parse "
+         "stats before accessing them.");
+  return *parse_stats_;
+}
+
 auto ts::Parser::IsNull() const noexcept -> bool {
   return ts_parser_.get() == nullptr;
 }
+
+// ParseTask
+// --------
+
+ts::ParseTask::ParseTask(const ts::Parser &parser, ts::Tree &&old_tree,
+                         const std::string_view string) noexcept
+    : parser_{&parser}, old_tree_{std::move(old_tree)}, string_{string},
+      tree_{ts::Tree::Null()}, consumed_bytes_{0}, has_started_{false},
+      is_done_{false}, was_cancelled_{false} {}
+
+ts::ParseTask::ParseTask(ts::ParseTask &&other) noexcept
+    : parser_{std::exchange(other.parser_, nullptr)},
+      old_tree_{std::move(other.old_tree_)}, string_{other.string_},
+      tree_{std::move(other.tree_)}, consumed_bytes_{other.consumed_bytes_},
+      has_started_{other.has_started_}, is_done_{other.is_done_},
+      was_cancelled_{other.was_cancelled_} {}
+
+ts::ParseTask::~ParseTask() noexcept {
+  if (parser_ != nullptr && has_started_ && !is_done_) {
+    parser_->Reset();
+  }
+}
+
+auto ts::ParseTask::operator=(ts::ParseTask &&other) noexcept
+    -> ts::ParseTask & {
+  if (this != &other) {
+    if (parser_ != nullptr && has_started_ && !is_done_) {
+      parser_->Reset();
+    }
+    parser_ = std::exchange(other.parser_, nullptr);
+    old_tree_ = std::move(other.old_tree_);
+    string_ = other.string_;
+    tree_ = std::move(other.tree_);
+    consumed_bytes_ = other.consumed_bytes_;
+    has_started_ = other.has_started_;
+    is_done_ = other.is_done_;
+    was_cancelled_ = other.was_cancelled_;
+  }
+  return *this;
+}
+
+auto ts::ParseTask::Step(const std::chrono::microseconds slice) noexcept
+    -> ts::ParseProgress {
+  assert(parser_ != nullptr && "ParseTask::Step: task is moved");
+  if (is_done_) {
+    return Progress();
+  }
+
+  const auto ts_parser = parser_->ts_parser_.get();
+  const auto timeout_micros = ts_parser_timeout_micros(ts_parser);
+  // `kNoTimeout` would run the whole parse in one slice.
+  ts_parser_set_timeout_micros(
+      ts_parser, std::max<uint64_t>(static_cast<uint64_t>(slice.count()), 1));
+  has_started_ = true;
+  auto new_tree = static_cast<TSTree *>(nullptr);
+  {
+    const auto deadline_scope =
+        DeadlineScope{ts_parser, parser_->cancellation_token_};
+    const auto parse_stats_scope =
+        ParseStatsScope{ts_parser, parser_->parse_stats_.get()};
+    // The parser keeps the old tree from the first slice on.
+    const auto old_tree_raw = old_tree_.IsNull() ? ts::TSTreePtr{nullptr}
+                                                 : old_tree_.IntoRaw();
+    new_tree = ts_parser_parse_string(ts_parser, old_tree_raw.get(),
+                                      string_.data(), string_.size());
+  }
+  ts_parser_set_timeout_micros(ts_parser, timeout_micros);
+
+  const auto &counters = *ts_parser_parse_stats(ts_parser);
+  consumed_bytes_ = counters.consumed_bytes;
+  if (new_tree != nullptr) {
+    tree_ = ts::Tree{ts::TSTreePtr{new_tree}};
+    is_done_ = true;
+  } else if (counters.was_cancelled ||
+             (!parser_->cancellation_token_.IsNull() &&
+              parser_->cancellation_token_.IsCancelled())) {
+    // `DeadlineScope` has reset the parser.
+    is_done_ = true;
+    was_cancelled_ = true;
+  }
+  return Progress();
+}
+
+auto ts::ParseTask::Progress() const noexcept -> ts::ParseProgress {
+  return ts::ParseProgress{is_done_ && !was_cancelled_ ? string_.size()
+                                                       : consumed_bytes_,
+                           string_.size(), is_done_};
+}
+
+auto ts::ParseTask::IsDone() const noexcept -> bool { return is_done_; }
+
+auto ts::ParseTask::WasCancelled() const noexcept -> bool {
+  return was_cancelled_;
+}
+
+auto ts::ParseTask::TakeTree() noexcept -> ts::Tree {
+  assert(is_done_ && "ParseTask::TakeTree: task is not done");
+  return std::move(tree_);
+}
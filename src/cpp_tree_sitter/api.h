@@ -1,14 +1,26 @@
 #ifndef CPP_TREE_SITTER_API_H
 #define CPP_TREE_SITTER_API_H
 
+#include <chrono>
+#include <concepts>
+#include <iterator>
 #include <memory>
 #include <ostream>
+#include <span>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "tree_sitter/api.h"
 
 namespace ts {
 
+class Language;
+class MappedFile;
+class ParseTask;
+
 using Symbol = TSSymbol;
 using SymbolType = TSSymbolType;
 using StateId = TSStateId;
@@ -63,6 +75,57 @@ struct Point : public TSPoint {
 
 auto operator<<(std::ostream &os, const ts::Point &point) -> std::ostream &;
 
+// Range
+// --------
+
+struct Range : public TSRange {
+  explicit Range(const TSRange &ts_range) noexcept;
+  Range(const ts::Range &) noexcept = default;
+  Range(ts::Range &&) noexcept = default;
+  ~Range() noexcept = default;
+
+  auto operator=(const ts::Range &) noexcept -> ts::Range & = default;
+  auto operator=(ts::Range &&) noexcept -> ts::Range & = default;
+
+  auto AsRaw() noexcept -> TSRange &;
+};
+
+auto operator<<(std::ostream &os, const ts::Range &range) -> std::ostream &;
+
+// InputEdit
+// --------
+
+// e.g.) Replacing `old` with `new` at `start`:
+// `{start_byte, start_byte + old.size(), start_byte + new.size(),
+//   start_point, old_end_point, new_end_point}`
+struct InputEdit : public TSInputEdit {
+  explicit InputEdit(const TSInputEdit &ts_input_edit) noexcept;
+  InputEdit(const ts::InputEdit &) noexcept = default;
+  InputEdit(ts::InputEdit &&) noexcept = default;
+  ~InputEdit() noexcept = default;
+
+  auto operator=(const ts::InputEdit &) noexcept -> ts::InputEdit & = default;
+  auto operator=(ts::InputEdit &&) noexcept -> ts::InputEdit & = default;
+
+  auto AsRaw() noexcept -> TSInputEdit &;
+
+  // Moves a byte of the source before the edit to the edited source. A byte
+  // inside the replaced text moves to its end.
+  auto EditByte(const uint32_t byte) const noexcept -> uint32_t;
+  // Same as `EditByte`, for the point of `byte`.
+  auto EditPoint(const TSPoint point, const uint32_t byte) const noexcept
+      -> TSPoint;
+  // Moves the `[start_byte, end_byte)` ranges of `byte_ranges` to the edited
+  // source and appends the bytes inserted by the edit, so that they keep the
+  // bytes changed by a series of edits.
+  auto EditByteRanges(
+      std::vector<std::pair<uint32_t, uint32_t>> &byte_ranges) const noexcept
+      -> void;
+};
+
+auto operator<<(std::ostream &os, const ts::InputEdit &input_edit)
+    -> std::ostream &;
+
 // Node
 // --------
 
@@ -84,6 +147,7 @@ public:
   auto Type() const noexcept -> std::string_view;
   auto GrammarSymbol() const noexcept -> ts::Symbol;
   auto GrammarType() const noexcept -> std::string_view;
+  auto Language() const noexcept -> ts::Language;
   [[nodiscard]] auto String() const noexcept -> ts::String;
   auto Eq(const ts::Node &other) const noexcept -> bool;
   auto IsNull() const noexcept -> bool;
@@ -123,7 +187,12 @@ public:
                                     const ts::Point end) const noexcept
       -> ts::Node;
 
+  // Adjusts a node taken from a tree before `ts::Tree::Edit`, so its position
+  // matches the edited tree.
+  auto Edit(const ts::InputEdit &input_edit) noexcept -> void;
+
   auto AsRaw() noexcept -> TSNode &;
+  auto AsRaw() const noexcept -> const TSNode &;
 
 private:
   TSNode ts_node_;
@@ -141,12 +210,71 @@ public:
 
 using TSTreePtr = std::unique_ptr<TSTree, ts::TSTreeDeleter>;
 
+// TSRangesDeleter
+// --------
+
+class TSRangesDeleter {
+public:
+  void operator()(TSRange *ts_ranges_raw) const noexcept;
+};
+
+using TSRangesPtr = std::unique_ptr<TSRange, ts::TSRangesDeleter>;
+
+// ChangedRanges
+// --------
+
+// The ranges whose syntactic structure changed between two trees, in order.
+// It owns the array returned by `ts_tree_get_changed_ranges`.
+class ChangedRanges {
+public:
+  class Iterator {
+  public:
+    using iterator_concept = std::forward_iterator_tag;
+    using value_type = ts::Range;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() noexcept = default;
+    explicit Iterator(const TSRange *ts_range) noexcept;
+
+    auto operator*() const noexcept -> ts::Range;
+    auto operator++() noexcept -> Iterator &;
+    auto operator++(int) noexcept -> Iterator;
+    auto operator==(const Iterator &other) const noexcept -> bool = default;
+
+  private:
+    const TSRange *ts_range_ = nullptr;
+  };
+
+  explicit ChangedRanges(ts::TSRangesPtr &&ts_ranges,
+                         const uint32_t size) noexcept;
+  ChangedRanges(const ts::ChangedRanges &) = delete;
+  ChangedRanges(ts::ChangedRanges &&) noexcept = default;
+  ~ChangedRanges() noexcept = default;
+
+  auto operator=(const ts::ChangedRanges &) -> ts::ChangedRanges & = delete;
+  auto operator=(ts::ChangedRanges &&) noexcept
+      -> ts::ChangedRanges & = default;
+
+  auto begin() const noexcept -> Iterator;
+  auto end() const noexcept -> Iterator;
+  auto size() const noexcept -> uint32_t;
+  auto empty() const noexcept -> bool;
+  auto operator[](const uint32_t index) const noexcept -> ts::Range;
+
+private:
+  ts::TSRangesPtr ts_ranges_;
+  uint32_t size_;
+};
+
 // Tree
 // --------
 
 class Tree {
 public:
   explicit Tree(ts::TSTreePtr &&ts_tree) noexcept;
+  // The tree shares the ownership of the mapped file it was parsed from.
+  explicit Tree(ts::TSTreePtr &&ts_tree,
+                std::shared_ptr<const ts::MappedFile> &&source) noexcept;
   Tree(const ts::Tree &) = delete;
   Tree(ts::Tree &&) noexcept = default;
   ~Tree() noexcept = default;
@@ -157,6 +285,27 @@ public:
   auto RootNode() const noexcept -> ts::Node;
   auto PrintDotGraph(const int file_descriptor) const noexcept -> void;
 
+  // A shallow copy that shares the subtrees of the tree, so it is cheap. Use it
+  // to keep the old tree when passing it to `ts::Parser::ParseString`.
+  [[nodiscard]] auto Copy() const noexcept -> ts::Tree;
+  // Records an edit of the source, so that the next parse with this tree as
+  // the old tree reuses the unchanged subtrees. The source held by the tree is
+  // not edited.
+  auto Edit(const ts::InputEdit &input_edit) noexcept -> void;
+  // `this` is the edited old tree, and `new_tree` is the tree reparsed from
+  // it.
+  auto ChangedRanges(const ts::Tree &new_tree) const noexcept
+      -> ts::ChangedRanges;
+
+  // The ranges that the tree was parsed from, as moved by `Edit`. See
+  // `ts::Parser::SetIncludedRanges`.
+  auto IncludedRanges() const noexcept -> std::vector<ts::Range>;
+
+  // If the tree was not parsed by `ts::Parser::ParseFile`, they return an
+  // empty string.
+  auto Source() const noexcept -> std::string_view;
+  auto Text(const ts::Node &node) const noexcept -> std::string_view;
+
   auto IsNull() const noexcept -> bool;
 
   // Consumes the `TSTreePtr` and returns a unique pointer to it.
@@ -166,10 +315,65 @@ public:
 
 private:
   ts::TSTreePtr ts_tree_;
+  std::shared_ptr<const ts::MappedFile> source_;
 };
 
 auto operator<<(std::ostream &os, const ts::Tree &tree) -> std::ostream &;
 
+// TreeCursor
+// --------
+
+// Unlike `ts::Node::Child` and `ts::Node::NextSibling`, which re-walk the
+// parent's children on every call, a cursor keeps its path from the root, so
+// moving to a neighbouring node is O(1) amortized.
+class TreeCursor {
+public:
+  explicit TreeCursor(const ts::Node &node) noexcept;
+  TreeCursor(const ts::TreeCursor &) = delete;
+  TreeCursor(ts::TreeCursor &&other) noexcept;
+  ~TreeCursor() noexcept;
+
+  auto operator=(const ts::TreeCursor &) -> ts::TreeCursor & = delete;
+  auto operator=(ts::TreeCursor &&other) noexcept -> ts::TreeCursor &;
+
+  // Moves the cursor to `node` and makes it the new root of the cursor.
+  auto Reset(const ts::Node &node) noexcept -> void;
+  // Unlike `Reset`, this keeps the parent information of `other`.
+  auto ResetTo(const ts::TreeCursor &other) noexcept -> void;
+
+  auto CurrentNode() const noexcept -> ts::Node;
+  auto CurrentFieldName() const noexcept -> std::string_view;
+  auto CurrentFieldId() const noexcept -> ts::FieldId;
+  auto CurrentDescendantIndex() const noexcept -> uint32_t;
+  // The depth is relative to the node the cursor was created or reset with.
+  auto CurrentDepth() const noexcept -> uint32_t;
+
+  auto GotoParent() noexcept -> bool;
+  auto GotoNextSibling() noexcept -> bool;
+  auto GotoPreviousSibling() noexcept -> bool;
+  auto GotoFirstChild() noexcept -> bool;
+  auto GotoLastChild() noexcept -> bool;
+  auto GotoDescendant(const uint32_t goal_descendant_index) noexcept -> void;
+
+  static constexpr int64_t kChildNotFound = -1;
+  // If no child extends beyond the goal, it returns `kChildNotFound`.
+  // Otherwise, it returns the index of the child the cursor moved to.
+  auto GotoFirstChildForByte(const uint32_t goal_byte) noexcept -> int64_t;
+  auto GotoFirstChildForPoint(const ts::Point goal_point) noexcept -> int64_t;
+
+  [[nodiscard]] auto Copy() const noexcept -> ts::TreeCursor;
+
+  auto IsNull() const noexcept -> bool;
+
+  auto AsRaw() noexcept -> TSTreeCursor &;
+  auto AsRaw() const noexcept -> const TSTreeCursor &;
+
+private:
+  explicit TreeCursor(TSTreeCursor &&ts_tree_cursor) noexcept;
+
+  TSTreeCursor ts_tree_cursor_;
+};
+
 // Logger
 // --------
 
@@ -233,6 +437,8 @@ public:
   static constexpr ts::Symbol kSymbolNotFound = 0;
 
   // If symbol is not found, it returns `kSymbolNotFound`.
+  // Names are looked up in a hash table built once per language. See
+  // `ts::NameIndex`.
   auto SymbolForName(const std::string_view name,
                      const bool is_named) const noexcept -> ts::Symbol;
 
@@ -255,6 +461,149 @@ private:
   const TSLanguage *ts_language_;
 };
 
+// Input
+// --------
+
+// A reader returns the text starting at `byte_index`. The text may be shorter
+// than the rest of the document, and it must stay valid until the next read.
+// An empty text means the end of the document.
+template <typename Reader>
+concept InputReader = requires(Reader &reader, const uint32_t byte_index,
+                               const ts::Point &position) {
+  { reader.Read(byte_index, position) } -> std::same_as<std::string_view>;
+};
+
+template <typename Function>
+concept InputReadFunction =
+    std::is_invocable_r_v<std::string_view, Function &, uint32_t,
+                          const ts::Point &>;
+
+// A borrowed reader or read function that `ts::Parser::ParseInput` pulls the
+// text from in chunks, so the document does not need to be contiguous in
+// memory. The reader must outlive the parse, so it cannot be a temporary,
+// e.g.) a lambda written in the constructor call.
+class Input {
+public:
+  template <typename Reader>
+    requires ts::InputReader<Reader> || ts::InputReadFunction<Reader>
+  explicit Input(
+      Reader &reader,
+      const ts::InputEncoding encoding = TSInputEncodingUTF8) noexcept
+      : ts_input_{const_cast<void *>(static_cast<const void *>(&reader)),
+                  Read<Reader>, encoding} {}
+  template <typename Reader>
+    requires(!std::is_lvalue_reference_v<Reader>)
+  explicit Input(
+      Reader &&reader,
+      const ts::InputEncoding encoding = TSInputEncodingUTF8) = delete;
+  Input(const ts::Input &) noexcept = default;
+  Input(ts::Input &&) noexcept = default;
+  ~Input() noexcept = default;
+
+  auto operator=(const ts::Input &) noexcept -> ts::Input & = default;
+  auto operator=(ts::Input &&) noexcept -> ts::Input & = default;
+
+  auto Encoding() const noexcept -> ts::InputEncoding;
+
+  auto AsRaw() const noexcept -> const TSInput &;
+
+private:
+  template <typename Reader>
+  static auto Read(void *payload, uint32_t byte_index, TSPoint position,
+                   uint32_t *bytes_read) noexcept -> const char * {
+    auto &reader = *static_cast<Reader *>(payload);
+    const auto point = ts::Point{position};
+    std::string_view text;
+    if constexpr (ts::InputReader<Reader>) {
+      text = reader.Read(byte_index, point);
+    } else {
+      text = reader(byte_index, point);
+    }
+    *bytes_read = static_cast<uint32_t>(text.size());
+    return text.data();
+  }
+
+  TSInput ts_input_;
+};
+
+// CancellationToken
+// --------
+
+// A shared, thread-safe cancellation flag with an optional deadline. Copies
+// share the same flag, so one token can be attached to many parsers and query
+// cursors. Cancelling a token also cancels its children, but not its parent.
+class CancellationToken {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr auto kNoDeadline = Clock::time_point::max();
+
+  explicit CancellationToken() noexcept;
+  explicit CancellationToken(const Clock::time_point deadline) noexcept;
+  CancellationToken(const ts::CancellationToken &) noexcept = default;
+  CancellationToken(ts::CancellationToken &&) noexcept = default;
+  ~CancellationToken() noexcept = default;
+
+  auto operator=(const ts::CancellationToken &) noexcept
+      -> ts::CancellationToken & = default;
+  auto operator=(ts::CancellationToken &&) noexcept
+      -> ts::CancellationToken & = default;
+
+  // The deadline of a child is the earlier of `deadline` and its parent's.
+  [[nodiscard]] auto
+  Child(const Clock::time_point deadline = kNoDeadline) const noexcept
+      -> ts::CancellationToken;
+
+  auto Cancel() const noexcept -> void;
+  // It is also cancelled once its deadline has passed.
+  auto IsCancelled() const noexcept -> bool;
+  auto Deadline() const noexcept -> Clock::time_point;
+
+  auto IsNull() const noexcept -> bool;
+  // The flag read by `ts_parser_set_cancellation_flag`.
+  auto AsRaw() const noexcept -> const size_t *;
+
+  static auto Null() noexcept -> ts::CancellationToken;
+
+private:
+  class State;
+
+  explicit CancellationToken(std::shared_ptr<State> &&state) noexcept;
+
+  std::shared_ptr<State> state_;
+};
+
+// ParseStats
+// --------
+
+// Filled after each parse by a parser with `ts::Parser::EnableParseStats`.
+// The counters come from the parse loop of the Tree-sitter core, see
+// `TSParseStats`. The times are of the last call, while the counters of a
+// parse resumed after a timeout or a cancellation include the earlier calls.
+struct ParseStats {
+  std::chrono::nanoseconds wall_time{0};
+  // The CPU time of the parsing thread.
+  std::chrono::nanoseconds cpu_time{0};
+  uint64_t lexed_bytes = 0;
+  uint64_t reused_bytes = 0;
+  // How far the parse got, e.g.) before a timeout.
+  uint64_t consumed_bytes = 0;
+  uint32_t token_count = 0;
+  uint32_t node_count = 0;
+  uint32_t reused_subtree_count = 0;
+  uint32_t error_recovery_count = 0;
+  uint32_t max_version_count = 0;
+  uint32_t error_cost = 0;
+  bool did_time_out = false;
+  bool was_cancelled = false;
+
+  // The share of the document reused from the old tree, from 0 to 1.
+  auto ReuseRatio() const noexcept -> double;
+};
+
+auto operator<<(std::ostream &os, const ts::ParseStats &parse_stats)
+    -> std::ostream &;
+
 // TSParserDeleter
 // --------
 
@@ -266,8 +615,6 @@ public:
 
 using TSParserPtr = std::unique_ptr<TSParser, ts::TSParserDeleter>;
 
-using CancellationFlagPtr = std::unique_ptr<size_t>;
-
 // Parser
 // --------
 
@@ -290,6 +637,33 @@ public:
   ParseStringEncoding(ts::Tree &&old_tree, const std::string_view string,
                       const ts::InputEncoding encoding) const noexcept
       -> ts::Tree;
+  [[nodiscard]] auto ParseInput(ts::Tree &&old_tree,
+                                const ts::Input &input) const noexcept
+      -> ts::Tree;
+  // Parses a memory-mapped file without copying it. The returned tree keeps
+  // the mapping alive, see `ts::Tree::Text`. If the file cannot be mapped, it
+  // returns a null tree.
+  [[nodiscard]] auto ParseFile(ts::Tree &&old_tree,
+                               const std::string &path) const noexcept
+      -> ts::Tree;
+
+  // The following parses only read the text in `ranges`, which must be in
+  // order and must not overlap. If they are invalid, it returns `false` and
+  // the ranges are unchanged. An empty `ranges` includes the whole document.
+  auto SetIncludedRanges(const std::span<const ts::Range> ranges) const noexcept
+      -> bool;
+  auto IncludedRanges() const noexcept -> std::vector<ts::Range>;
+
+  // Returns a task that parses `string` in time slices, see `ts::ParseTask`.
+  // Until the task is done or destroyed, the parser must not run other parses,
+  // which would resume it. The parser and `string` must outlive the task.
+  [[nodiscard]] auto ParseIncrementally(ts::Tree &&old_tree,
+                                        const std::string_view string)
+      const noexcept -> ts::ParseTask;
+
+  // Discards the state of a parse that was stopped by a timeout or a
+  // cancellation. Otherwise, the next parse resumes it.
+  auto Reset() const noexcept -> void;
 
   static constexpr uint64_t kNoTimeout = 0;
   // If the `timeout_micros` is set to `kNoTimeout`, the timeout will be
@@ -301,6 +675,19 @@ public:
   auto Cancel() noexcept -> void;
   auto DisableCancellation() noexcept -> void;
 
+  // Replaces the token created by `EnableCancellation`. A parse stops when the
+  // token is cancelled or its deadline passes, and it returns a null tree.
+  // The parser is then reset, so a stopped parse cannot be resumed.
+  auto SetCancellationToken(const ts::CancellationToken &token) noexcept
+      -> void;
+  auto AccessCancellationToken() const noexcept
+      -> const ts::CancellationToken &;
+
+  // Once enabled, each parse fills the stats returned by `AccessParseStats`.
+  auto EnableParseStats() noexcept -> void;
+  auto DisableParseStats() noexcept -> void;
+  auto AccessParseStats() const noexcept -> const ts::ParseStats &;
+
   auto SetLogger(ts::LoggerPtr &&logger) noexcept -> void;
   auto AccessLogger() const noexcept -> const ts::LoggerPtr &;
   [[nodiscard]] auto TakeLogger() noexcept -> ts::LoggerPtr;
@@ -313,9 +700,73 @@ public:
   auto IsNull() const noexcept -> bool;
 
 private:
+  friend class ParseTask;
+
   ts::TSParserPtr ts_parser_;
-  ts::CancellationFlagPtr cancellation_flag_;
+  ts::CancellationToken cancellation_token_;
   ts::LoggerPtr logger_;
+  std::unique_ptr<ts::ParseStats> parse_stats_;
+};
+
+// ParseTask
+// --------
+
+struct ParseProgress {
+  // How far the parse got, see `ts::ParseStats::consumed_bytes`.
+  uint64_t consumed_bytes = 0;
+  uint64_t total_bytes = 0;
+  bool is_done = false;
+};
+
+// A parse that runs in slices of a time budget, so a large document can be
+// parsed between other work on the same thread. Between slices, the parser
+// keeps its state and the next slice resumes it. The slices are checked every
+// 100 parse operations, so a slice may overrun its budget slightly.
+//
+//   auto task = parser.ParseIncrementally(ts::Tree::Null(), source);
+//   while (!task.Step(std::chrono::milliseconds{2}).is_done) {
+//     HandleEvents();
+//   }
+//   auto tree = task.TakeTree();
+//
+// If the cancellation token of the parser is cancelled or its deadline passes,
+// the task is done with a null tree.
+class ParseTask {
+public:
+  ParseTask(const ts::ParseTask &) = delete;
+  ParseTask(ts::ParseTask &&other) noexcept;
+  // Discards the state of an unfinished parse, see `ts::Parser::Reset`.
+  ~ParseTask() noexcept;
+
+  auto operator=(const ts::ParseTask &) -> ts::ParseTask & = delete;
+  auto operator=(ts::ParseTask &&other) noexcept -> ts::ParseTask &;
+
+  // Parses for about `slice` and returns the progress so far.
+  auto Step(const std::chrono::microseconds slice) noexcept
+      -> ts::ParseProgress;
+  auto Progress() const noexcept -> ts::ParseProgress;
+  auto IsDone() const noexcept -> bool;
+  // Whether the task was done by a cancellation rather than a finished tree.
+  auto WasCancelled() const noexcept -> bool;
+  // The tree, once the task is done. It can be taken once.
+  [[nodiscard]] auto TakeTree() noexcept -> ts::Tree;
+
+private:
+  friend class Parser;
+
+  explicit ParseTask(const ts::Parser &parser, ts::Tree &&old_tree,
+                     const std::string_view string) noexcept;
+
+  const ts::Parser *parser_;
+  ts::Tree old_tree_;
+  std::string_view string_;
+  ts::Tree tree_;
+  uint64_t consumed_bytes_;
+  // Whether a slice has run, so the parser may hold an unfinished parse even
+  // if no bytes are consumed yet.
+  bool has_started_;
+  bool is_done_;
+  bool was_cancelled_;
 };
 
 } // namespace ts
@@ -0,0 +1,218 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+// BatchParser::Batch
+// --------
+
+// The state of one `ParseAll` or `ParseFiles` call.
+class ts::BatchParser::Batch {
+public:
+  explicit Batch(const ts::BatchCallback &callback, const size_t size,
+                 const bool is_ordered) noexcept
+      : callback_{callback}, is_ordered_{is_ordered}, remaining_{size},
+        next_index_{0}, trees_{}, is_finished_{} {
+    if (is_ordered_) {
+      trees_.reserve(size);
+      for (size_t i = 0; i < size; ++i) {
+        trees_.push_back(ts::Tree::Null());
+      }
+      is_finished_.assign(size, false);
+    }
+  }
+
+  auto Finish(const size_t index, ts::Tree &&tree) noexcept -> void {
+    if (!is_ordered_) {
+      callback_(index, std::move(tree));
+      Done(1);
+      return;
+    }
+
+    auto lock = std::unique_lock{mutex_};
+    trees_[index] = std::move(tree);
+    is_finished_[index] = true;
+    // The thread that finishes the next tree delivers it and the finished
+    // trees after it. Holding the lock keeps the callbacks in order.
+    size_t delivered = 0;
+    while (next_index_ < trees_.size() && is_finished_[next_index_]) {
+      callback_(next_index_, std::move(trees_[next_index_]));
+      ++next_index_;
+      ++delivered;
+    }
+    lock.unlock();
+    Done(delivered);
+  }
+
+  auto Wait() noexcept -> void {
+    auto lock = std::unique_lock{remaining_mutex_};
+    done_.wait(lock, [this] { return remaining_ == 0; });
+  }
+
+private:
+  auto Done(const size_t count) noexcept -> void {
+    if (count == 0) {
+      return;
+    }
+    auto lock = std::lock_guard{remaining_mutex_};
+    remaining_ -= count;
+    if (remaining_ == 0) {
+      done_.notify_all();
+    }
+  }
+
+  const ts::BatchCallback &callback_;
+  const bool is_ordered_;
+  std::mutex remaining_mutex_;
+  std::condition_variable done_;
+  size_t remaining_;
+  std::mutex mutex_;
+  size_t next_index_;
+  std::vector<ts::Tree> trees_;
+  std::vector<bool> is_finished_;
+};
+
+// BatchParser
+// --------
+
+ts::BatchParser::BatchParser(const ts::BatchOptions &options) noexcept
+    : timeout_micros_{options.timeout_micros},
+      pool_{options.queue_capacity != 0
+                ? options.queue_capacity
+                : size_t{4} *
+                      ts::WorkerPool<ts::BatchParser::Job>::ResolveThreadCount(
+                          options.thread_count)} {
+  pool_.Start(options.thread_count, [this] { RunWorker(); });
+}
+
+ts::BatchParser::~BatchParser() noexcept { pool_.Stop(); }
+
+auto ts::BatchParser::Parse(const ts::Language &language,
+                            const std::string_view source,
+                            const ts::CancellationToken &token) noexcept
+    -> std::future<ts::Tree> {
+  auto promise = std::promise<ts::Tree>{};
+  auto future = promise.get_future();
+  pool_.Push(Job{language.AsRaw(), source, std::string{},
+                 std::move(promise), nullptr, 0, token});
+  return future;
+}
+
+auto ts::BatchParser::Parse(const ts::Language &language,
+                            const std::string_view source,
+                            ts::Tree &&old_tree,
+                            std::vector<ts::Range> included_ranges,
+                            const ts::CancellationToken &token) noexcept
+    -> std::future<ts::Tree> {
+  auto promise = std::promise<ts::Tree>{};
+  auto future = promise.get_future();
+  pool_.Push(Job{language.AsRaw(), source, std::string{},
+                 std::move(promise), nullptr, 0, token, std::move(old_tree),
+                 std::move(included_ranges)});
+  return future;
+}
+
+auto ts::BatchParser::ParseFile(const ts::Language &language,
+                                std::string path,
+                                const ts::CancellationToken &token) noexcept
+    -> std::future<ts::Tree> {
+  auto promise = std::promise<ts::Tree>{};
+  auto future = promise.get_future();
+  pool_.Push(Job{language.AsRaw(), std::string_view{}, std::move(path),
+                 std::move(promise), nullptr, 0, token});
+  return future;
+}
+
+auto ts::BatchParser::ParseAll(const ts::Language &language,
+                               const std::span<const std::string_view> sources,
+                               const ts::BatchCallback &callback,
+                               const bool is_ordered,
+                               const ts::CancellationToken &token) noexcept
+    -> void {
+  auto batch = Batch{callback, sources.size(), is_ordered};
+  for (size_t i = 0; i < sources.size(); ++i) {
+    pool_.Push(Job{language.AsRaw(), sources[i], std::string{},
+                   std::promise<ts::Tree>{}, &batch, i, token});
+  }
+  batch.Wait();
+}
+
+auto ts::BatchParser::ParseFiles(const ts::Language &language,
+                                 const std::span<const std::string> paths,
+                                 const ts::BatchCallback &callback,
+                                 const bool is_ordered,
+                                 const ts::CancellationToken &token) noexcept
+    -> void {
+  auto batch = Batch{callback, paths.size(), is_ordered};
+  for (size_t i = 0; i < paths.size(); ++i) {
+    pool_.Push(Job{language.AsRaw(), std::string_view{}, paths[i],
+                   std::promise<ts::Tree>{}, &batch, i, token});
+  }
+  batch.Wait();
+}
+
+auto ts::BatchParser::ThreadCount() const noexcept -> uint32_t {
+  return pool_.ThreadCount();
+}
+
+auto ts::BatchParser::ParseJob(const ts::Parser &parser,
+                               ts::BatchParser::Job &job) noexcept
+    -> ts::Tree {
+  if (!job.included_ranges.empty() &&
+      !parser.SetIncludedRanges(job.included_ranges)) {
+    return ts::Tree::Null();
+  }
+  auto tree = job.path.empty()
+                  ? parser.ParseString(std::move(job.old_tree), job.source)
+                  : parser.ParseFile(std::move(job.old_tree), job.path);
+  if (tree.IsNull()) {
+    parser.Reset();
+  }
+  if (!job.included_ranges.empty()) {
+    parser.SetIncludedRanges({});
+  }
+  return tree;
+}
+
+auto ts::BatchParser::RunWorker() noexcept -> void {
+  struct LanguageParser {
+    const TSLanguage *ts_language;
+    ts::Parser parser;
+  };
+  // Few languages are used at once, so a linear search is enough.
+  auto parsers = std::vector<LanguageParser>{};
+
+  while (auto popped_job = pool_.Pop()) {
+    auto &job = *popped_job;
+    auto it = std::find_if(parsers.begin(), parsers.end(),
+                           [&job](const LanguageParser &language_parser) {
+                             return language_parser.ts_language ==
+                                    job.ts_language;
+                           });
+    if (it == parsers.end()) {
+      auto parser = ts::Parser{};
+      parser.SetLanguage(ts::Language::FromRaw(job.ts_language));
+      parser.SetTimeoutMicros(timeout_micros_);
+      parsers.push_back(LanguageParser{job.ts_language, std::move(parser)});
+      it = std::prev(parsers.end());
+    }
+
+    auto tree = ts::Tree::Null();
+    if (job.token.IsNull()) {
+      tree = ParseJob(it->parser, job);
+    } else if (!job.token.IsCancelled()) {
+      it->parser.SetCancellationToken(job.token);
+      tree = ParseJob(it->parser, job);
+      it->parser.DisableCancellation();
+    }
+
+    if (job.batch != nullptr) {
+      job.batch->Finish(job.index, std::move(tree));
+    } else {
+      job.promise.set_value(std::move(tree));
+    }
+  }
+}
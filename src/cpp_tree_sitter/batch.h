@@ -0,0 +1,118 @@
+#ifndef CPP_TREE_SITTER_BATCH_H
+#define CPP_TREE_SITTER_BATCH_H
+
+#include <functional>
+#include <future>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+#include "pool.h"
+
+namespace ts {
+
+// BatchOptions
+// --------
+
+struct BatchOptions {
+  // If it is 0, `std::thread::hardware_concurrency` threads are used.
+  uint32_t thread_count = 0;
+  // Submitting blocks while this many jobs are queued, so a producer cannot
+  // run ahead of the workers. If it is 0, 4 jobs per thread are queued.
+  uint32_t queue_capacity = 0;
+  // A parse that takes longer results in a null tree.
+  uint64_t timeout_micros = ts::Parser::kNoTimeout;
+};
+
+// Called with the index of the source or path and its tree. If the parse timed
+// out or the file could not be read, the tree is null.
+using BatchCallback = std::function<void(size_t index, ts::Tree &&tree)>;
+
+// BatchParser
+// --------
+
+// Parses many documents on a pool of threads. Each thread keeps one
+// `ts::Parser` per language for its lifetime, so parsers and their internal
+// buffers are reused across documents.
+class BatchParser {
+public:
+  explicit BatchParser(const ts::BatchOptions &options) noexcept;
+  BatchParser(const ts::BatchParser &) = delete;
+  BatchParser(ts::BatchParser &&) = delete;
+  // Finishes the queued jobs and joins the threads.
+  ~BatchParser() noexcept;
+
+  auto operator=(const ts::BatchParser &) -> ts::BatchParser & = delete;
+  auto operator=(ts::BatchParser &&) -> ts::BatchParser & = delete;
+
+  // The source is borrowed until the future is ready.
+  // If `token` is cancelled or its deadline passes, the jobs that have not
+  // finished yet result in null trees.
+  [[nodiscard]] auto
+  Parse(const ts::Language &language, const std::string_view source,
+        const ts::CancellationToken &token =
+            ts::CancellationToken::Null()) noexcept -> std::future<ts::Tree>;
+  // Parses only `included_ranges` of `source`, reusing `old_tree`, which must
+  // have been edited to match `source`. See `ts::Parser::SetIncludedRanges`.
+  // If the ranges are invalid, the tree is null.
+  [[nodiscard]] auto
+  Parse(const ts::Language &language, const std::string_view source,
+        ts::Tree &&old_tree, std::vector<ts::Range> included_ranges,
+        const ts::CancellationToken &token =
+            ts::CancellationToken::Null()) noexcept -> std::future<ts::Tree>;
+  // The file is parsed with `ts::Parser::ParseFile`.
+  [[nodiscard]] auto
+  ParseFile(const ts::Language &language, std::string path,
+            const ts::CancellationToken &token =
+                ts::CancellationToken::Null()) noexcept
+      -> std::future<ts::Tree>;
+
+  // They return after `callback` has been called for every source or path.
+  // If `is_ordered` is set, `callback` is called in the order of the inputs,
+  // one at a time, and finished trees wait for the ones before them.
+  // Otherwise, it is called concurrently from the threads as trees finish.
+  auto ParseAll(const ts::Language &language,
+                const std::span<const std::string_view> sources,
+                const ts::BatchCallback &callback, const bool is_ordered,
+                const ts::CancellationToken &token =
+                    ts::CancellationToken::Null()) noexcept -> void;
+  auto ParseFiles(const ts::Language &language,
+                  const std::span<const std::string> paths,
+                  const ts::BatchCallback &callback, const bool is_ordered,
+                  const ts::CancellationToken &token =
+                      ts::CancellationToken::Null()) noexcept -> void;
+
+  auto ThreadCount() const noexcept -> uint32_t;
+
+private:
+  class Batch;
+
+  struct Job {
+    const TSLanguage *ts_language;
+    std::string_view source;
+    // If it is not empty, the file is parsed instead of `source`.
+    std::string path;
+    // A job either fulfills `promise` or reports to `batch`.
+    std::promise<ts::Tree> promise;
+    ts::BatchParser::Batch *batch;
+    size_t index;
+    ts::CancellationToken token;
+    ts::Tree old_tree = ts::Tree::Null();
+    // If it is empty, the whole source is parsed.
+    std::vector<ts::Range> included_ranges = {};
+  };
+
+  static auto ParseJob(const ts::Parser &parser,
+                       ts::BatchParser::Job &job) noexcept -> ts::Tree;
+  auto RunWorker() noexcept -> void;
+
+  uint64_t timeout_micros_;
+  // Last, so its threads are joined before the other members are destroyed.
+  ts::WorkerPool<ts::BatchParser::Job> pool_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_BATCH_H
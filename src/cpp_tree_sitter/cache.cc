@@ -0,0 +1,208 @@
+#include "cache.h"
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// Estimated from the retained allocations of parses, which are 40 to 50 bytes
+// per node for typical grammars.
+constexpr uint64_t kBytesPerNode = 48;
+
+constexpr uint64_t kSecrets[] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+// The multiply-fold of wyhash.
+auto Mix(const uint64_t a, const uint64_t b) noexcept -> uint64_t {
+  const auto product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<uint64_t>(product) ^
+         static_cast<uint64_t>(product >> 64);
+}
+
+auto Load(const char *const bytes) noexcept -> uint64_t {
+  uint64_t value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+// Two independent 64-bit lanes over the same words.
+auto HashBytes(const std::string_view bytes) noexcept
+    -> std::pair<uint64_t, uint64_t> {
+  auto low = kSecrets[0] ^ bytes.size();
+  auto high = kSecrets[1] ^ bytes.size();
+  const auto mix = [&low, &high](const uint64_t a, const uint64_t b) {
+    low = Mix(a ^ kSecrets[2], b ^ low);
+    high = Mix(a ^ kSecrets[3], b ^ high ^ kSecrets[0]);
+  };
+
+  size_t i = 0;
+  for (; i + 16 <= bytes.size(); i += 16) {
+    mix(Load(bytes.data() + i), Load(bytes.data() + i + 8));
+  }
+  if (i < bytes.size()) {
+    char tail[16] = {};
+    std::memcpy(tail, bytes.data() + i, bytes.size() - i);
+    mix(Load(tail), Load(tail + 8));
+  }
+  return {Mix(low ^ kSecrets[1], high ^ kSecrets[2]),
+          Mix(high ^ kSecrets[3], low ^ kSecrets[0])};
+}
+
+auto HashRanges(const std::span<const ts::Range> ranges) noexcept
+    -> uint64_t {
+  uint64_t hash = kSecrets[0] ^ ranges.size();
+  for (const auto &range : ranges) {
+    hash = Mix(hash ^ range.start_byte,
+               kSecrets[1] ^ (static_cast<uint64_t>(range.end_byte) << 32 |
+                              range.start_point.row));
+    hash = Mix(hash ^ range.start_point.column,
+               kSecrets[2] ^ (static_cast<uint64_t>(range.end_point.row)
+                                  << 32 |
+                              range.end_point.column));
+  }
+  return hash;
+}
+
+} // namespace
+
+// ParseCacheKey
+// --------
+
+auto ts::ParseCacheKey::For(
+    const ts::Language &language, const std::string_view source,
+    const std::span<const ts::Range> included_ranges) noexcept
+    -> ts::ParseCacheKey {
+  const auto [source_hash_low, source_hash_high] = HashBytes(source);
+  return ts::ParseCacheKey{language.AsRaw(), source_hash_low, source_hash_high,
+                           source.size(), HashRanges(included_ranges)};
+}
+
+// ParseCacheStats
+// --------
+
+auto ts::operator<<(std::ostream &os,
+                    const ts::ParseCacheStats &parse_cache_stats)
+    -> std::ostream & {
+  return os << "ParseCacheStats{hits=" << parse_cache_stats.hit_count
+            << ", misses=" << parse_cache_stats.miss_count
+            << ", evictions=" << parse_cache_stats.eviction_count
+            << ", entries=" << parse_cache_stats.entry_count
+            << ", bytes=" << parse_cache_stats.bytes << "}";
+}
+
+// ParseCache
+// --------
+
+ts::ParseCache::ParseCache(const ts::ParseCacheOptions &options) noexcept
+    : options_{options}, mutex_{}, entries_{}, index_{}, stats_{} {}
+
+auto ts::ParseCache::Parse(const ts::Parser &parser,
+                           const std::string_view source) noexcept
+    -> ts::Tree {
+  assert(!parser.IsNull() && "ParseCache::Parse: parser is null");
+  const auto included_ranges = parser.IncludedRanges();
+  const auto key =
+      ts::ParseCacheKey::For(parser.Language(), source, included_ranges);
+  if (auto tree = Find(key); !tree.IsNull()) {
+    return tree;
+  }
+  auto tree = parser.ParseString(ts::Tree::Null(), source);
+  Insert(key, tree);
+  return tree;
+}
+
+auto ts::ParseCache::Find(const ts::ParseCacheKey &key) noexcept -> ts::Tree {
+  auto lock = std::lock_guard{mutex_};
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++stats_.miss_count;
+    return ts::Tree::Null();
+  }
+  ++stats_.hit_count;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->tree.Copy();
+}
+
+auto ts::ParseCache::Insert(const ts::ParseCacheKey &key,
+                            const ts::Tree &tree) noexcept -> void {
+  if (tree.IsNull()) {
+    return;
+  }
+  auto entry = ts::ParseCache::Entry{key, tree.Copy(), EstimateBytes(tree)};
+  // Declared before the lock, so the removed trees are deleted after it is
+  // released.
+  auto removed_entries = ts::ParseCache::Entries{};
+
+  auto lock = std::lock_guard{mutex_};
+  if (const auto it = index_.find(key); it != index_.end()) {
+    stats_.bytes -= it->second->bytes;
+    removed_entries.splice(removed_entries.end(), entries_, it->second);
+    index_.erase(it);
+  }
+  stats_.bytes += entry.bytes;
+  entries_.push_front(std::move(entry));
+  index_.emplace(key, entries_.begin());
+  EvictLocked(removed_entries);
+}
+
+auto ts::ParseCache::Erase(const ts::ParseCacheKey &key) noexcept -> bool {
+  auto removed_entries = ts::ParseCache::Entries{};
+  auto lock = std::lock_guard{mutex_};
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+  stats_.bytes -= it->second->bytes;
+  removed_entries.splice(removed_entries.end(), entries_, it->second);
+  index_.erase(it);
+  stats_.entry_count = entries_.size();
+  return true;
+}
+
+auto ts::ParseCache::Clear() noexcept -> void {
+  auto removed_entries = ts::ParseCache::Entries{};
+  auto lock = std::lock_guard{mutex_};
+  removed_entries.swap(entries_);
+  index_.clear();
+  stats_.entry_count = 0;
+  stats_.bytes = 0;
+}
+
+auto ts::ParseCache::Stats() const noexcept -> ts::ParseCacheStats {
+  auto lock = std::lock_guard{mutex_};
+  return stats_;
+}
+
+auto ts::ParseCache::Options() const noexcept
+    -> const ts::ParseCacheOptions & {
+  return options_;
+}
+
+auto ts::ParseCache::EstimateBytes(const ts::Tree &tree) noexcept -> uint64_t {
+  return sizeof(ts::ParseCache::Entry) +
+         tree.RootNode().DescendantCount() * kBytesPerNode;
+}
+
+auto ts::ParseCache::KeyHash::operator()(
+    const ts::ParseCacheKey &key) const noexcept -> size_t {
+  // The source hash is already uniform.
+  return static_cast<size_t>(
+      key.source_hash_low ^
+      Mix(reinterpret_cast<uintptr_t>(key.ts_language) ^ key.ranges_hash,
+          kSecrets[3]));
+}
+
+auto ts::ParseCache::EvictLocked(
+    ts::ParseCache::Entries &evicted_entries) noexcept -> void {
+  // The newest entry is kept even if it alone exceeds the capacity.
+  while (stats_.bytes > options_.capacity_bytes && entries_.size() > 1) {
+    const auto last = std::prev(entries_.end());
+    stats_.bytes -= last->bytes;
+    index_.erase(last->key);
+    evicted_entries.splice(evicted_entries.end(), entries_, last);
+    ++stats_.eviction_count;
+  }
+  stats_.entry_count = entries_.size();
+}
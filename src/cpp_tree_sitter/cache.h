@@ -0,0 +1,126 @@
+#ifndef CPP_TREE_SITTER_CACHE_H
+#define CPP_TREE_SITTER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+
+#include "api.h"
+
+namespace ts {
+
+// ParseCacheKey
+// --------
+
+// What a tree is parsed from: the language, a 128-bit hash and the size of the
+// source, and a hash of the included ranges.
+struct ParseCacheKey {
+  const TSLanguage *ts_language = nullptr;
+  uint64_t source_hash_low = 0;
+  uint64_t source_hash_high = 0;
+  uint64_t source_size = 0;
+  uint64_t ranges_hash = 0;
+
+  // Hashes the whole `source` once, 16 bytes at a time.
+  static auto For(const ts::Language &language, const std::string_view source,
+                  const std::span<const ts::Range> included_ranges) noexcept
+      -> ts::ParseCacheKey;
+
+  auto operator==(const ts::ParseCacheKey &) const noexcept -> bool = default;
+};
+
+// ParseCacheOptions
+// --------
+
+struct ParseCacheOptions {
+  // The estimated bytes of the cached trees, beyond which the least recently
+  // used ones are evicted. See `ts::ParseCache::EstimateBytes`.
+  uint64_t capacity_bytes = 256 * 1024 * 1024;
+};
+
+// ParseCacheStats
+// --------
+
+struct ParseCacheStats {
+  uint64_t hit_count = 0;
+  uint64_t miss_count = 0;
+  uint64_t eviction_count = 0;
+  uint64_t entry_count = 0;
+  uint64_t bytes = 0;
+};
+
+auto operator<<(std::ostream &os, const ts::ParseCacheStats &parse_cache_stats)
+    -> std::ostream &;
+
+// ParseCache
+// --------
+
+// A least recently used cache of trees by `ts::ParseCacheKey`, so unchanged
+// sources are hashed instead of parsed. Trees are handed out as
+// `ts::Tree::Copy`s, which share their subtrees with the cached tree. It is
+// safe to use from many threads.
+class ParseCache {
+public:
+  explicit ParseCache(const ts::ParseCacheOptions &options) noexcept;
+  ParseCache(const ts::ParseCache &) = delete;
+  ParseCache(ts::ParseCache &&) = delete;
+  ~ParseCache() noexcept = default;
+
+  auto operator=(const ts::ParseCache &) -> ts::ParseCache & = delete;
+  auto operator=(ts::ParseCache &&) -> ts::ParseCache & = delete;
+
+  // Returns the cached tree of the language, the included ranges and `source`
+  // of `parser`, or parses `source` and caches the tree. A parse that fails,
+  // e.g.) by a timeout, results in a null tree, which is not cached.
+  [[nodiscard]] auto Parse(const ts::Parser &parser,
+                           const std::string_view source) noexcept -> ts::Tree;
+
+  // If the key is not cached, it returns a null tree.
+  [[nodiscard]] auto Find(const ts::ParseCacheKey &key) noexcept -> ts::Tree;
+  // Replaces the tree of the key, if any. A null tree is ignored.
+  auto Insert(const ts::ParseCacheKey &key, const ts::Tree &tree) noexcept
+      -> void;
+  auto Erase(const ts::ParseCacheKey &key) noexcept -> bool;
+  auto Clear() noexcept -> void;
+
+  auto Stats() const noexcept -> ts::ParseCacheStats;
+  auto Options() const noexcept -> const ts::ParseCacheOptions &;
+
+  // The size of the subtrees of a tree is not exposed by the Tree-sitter core,
+  // so it is estimated from the number of nodes.
+  static auto EstimateBytes(const ts::Tree &tree) noexcept -> uint64_t;
+
+private:
+  struct KeyHash {
+    auto operator()(const ts::ParseCacheKey &key) const noexcept -> size_t;
+  };
+
+  struct Entry {
+    ts::ParseCacheKey key;
+    ts::Tree tree;
+    uint64_t bytes;
+  };
+
+  using Entries = std::list<ts::ParseCache::Entry>;
+
+  // `mutex_` must be held. The evicted entries are moved to
+  // `evicted_entries`.
+  auto EvictLocked(ts::ParseCache::Entries &evicted_entries) noexcept -> void;
+
+  const ts::ParseCacheOptions options_;
+  mutable std::mutex mutex_;
+  // The most recently used entry is at the front.
+  ts::ParseCache::Entries entries_;
+  std::unordered_map<ts::ParseCacheKey, ts::ParseCache::Entries::iterator,
+                     ts::ParseCache::KeyHash>
+      index_;
+  ts::ParseCacheStats stats_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_CACHE_H
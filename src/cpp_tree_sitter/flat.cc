@@ -0,0 +1,388 @@
+#include "flat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "input.h"
+#include "walk.h"
+
+namespace {
+
+constexpr char kMagic[] = {'T', 'S', 'F', 'L', 'A', 'T'};
+// Read as 0x0201 on a host of the other byte order.
+constexpr uint16_t kByteOrder = 0x0102;
+// `ts_builtin_sym_error` of the Tree-sitter core.
+constexpr ts::Symbol kErrorSymbol = UINT16_MAX;
+
+} // namespace
+
+// FlatTree
+// --------
+
+auto ts::FlatTree::Build(const ts::Tree &tree) noexcept -> ts::FlatTree {
+  assert(!tree.IsNull() && "FlatTree::Build: tree is null");
+  return ts::FlatTree::Build(tree.RootNode());
+}
+
+auto ts::FlatTree::Build(const ts::Node &node) noexcept -> ts::FlatTree {
+  assert(!node.IsNull() && "FlatTree::Build: node is null");
+
+  const auto size = node.DescendantCount();
+  uint64_t offsets[ts::FlatTree::kArrayCount];
+  const auto buffer_size = Layout(size, offsets);
+  // Zeroed, so the padding between the arrays is too and the same tree is
+  // always serialized to the same bytes.
+  const auto buffer = std::shared_ptr<char[]>{new char[buffer_size]()};
+  const auto language = node.Language();
+  auto header = ts::FlatTree::Header{};
+  std::memcpy(header.magic, kMagic, sizeof(header.magic));
+  header.byte_order = kByteOrder;
+  header.format_version = ts::FlatTree::kFormatVersion;
+  header.language_version = language.Version();
+  header.symbol_count = language.SymbolCount();
+  header.field_count = language.FieldCount();
+  header.node_count = size;
+  header.size = buffer_size;
+  std::copy_n(offsets, ts::FlatTree::kArrayCount, header.offsets);
+  std::memcpy(buffer.get(), &header, sizeof(header));
+
+  struct Builder {
+    auto Enter(const ts::TreeCursor &cursor) noexcept -> ts::WalkAction {
+      const auto node = cursor.CurrentNode();
+      start_bytes[index] = node.StartByte();
+      end_bytes[index] = node.EndByte();
+      parents[index] =
+          open_nodes.empty() ? ts::FlatTree::kNoIndex : open_nodes.back();
+      symbols[index] = node.Symbol();
+      field_ids[index] = cursor.CurrentFieldId();
+      flags[index] = (node.IsNamed() ? ts::FlatTree::kNamed : 0) |
+                     (node.IsExtra() ? ts::FlatTree::kExtra : 0) |
+                     (node.IsMissing() ? ts::FlatTree::kMissing : 0) |
+                     (node.IsError() ? ts::FlatTree::kError : 0) |
+                     (node.HasError() ? ts::FlatTree::kHasError : 0);
+      // The subtree size is known when the node is left.
+      open_nodes.push_back(index++);
+      return ts::WalkAction::kContinue;
+    }
+
+    auto Leave(const ts::TreeCursor &) noexcept -> ts::WalkAction {
+      const auto open_index = open_nodes.back();
+      open_nodes.pop_back();
+      subtree_sizes[open_index] = index - open_index;
+      return ts::WalkAction::kContinue;
+    }
+
+    uint32_t *start_bytes;
+    uint32_t *end_bytes;
+    ts::FlatTree::Index *parents;
+    uint32_t *subtree_sizes;
+    ts::Symbol *symbols;
+    ts::FieldId *field_ids;
+    uint8_t *flags;
+    ts::FlatTree::Index index;
+    std::vector<ts::FlatTree::Index> open_nodes;
+  };
+
+  auto cursor = ts::TreeCursor{node};
+  auto builder = Builder{
+      reinterpret_cast<uint32_t *>(buffer.get() + offsets[0]),
+      reinterpret_cast<uint32_t *>(buffer.get() + offsets[1]),
+      reinterpret_cast<ts::FlatTree::Index *>(buffer.get() + offsets[2]),
+      reinterpret_cast<uint32_t *>(buffer.get() + offsets[3]),
+      reinterpret_cast<ts::Symbol *>(buffer.get() + offsets[4]),
+      reinterpret_cast<ts::FieldId *>(buffer.get() + offsets[5]),
+      reinterpret_cast<uint8_t *>(buffer.get() + offsets[6]),
+      0,
+      {}};
+  ts::Walk(cursor, builder);
+  assert(builder.index == size);
+
+  auto flat_tree = ts::FlatTree{};
+  flat_tree.storage_ = buffer;
+  flat_tree.bytes_ = std::string_view{buffer.get(), buffer_size};
+  flat_tree.Attach();
+  return flat_tree;
+}
+
+auto ts::FlatTree::Load(const std::string_view bytes,
+                        const ts::Language &language,
+                        ts::FlatTree::LoadError &error) noexcept
+    -> ts::FlatTree {
+  // Copied first, so the arrays are aligned and cannot change after they are
+  // validated.
+  const auto buffer = std::shared_ptr<char[]>{new char[bytes.size()]};
+  std::memcpy(buffer.get(), bytes.data(), bytes.size());
+  const auto buffer_bytes = std::string_view{buffer.get(), bytes.size()};
+  error = Validate(buffer_bytes, language);
+  if (error != ts::FlatTree::LoadError::kNone) {
+    return ts::FlatTree::Null();
+  }
+
+  auto flat_tree = ts::FlatTree{};
+  flat_tree.storage_ = buffer;
+  flat_tree.bytes_ = buffer_bytes;
+  flat_tree.Attach();
+  return flat_tree;
+}
+
+auto ts::FlatTree::LoadFile(const std::string &path,
+                            const ts::Language &language,
+                            ts::FlatTree::LoadError &error) noexcept
+    -> ts::FlatTree {
+  auto mapped_file = ts::MappedFile::Open(path);
+  if (mapped_file.IsNull()) {
+    error = ts::FlatTree::LoadError::kIo;
+    return ts::FlatTree::Null();
+  }
+  const auto file = std::make_shared<const ts::MappedFile>(
+      std::move(mapped_file));
+  // The navigation jumps between parents, siblings and subtrees.
+  file->Advise(ts::MappedFile::Access::kRandom);
+  // A mapping is page aligned.
+  error = Validate(file->Text(), language);
+  if (error != ts::FlatTree::LoadError::kNone) {
+    return ts::FlatTree::Null();
+  }
+
+  auto flat_tree = ts::FlatTree{};
+  flat_tree.storage_ = file;
+  flat_tree.bytes_ = file->Text();
+  flat_tree.Attach();
+  return flat_tree;
+}
+
+auto ts::FlatTree::Bytes() const noexcept -> std::string_view {
+  return bytes_.substr(0, IsNull() ? 0 : header_->size);
+}
+
+auto ts::FlatTree::LanguageVersion() const noexcept -> uint32_t {
+  assert(!IsNull() && "FlatTree::LanguageVersion: flat tree is null");
+  return header_->language_version;
+}
+
+auto ts::FlatTree::SymbolCount() const noexcept -> uint32_t {
+  assert(!IsNull() && "FlatTree::SymbolCount: flat tree is null");
+  return header_->symbol_count;
+}
+
+auto ts::FlatTree::Size() const noexcept -> uint32_t { return size_; }
+
+auto ts::FlatTree::Symbol(const ts::FlatTree::Index index) const noexcept
+    -> ts::Symbol {
+  assert(index < Size() && "FlatTree::Symbol: index is out of range");
+  return symbols_[index];
+}
+
+auto ts::FlatTree::StartByte(const ts::FlatTree::Index index) const noexcept
+    -> uint32_t {
+  assert(index < Size() && "FlatTree::StartByte: index is out of range");
+  return start_bytes_[index];
+}
+
+auto ts::FlatTree::EndByte(const ts::FlatTree::Index index) const noexcept
+    -> uint32_t {
+  assert(index < Size() && "FlatTree::EndByte: index is out of range");
+  return end_bytes_[index];
+}
+
+auto ts::FlatTree::Parent(const ts::FlatTree::Index index) const noexcept
+    -> ts::FlatTree::Index {
+  assert(index < Size() && "FlatTree::Parent: index is out of range");
+  return parents_[index];
+}
+
+auto ts::FlatTree::SubtreeSize(const ts::FlatTree::Index index) const noexcept
+    -> uint32_t {
+  assert(index < Size() && "FlatTree::SubtreeSize: index is out of range");
+  return subtree_sizes_[index];
+}
+
+auto ts::FlatTree::FieldId(const ts::FlatTree::Index index) const noexcept
+    -> ts::FieldId {
+  assert(index < Size() && "FlatTree::FieldId: index is out of range");
+  return field_ids_[index];
+}
+
+auto ts::FlatTree::Flags(const ts::FlatTree::Index index) const noexcept
+    -> uint8_t {
+  assert(index < Size() && "FlatTree::Flags: index is out of range");
+  return flags_[index];
+}
+
+auto ts::FlatTree::IsNamed(const ts::FlatTree::Index index) const noexcept
+    -> bool {
+  return (Flags(index) & ts::FlatTree::kNamed) != 0;
+}
+
+auto ts::FlatTree::SubtreeEnd(const ts::FlatTree::Index index) const noexcept
+    -> ts::FlatTree::Index {
+  return index + SubtreeSize(index);
+}
+
+auto ts::FlatTree::FirstChild(const ts::FlatTree::Index index) const noexcept
+    -> ts::FlatTree::Index {
+  return SubtreeSize(index) > 1 ? index + 1 : ts::FlatTree::kNoIndex;
+}
+
+auto ts::FlatTree::NextSibling(const ts::FlatTree::Index index) const noexcept
+    -> ts::FlatTree::Index {
+  const auto parent = Parent(index);
+  const auto next = SubtreeEnd(index);
+  if (parent == ts::FlatTree::kNoIndex || next >= SubtreeEnd(parent)) {
+    return ts::FlatTree::kNoIndex;
+  }
+  return next;
+}
+
+auto ts::FlatTree::ChildByFieldId(const ts::FlatTree::Index index,
+                                  const ts::FieldId field_id) const noexcept
+    -> ts::FlatTree::Index {
+  for (auto child = FirstChild(index); child != ts::FlatTree::kNoIndex;
+       child = NextSibling(child)) {
+    if (field_ids_[child] == field_id) {
+      return child;
+    }
+  }
+  return ts::FlatTree::kNoIndex;
+}
+
+auto ts::FlatTree::Symbols() const noexcept -> std::span<const ts::Symbol> {
+  return {symbols_, size_};
+}
+
+auto ts::FlatTree::StartBytes() const noexcept -> std::span<const uint32_t> {
+  return {start_bytes_, size_};
+}
+
+auto ts::FlatTree::EndBytes() const noexcept -> std::span<const uint32_t> {
+  return {end_bytes_, size_};
+}
+
+auto ts::FlatTree::Parents() const noexcept
+    -> std::span<const ts::FlatTree::Index> {
+  return {parents_, size_};
+}
+
+auto ts::FlatTree::SubtreeSizes() const noexcept -> std::span<const uint32_t> {
+  return {subtree_sizes_, size_};
+}
+
+auto ts::FlatTree::FieldIds() const noexcept -> std::span<const ts::FieldId> {
+  return {field_ids_, size_};
+}
+
+auto ts::FlatTree::AllFlags() const noexcept -> std::span<const uint8_t> {
+  return {flags_, size_};
+}
+
+auto ts::FlatTree::IsNull() const noexcept -> bool {
+  return storage_ == nullptr;
+}
+
+auto ts::FlatTree::Null() noexcept -> ts::FlatTree { return ts::FlatTree{}; }
+
+ts::FlatTree::FlatTree() noexcept
+    : storage_{}, bytes_{}, header_{nullptr}, size_{0},
+      start_bytes_{nullptr}, end_bytes_{nullptr}, parents_{nullptr},
+      subtree_sizes_{nullptr}, symbols_{nullptr}, field_ids_{nullptr},
+      flags_{nullptr} {}
+
+auto ts::FlatTree::Layout(
+    const uint32_t node_count,
+    uint64_t (&offsets)[ts::FlatTree::kArrayCount]) noexcept -> uint64_t {
+  static_assert(sizeof(ts::FlatTree::Header) == 96);
+  constexpr size_t kElementSizes[ts::FlatTree::kArrayCount] = {
+      sizeof(uint32_t),    sizeof(uint32_t),    sizeof(ts::FlatTree::Index),
+      sizeof(uint32_t),    sizeof(ts::Symbol),  sizeof(ts::FieldId),
+      sizeof(uint8_t)};
+  uint64_t offset = sizeof(ts::FlatTree::Header);
+  for (size_t i = 0; i < ts::FlatTree::kArrayCount; ++i) {
+    offsets[i] = offset;
+    offset = (offset + kElementSizes[i] * node_count + 7) & ~uint64_t{7};
+  }
+  return offset;
+}
+
+auto ts::FlatTree::Validate(const std::string_view bytes,
+                            const ts::Language &language) noexcept
+    -> ts::FlatTree::LoadError {
+  using LoadError = ts::FlatTree::LoadError;
+
+  if (bytes.size() < sizeof(ts::FlatTree::Header)) {
+    return LoadError::kMagic;
+  }
+  const auto &header =
+      *reinterpret_cast<const ts::FlatTree::Header *>(bytes.data());
+  if (std::memcmp(header.magic, kMagic, sizeof(header.magic)) != 0 ||
+      header.byte_order != kByteOrder) {
+    return LoadError::kMagic;
+  }
+  if (header.format_version != ts::FlatTree::kFormatVersion) {
+    return LoadError::kFormatVersion;
+  }
+  if (header.language_version != language.Version()) {
+    return LoadError::kLanguageVersion;
+  }
+  if (header.symbol_count != language.SymbolCount()) {
+    return LoadError::kSymbolCount;
+  }
+  if (header.field_count != language.FieldCount()) {
+    return LoadError::kFieldCount;
+  }
+  uint64_t offsets[ts::FlatTree::kArrayCount];
+  const auto size = Layout(header.node_count, offsets);
+  if (header.node_count == 0 || header.size != size || size > bytes.size() ||
+      !std::equal(offsets, offsets + ts::FlatTree::kArrayCount,
+                  header.offsets)) {
+    return LoadError::kCorrupt;
+  }
+
+  // Every index that the accessors and the navigation can reach stays in
+  // range, so a corrupt file is rejected here rather than read out of bounds.
+  const auto node_count = header.node_count;
+  const auto at = [&bytes, &offsets](const size_t array) {
+    return bytes.data() + offsets[array];
+  };
+  const auto start_bytes = reinterpret_cast<const uint32_t *>(at(0));
+  const auto end_bytes = reinterpret_cast<const uint32_t *>(at(1));
+  const auto parents = reinterpret_cast<const ts::FlatTree::Index *>(at(2));
+  const auto subtree_sizes = reinterpret_cast<const uint32_t *>(at(3));
+  const auto symbols = reinterpret_cast<const ts::Symbol *>(at(4));
+  const auto field_ids = reinterpret_cast<const ts::FieldId *>(at(5));
+  if (parents[0] != ts::FlatTree::kNoIndex ||
+      subtree_sizes[0] != node_count) {
+    return LoadError::kCorrupt;
+  }
+  for (uint32_t i = 0; i < node_count; ++i) {
+    const auto parent = parents[i];
+    if (i > 0 && (parent >= i || subtree_sizes[i] == 0 ||
+                  static_cast<uint64_t>(i) + subtree_sizes[i] >
+                      static_cast<uint64_t>(parent) + subtree_sizes[parent])) {
+      return LoadError::kCorrupt;
+    }
+    if (start_bytes[i] > end_bytes[i] ||
+        (symbols[i] >= header.symbol_count && symbols[i] != kErrorSymbol) ||
+        field_ids[i] > header.field_count) {
+      return LoadError::kCorrupt;
+    }
+  }
+  return LoadError::kNone;
+}
+
+auto ts::FlatTree::Attach() noexcept -> void {
+  header_ = reinterpret_cast<const ts::FlatTree::Header *>(bytes_.data());
+  size_ = header_->node_count;
+  const auto at = [this](const size_t array) {
+    return bytes_.data() + header_->offsets[array];
+  };
+  start_bytes_ = reinterpret_cast<const uint32_t *>(at(0));
+  end_bytes_ = reinterpret_cast<const uint32_t *>(at(1));
+  parents_ = reinterpret_cast<const ts::FlatTree::Index *>(at(2));
+  subtree_sizes_ = reinterpret_cast<const uint32_t *>(at(3));
+  symbols_ = reinterpret_cast<const ts::Symbol *>(at(4));
+  field_ids_ = reinterpret_cast<const ts::FieldId *>(at(5));
+  flags_ = reinterpret_cast<const uint8_t *>(at(6));
+}
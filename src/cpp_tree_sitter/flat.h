@@ -0,0 +1,192 @@
+#ifndef CPP_TREE_SITTER_FLAT_H
+#define CPP_TREE_SITTER_FLAT_H
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "api.h"
+
+namespace ts {
+
+// FlatTree
+// --------
+
+// An immutable snapshot of a tree laid out in pre-order as parallel arrays.
+// Every node, named or anonymous, has a 32-bit index equal to its descendant
+// index in the tree (see `ts::TreeCursor::GotoDescendant`), so the subtree of
+// node `i` is the range `[i, SubtreeEnd(i))`.
+// Passes that read one or two properties of every node scan contiguous arrays
+// instead of walking the tree.
+//
+// The arrays are laid out in one buffer, the same in memory as in the binary
+// format returned by `Bytes`, so a flat tree is written without encoding and
+// loaded from a mapped file without copying:
+//
+//   header (96 bytes, see `ts::FlatTree::Header`)
+//   uint32_t start_bytes[node_count]
+//   uint32_t end_bytes[node_count]
+//   uint32_t parents[node_count]
+//   uint32_t subtree_sizes[node_count]
+//   uint16_t symbols[node_count]
+//   uint16_t field_ids[node_count]
+//   uint8_t  flags[node_count]
+//
+// Each array starts at the offset recorded in the header, aligned to 8 bytes.
+// Integers are in the byte order of the writer, which the reader checks.
+class FlatTree {
+public:
+  using Index = uint32_t;
+
+  static constexpr ts::FlatTree::Index kNoIndex = UINT32_MAX;
+
+  enum Flag : uint8_t {
+    kNamed = 1u << 0,
+    kExtra = 1u << 1,
+    kMissing = 1u << 2,
+    kError = 1u << 3,
+    kHasError = 1u << 4,
+  };
+
+  // Bumped whenever the layout changes.
+  static constexpr uint32_t kFormatVersion = 1;
+
+  enum class LoadError : uint8_t {
+    kNone,
+    // The file could not be opened or mapped.
+    kIo,
+    // Not a flat tree, or written by a host of another byte order.
+    kMagic,
+    kFormatVersion,
+    // Written with another version or build of the language.
+    kLanguageVersion,
+    kSymbolCount,
+    kFieldCount,
+    // The sizes, offsets or arrays are inconsistent, e.g.) truncated.
+    kCorrupt,
+  };
+
+  FlatTree(const ts::FlatTree &) = delete;
+  FlatTree(ts::FlatTree &&) noexcept = default;
+  ~FlatTree() noexcept = default;
+
+  auto operator=(const ts::FlatTree &) -> ts::FlatTree & = delete;
+  auto operator=(ts::FlatTree &&) noexcept -> ts::FlatTree & = default;
+
+  [[nodiscard]] static auto Build(const ts::Tree &tree) noexcept
+      -> ts::FlatTree;
+  // The root of the snapshot is `node`, and indices are relative to it.
+  [[nodiscard]] static auto Build(const ts::Node &node) noexcept
+      -> ts::FlatTree;
+
+  // Copies `bytes`, the result of `Bytes`, and validates them against
+  // `language`. On failure, it returns a null flat tree and sets `error`.
+  [[nodiscard]] static auto Load(const std::string_view bytes,
+                                 const ts::Language &language,
+                                 ts::FlatTree::LoadError &error) noexcept
+      -> ts::FlatTree;
+  // Same as above, but the file is mapped, not copied, and the flat tree
+  // shares the ownership of the mapping. The file is validated only once, and
+  // later writes to it show through the mapping, so it must not be modified
+  // or truncated while the flat tree or a copy of its storage is alive. Use
+  // `Load` for a file that may change.
+  [[nodiscard]] static auto LoadFile(const std::string &path,
+                                     const ts::Language &language,
+                                     ts::FlatTree::LoadError &error) noexcept
+      -> ts::FlatTree;
+
+  // The binary format of the flat tree, borrowed from it.
+  auto Bytes() const noexcept -> std::string_view;
+  // The language that the flat tree was built with.
+  auto LanguageVersion() const noexcept -> uint32_t;
+  auto SymbolCount() const noexcept -> uint32_t;
+
+  auto Size() const noexcept -> uint32_t;
+
+  auto Symbol(const ts::FlatTree::Index index) const noexcept -> ts::Symbol;
+  auto StartByte(const ts::FlatTree::Index index) const noexcept -> uint32_t;
+  auto EndByte(const ts::FlatTree::Index index) const noexcept -> uint32_t;
+  // The root has no parent, i.e. `kNoIndex`.
+  auto Parent(const ts::FlatTree::Index index) const noexcept
+      -> ts::FlatTree::Index;
+  // The number of nodes in the subtree, including the node itself.
+  auto SubtreeSize(const ts::FlatTree::Index index) const noexcept
+      -> uint32_t;
+  // The field of the node in its parent, or 0.
+  auto FieldId(const ts::FlatTree::Index index) const noexcept -> ts::FieldId;
+  auto Flags(const ts::FlatTree::Index index) const noexcept -> uint8_t;
+  auto IsNamed(const ts::FlatTree::Index index) const noexcept -> bool;
+
+  // Navigation
+  auto SubtreeEnd(const ts::FlatTree::Index index) const noexcept
+      -> ts::FlatTree::Index;
+  auto FirstChild(const ts::FlatTree::Index index) const noexcept
+      -> ts::FlatTree::Index;
+  auto NextSibling(const ts::FlatTree::Index index) const noexcept
+      -> ts::FlatTree::Index;
+  auto ChildByFieldId(const ts::FlatTree::Index index,
+                      const ts::FieldId field_id) const noexcept
+      -> ts::FlatTree::Index;
+
+  // The whole arrays, indexed by `ts::FlatTree::Index`.
+  auto Symbols() const noexcept -> std::span<const ts::Symbol>;
+  auto StartBytes() const noexcept -> std::span<const uint32_t>;
+  auto EndBytes() const noexcept -> std::span<const uint32_t>;
+  auto Parents() const noexcept -> std::span<const ts::FlatTree::Index>;
+  auto SubtreeSizes() const noexcept -> std::span<const uint32_t>;
+  auto FieldIds() const noexcept -> std::span<const ts::FieldId>;
+  auto AllFlags() const noexcept -> std::span<const uint8_t>;
+
+  auto IsNull() const noexcept -> bool;
+
+  static auto Null() noexcept -> ts::FlatTree;
+
+private:
+  static constexpr size_t kArrayCount = 7;
+
+  struct Header {
+    // "TSFLAT" and a byte order mark.
+    char magic[6];
+    uint16_t byte_order;
+    uint32_t format_version;
+    uint32_t language_version;
+    uint32_t symbol_count;
+    uint32_t field_count;
+    uint32_t node_count;
+    uint32_t reserved;
+    uint64_t size;
+    // Of the arrays, in the order of the layout, from the start of the header.
+    uint64_t offsets[ts::FlatTree::kArrayCount];
+  };
+
+  explicit FlatTree() noexcept;
+
+  // The offsets of the arrays and the size of a buffer of `node_count` nodes.
+  static auto Layout(const uint32_t node_count,
+                     uint64_t (&offsets)[ts::FlatTree::kArrayCount]) noexcept
+      -> uint64_t;
+  // `bytes` must outlive the flat tree, e.g.) by being owned by `storage_`.
+  static auto Validate(const std::string_view bytes,
+                       const ts::Language &language) noexcept
+      -> ts::FlatTree::LoadError;
+  // Points the arrays into `storage_`, whose header is valid.
+  auto Attach() noexcept -> void;
+
+  // The buffer, or the mapped file that holds it.
+  std::shared_ptr<const void> storage_;
+  std::string_view bytes_;
+  const ts::FlatTree::Header *header_;
+  uint32_t size_;
+  const uint32_t *start_bytes_;
+  const uint32_t *end_bytes_;
+  const ts::FlatTree::Index *parents_;
+  const uint32_t *subtree_sizes_;
+  const ts::Symbol *symbols_;
+  const ts::FieldId *field_ids_;
+  const uint8_t *flags_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_FLAT_H
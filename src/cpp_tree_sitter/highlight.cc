@@ -0,0 +1,237 @@
+#include "highlight.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+// Returns the byte after the `row_count`-th newline from `byte`, or the size
+// of `source` if there are fewer.
+auto SkipRows(const std::string_view source, uint32_t byte,
+              uint32_t row_count) noexcept -> uint32_t {
+  const auto size = static_cast<uint32_t>(source.size());
+  for (; row_count > 0 && byte < size; --row_count) {
+    const auto newline = static_cast<const char *>(
+        std::memchr(source.data() + byte, '\n', size - byte));
+    if (newline == nullptr) {
+      return size;
+    }
+    byte = static_cast<uint32_t>(newline - source.data()) + 1;
+  }
+  return byte;
+}
+
+} // namespace
+
+// HighlightWindow
+// --------
+
+auto ts::HighlightWindow::Lines(const std::string_view source,
+                                const uint32_t start_row,
+                                const uint32_t end_row) noexcept
+    -> ts::HighlightWindow {
+  const auto start_byte = SkipRows(source, 0, start_row);
+  const auto end_byte =
+      end_row > start_row ? SkipRows(source, start_byte, end_row - start_row)
+                          : start_byte;
+  return ts::HighlightWindow{start_byte, end_byte};
+}
+
+// HighlightBuffer
+// --------
+
+ts::HighlightBuffer::HighlightBuffer() noexcept
+    : query_cursor_{}, spans_{}, open_spans_{}, events_{} {}
+
+auto ts::HighlightBuffer::Events() const noexcept
+    -> std::span<const ts::HighlightEvent> {
+  return events_;
+}
+
+auto ts::HighlightBuffer::Clear() noexcept -> void {
+  spans_.clear();
+  open_spans_.clear();
+  events_.clear();
+}
+
+// Highlighter
+// --------
+
+ts::Highlighter::Highlighter(
+    const ts::Query &query,
+    const std::span<const std::string_view> highlight_names,
+    ts::InjectionHighlighterResolver resolver) noexcept
+    : query_{query}, highlight_names_{highlight_names},
+      resolver_{std::move(resolver)}, capture_highlights_{} {
+  assert(!query.IsNull() && "Highlighter::Highlighter: query is null");
+  const auto capture_count = query.CaptureCount();
+  capture_highlights_.reserve(capture_count);
+  for (uint32_t i = 0; i < capture_count; ++i) {
+    auto name = query.CaptureNameForId(i);
+    auto highlight = kNoHighlight;
+    while (!name.empty()) {
+      const auto it =
+          std::find(highlight_names.begin(), highlight_names.end(), name);
+      if (it != highlight_names.end()) {
+        highlight = static_cast<uint32_t>(it - highlight_names.begin());
+        break;
+      }
+      const auto dot = name.rfind('.');
+      name = name.substr(0, dot == std::string_view::npos ? 0 : dot);
+    }
+    capture_highlights_.push_back(highlight);
+  }
+}
+
+auto ts::Highlighter::Highlight(const ts::Tree &tree,
+                                const std::string_view source,
+                                const std::span<const ts::Injection> injections,
+                                const ts::HighlightWindow &window,
+                                ts::HighlightBuffer &buffer,
+                                const ts::CancellationToken &token)
+    const noexcept -> bool {
+  auto &events = buffer.events_;
+  events.clear();
+  return Highlight(
+      tree, source, injections, window, buffer,
+      [&events](const ts::HighlightEvent &event) { events.push_back(event); },
+      token);
+}
+
+auto ts::Highlighter::Highlight(const ts::Tree &tree,
+                                const std::string_view source,
+                                const std::span<const ts::Injection> injections,
+                                const ts::HighlightWindow &window,
+                                ts::HighlightBuffer &buffer,
+                                const ts::HighlightCallback &callback,
+                                const ts::CancellationToken &token)
+    const noexcept -> bool {
+  assert(!tree.IsNull() && "Highlighter::Highlight: tree is null");
+  const auto size = static_cast<uint32_t>(source.size());
+  const auto end_byte = std::min(window.end_byte, size);
+  const auto start_byte = std::min(window.start_byte, end_byte);
+  if (start_byte == end_byte) {
+    return true;
+  }
+
+  // The spans of the host tree and of the injections in the window.
+  auto &spans = buffer.spans_;
+  spans.clear();
+  auto is_complete = AppendSpans(tree.RootNode(), source, start_byte, end_byte,
+                                 0, buffer, token);
+  for (const auto &injection : injections) {
+    if (injection.tree.IsNull() || injection.ranges.empty() ||
+        injection.ranges.front().start_byte >= end_byte ||
+        injection.ranges.back().end_byte <= start_byte) {
+      continue;
+    }
+    const auto highlighter =
+        resolver_ != nullptr ? resolver_(injection.ts_language) : nullptr;
+    if (highlighter != nullptr) {
+      is_complete = highlighter->AppendSpans(injection.tree.RootNode(), source,
+                                             start_byte, end_byte, 1, buffer,
+                                             token) &&
+                    is_complete;
+    }
+  }
+
+  // Outer spans come before the spans they contain, and the first pattern
+  // capturing a node comes before the others. The sort is stable, so among
+  // the captures of a node by one pattern, the first one is kept.
+  std::stable_sort(spans.begin(), spans.end(),
+                   [](const ts::HighlightBuffer::Span &a,
+                      const ts::HighlightBuffer::Span &b) {
+                     return std::tuple{a.start_byte, b.end_byte, a.layer,
+                                       a.pattern_index} <
+                            std::tuple{b.start_byte, a.end_byte, b.layer,
+                                       b.pattern_index};
+                   });
+  const auto last = std::unique(spans.begin(), spans.end(),
+                                [](const ts::HighlightBuffer::Span &a,
+                                   const ts::HighlightBuffer::Span &b) {
+                                  return a.start_byte == b.start_byte &&
+                                         a.end_byte == b.end_byte &&
+                                         a.layer == b.layer;
+                                });
+  spans.erase(last, spans.end());
+
+  // The spans are nested, so each one is closed by the time a span after its
+  // end is opened.
+  auto &open_spans = buffer.open_spans_;
+  open_spans.clear();
+  auto byte = start_byte;
+  const auto emit_source = [&byte, &callback](const uint32_t next_byte) {
+    if (byte < next_byte) {
+      callback(ts::HighlightEvent{ts::HighlightEventKind::kSource, 0, byte,
+                                  next_byte});
+      byte = next_byte;
+    }
+  };
+  const auto close_span = [&open_spans, &emit_source, &callback] {
+    const auto span_end_byte = open_spans.back().end_byte;
+    emit_source(span_end_byte);
+    callback(ts::HighlightEvent{ts::HighlightEventKind::kEnd, 0, span_end_byte,
+                                span_end_byte});
+    open_spans.pop_back();
+  };
+  for (auto span : spans) {
+    while (!open_spans.empty() &&
+           open_spans.back().end_byte <= span.start_byte) {
+      close_span();
+    }
+    // A span crossing the end of the one around it, e.g.) in an error, is cut
+    // to keep the highlights nested.
+    if (!open_spans.empty()) {
+      span.end_byte = std::min(span.end_byte, open_spans.back().end_byte);
+    }
+    emit_source(span.start_byte);
+    callback(ts::HighlightEvent{ts::HighlightEventKind::kStart, span.highlight,
+                                span.start_byte, span.start_byte});
+    open_spans.push_back(span);
+  }
+  while (!open_spans.empty()) {
+    close_span();
+  }
+  emit_source(end_byte);
+  return is_complete;
+}
+
+auto ts::Highlighter::HighlightNames() const noexcept
+    -> std::span<const std::string_view> {
+  return highlight_names_;
+}
+
+auto ts::Highlighter::AppendSpans(const ts::Node &node,
+                                  const std::string_view source,
+                                  const uint32_t start_byte,
+                                  const uint32_t end_byte,
+                                  const uint32_t layer,
+                                  ts::HighlightBuffer &buffer,
+                                  const ts::CancellationToken &token)
+    const noexcept -> bool {
+  auto &query_cursor = buffer.query_cursor_;
+  query_cursor.Exec(query_, node, source);
+  query_cursor.SetByteRange(start_byte, end_byte);
+  query_cursor.SetCancellationToken(token);
+  auto match = ts::QueryMatch{};
+  while (query_cursor.NextMatch(match)) {
+    for (const auto capture : match.Captures()) {
+      const auto highlight = capture_highlights_[capture.Index()];
+      if (highlight == kNoHighlight) {
+        continue;
+      }
+      const auto captured_node = capture.Node();
+      const auto span_start_byte =
+          std::max(captured_node.StartByte(), start_byte);
+      const auto span_end_byte = std::min(captured_node.EndByte(), end_byte);
+      if (span_start_byte < span_end_byte) {
+        buffer.spans_.push_back(ts::HighlightBuffer::Span{
+            span_start_byte, span_end_byte, highlight, layer,
+            match.PatternIndex()});
+      }
+    }
+  }
+  return !query_cursor.WasCancelled();
+}
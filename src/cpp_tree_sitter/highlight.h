@@ -0,0 +1,167 @@
+#ifndef CPP_TREE_SITTER_HIGHLIGHT_H
+#define CPP_TREE_SITTER_HIGHLIGHT_H
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+#include "injection.h"
+#include "query.h"
+
+namespace ts {
+
+// HighlightEvent
+// --------
+
+enum class HighlightEventKind : uint8_t {
+  kStart,
+  kSource,
+  kEnd,
+};
+
+// Highlights are nested: each `kStart` is closed by a `kEnd` before the
+// highlight around it is.
+struct HighlightEvent {
+  ts::HighlightEventKind kind;
+  // For `kStart`, the index of the highlight name. Otherwise, 0.
+  uint32_t highlight;
+  // For `kSource`, the bytes of the text between two other events. For
+  // `kStart` and `kEnd`, both are the byte where the highlight starts or ends.
+  uint32_t start_byte;
+  uint32_t end_byte;
+};
+
+using HighlightCallback = std::function<void(const ts::HighlightEvent &event)>;
+
+// The bytes to highlight. Highlights crossing its bounds are cut at them.
+struct HighlightWindow {
+  uint32_t start_byte = 0;
+  uint32_t end_byte = UINT32_MAX;
+
+  // The bytes of the rows `[start_row, end_row)` of `source`. Finding them
+  // scans the source up to the end of the window.
+  static auto Lines(const std::string_view source, const uint32_t start_row,
+                    const uint32_t end_row) noexcept -> ts::HighlightWindow;
+};
+
+class Highlighter;
+
+// HighlightBuffer
+// --------
+
+// The query cursor and span lists a highlighting works in, and its events if
+// it has no callback. They are cleared rather than freed between calls, so an
+// editor highlighting its visible lines on each keystroke stops allocating
+// after the first few. A buffer can only be used by one highlighting at a time.
+class HighlightBuffer {
+public:
+  explicit HighlightBuffer() noexcept;
+  HighlightBuffer(const ts::HighlightBuffer &) = delete;
+  HighlightBuffer(ts::HighlightBuffer &&) noexcept = default;
+  ~HighlightBuffer() noexcept = default;
+
+  auto operator=(const ts::HighlightBuffer &) -> ts::HighlightBuffer & = delete;
+  auto operator=(ts::HighlightBuffer &&) noexcept
+      -> ts::HighlightBuffer & = default;
+
+  // Of the last highlighting without a callback.
+  auto Events() const noexcept -> std::span<const ts::HighlightEvent>;
+  auto Clear() noexcept -> void;
+
+private:
+  friend class Highlighter;
+
+  struct Span {
+    uint32_t start_byte;
+    uint32_t end_byte;
+    uint32_t highlight;
+    // 0 for the host tree and 1 for injections, so the highlights of an
+    // injection nest inside the ones of the host around it.
+    uint32_t layer;
+    uint32_t pattern_index;
+  };
+
+  ts::QueryCursor query_cursor_;
+  std::vector<ts::HighlightBuffer::Span> spans_;
+  std::vector<ts::HighlightBuffer::Span> open_spans_;
+  std::vector<ts::HighlightEvent> events_;
+};
+
+// Highlighter
+// --------
+
+// Returns the highlighter of an injected language, or `nullptr` to leave its
+// injections unhighlighted.
+using InjectionHighlighterResolver =
+    std::function<const ts::Highlighter *(const TSLanguage *ts_language)>;
+
+// Turns the captures of a `highlights.scm` query into a stream of highlight
+// events. Each capture name is highlighted as the longest of
+// `highlight_names` that is a prefix of it by dot-separated parts, e.g.)
+// `@function.builtin` as "function" unless "function.builtin" is given.
+// Captures without a highlight name, e.g.) `@_name`, are ignored. If several
+// patterns capture the same node, the first one highlights it.
+//
+// The injections found by a `ts::InjectionEngine` running an
+// `injections.scm` query over the same tree are highlighted by the
+// highlighters of their languages, which must have the same highlight names.
+// All the state of a highlighting lives in its `ts::HighlightBuffer`, so
+// threads highlighting different documents can share one highlighter and its
+// capture-to-highlight mapping.
+class Highlighter {
+public:
+  // `query` and `highlight_names` must outlive the highlighter.
+  explicit Highlighter(
+      const ts::Query &query,
+      const std::span<const std::string_view> highlight_names,
+      ts::InjectionHighlighterResolver resolver = nullptr) noexcept;
+  Highlighter(const ts::Highlighter &) = delete;
+  Highlighter(ts::Highlighter &&) = delete;
+  ~Highlighter() noexcept = default;
+
+  auto operator=(const ts::Highlighter &) -> ts::Highlighter & = delete;
+  auto operator=(ts::Highlighter &&) -> ts::Highlighter & = delete;
+
+  // Highlights `window` of `tree`, parsed from `source`, into the events of
+  // `buffer`. Only the nodes intersecting the window are queried.
+  // If `token` is cancelled or its deadline passes, the events are still
+  // balanced, but highlights may be missing, and it returns false.
+  auto Highlight(const ts::Tree &tree, const std::string_view source,
+                 const std::span<const ts::Injection> injections,
+                 const ts::HighlightWindow &window, ts::HighlightBuffer &buffer,
+                 const ts::CancellationToken &token =
+                     ts::CancellationToken::Null()) const noexcept -> bool;
+  // Same as above, but the events are passed to `callback` as they are made,
+  // and `buffer` only provides the memory to find them.
+  auto Highlight(const ts::Tree &tree, const std::string_view source,
+                 const std::span<const ts::Injection> injections,
+                 const ts::HighlightWindow &window, ts::HighlightBuffer &buffer,
+                 const ts::HighlightCallback &callback,
+                 const ts::CancellationToken &token =
+                     ts::CancellationToken::Null()) const noexcept -> bool;
+
+  auto HighlightNames() const noexcept -> std::span<const std::string_view>;
+
+private:
+  static constexpr uint32_t kNoHighlight = UINT32_MAX;
+
+  // Appends the spans of the captures of `node` in `[start_byte, end_byte)`
+  // to `buffer`. Returns false if `token` stopped the query.
+  auto AppendSpans(const ts::Node &node, const std::string_view source,
+                   const uint32_t start_byte, const uint32_t end_byte,
+                   const uint32_t layer, ts::HighlightBuffer &buffer,
+                   const ts::CancellationToken &token) const noexcept -> bool;
+
+  const ts::Query &query_;
+  const std::span<const std::string_view> highlight_names_;
+  const ts::InjectionHighlighterResolver resolver_;
+  // The highlight of each capture id, or `kNoHighlight`.
+  std::vector<uint32_t> capture_highlights_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_HIGHLIGHT_H
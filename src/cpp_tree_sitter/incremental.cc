@@ -0,0 +1,419 @@
+#include "incremental.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+// Sorts `ranges` and merges the ones that overlap or touch.
+auto MergeRanges(std::vector<std::pair<uint32_t, uint32_t>> &ranges) noexcept
+    -> void {
+  if (ranges.empty()) {
+    return;
+  }
+  std::sort(ranges.begin(), ranges.end());
+  auto merged_end = ranges.begin();
+  for (auto it = std::next(ranges.begin()); it != ranges.end(); ++it) {
+    if (it->first <= merged_end->second) {
+      merged_end->second = std::max(merged_end->second, it->second);
+    } else {
+      *++merged_end = *it;
+    }
+  }
+  ranges.erase(std::next(merged_end), ranges.end());
+}
+
+// The node of `other_tree` with the type and the range of `node`, or a null
+// node. Both trees are in the coordinates of the edited source.
+auto FindCounterpart(const ts::Tree &other_tree, const ts::Node &node) noexcept
+    -> ts::Node {
+  const auto start_byte = node.StartByte();
+  const auto end_byte = node.EndByte();
+  auto other_node =
+      other_tree.RootNode().DescendantForByteRange(start_byte, end_byte);
+  while (!other_node.IsNull() && other_node.StartByte() == start_byte &&
+         other_node.EndByte() == end_byte) {
+    if (other_node.Symbol() == node.Symbol()) {
+      return other_node;
+    }
+    other_node = other_node.Parent();
+  }
+  return ts::Node{TSNode{}};
+}
+
+// The children of `node` that overlap or touch `start_byte` to `end_byte`,
+// with their fields.
+auto ChildrenWithin(const ts::Node &node, const uint32_t start_byte,
+                    const uint32_t end_byte) noexcept
+    -> std::vector<std::pair<ts::Node, ts::FieldId>> {
+  auto children = std::vector<std::pair<ts::Node, ts::FieldId>>{};
+  auto cursor = ts::TreeCursor{node};
+  if (cursor.GotoFirstChildForByte(start_byte) < 0) {
+    return children;
+  }
+  do {
+    auto child = cursor.CurrentNode();
+    if (child.StartByte() > end_byte) {
+      break;
+    }
+    children.emplace_back(std::move(child), cursor.CurrentFieldId());
+  } while (cursor.GotoNextSibling());
+  return children;
+}
+
+// Patterns see the types, fields and order of the children, not their exact
+// ranges, which an edit at the end of a token stretches in the old tree.
+auto IsSameChild(const std::pair<ts::Node, ts::FieldId> &a,
+                 const std::pair<ts::Node, ts::FieldId> &b) noexcept -> bool {
+  return a.first.Symbol() == b.first.Symbol() && a.second == b.second;
+}
+
+// Widens `start_byte` to `end_byte` to the ancestors `depth` levels above the
+// nodes of `tree` that changed within it. A node has changed if `other_tree`
+// has no node of its type and range, e.g.) when a changed range starts inside
+// a node whose type changed, or if their children within the range differ.
+// An edit that keeps the structure, e.g.) of whitespace or of the text of a
+// token, changes no node, so its range is not widened: the matches whose
+// captures touch it are found again anyway.
+auto WidenRange(const ts::Tree &tree, const ts::Tree &other_tree,
+                const uint32_t start_byte, const uint32_t end_byte,
+                const uint32_t depth) noexcept
+    -> std::pair<uint32_t, uint32_t> {
+  auto widened_range = std::pair{start_byte, end_byte};
+  const auto widen_from = [&widened_range, depth](ts::Node node) {
+    for (uint32_t i = 0; i < depth; ++i) {
+      auto parent = node.Parent();
+      if (parent.IsNull()) {
+        break;
+      }
+      node = std::move(parent);
+    }
+    widened_range.first = std::min(widened_range.first, node.StartByte());
+    widened_range.second = std::max(widened_range.second, node.EndByte());
+  };
+
+  auto node = tree.RootNode().DescendantForByteRange(start_byte, end_byte);
+  auto changed_ancestor = ts::Node{TSNode{}};
+  for (auto ancestor = node.Parent(); !ancestor.IsNull();
+       ancestor = ancestor.Parent()) {
+    if (FindCounterpart(other_tree, ancestor).IsNull()) {
+      changed_ancestor = ancestor;
+    }
+  }
+  if (!changed_ancestor.IsNull()) {
+    widen_from(std::move(changed_ancestor));
+    return widened_range;
+  }
+  auto counterpart = FindCounterpart(other_tree, node);
+  if (counterpart.IsNull()) {
+    widen_from(std::move(node));
+    return widened_range;
+  }
+
+  // Climbs from the highest changed nodes under the smallest node covering the
+  // range, so a change in a child of a large node is not widened from it. The
+  // children of unchanged nodes are paired by their positions.
+  auto node_pairs = std::vector<std::pair<ts::Node, ts::Node>>{};
+  node_pairs.emplace_back(std::move(node), std::move(counterpart));
+  while (!node_pairs.empty()) {
+    auto [current, current_counterpart] = std::move(node_pairs.back());
+    node_pairs.pop_back();
+    auto children = ChildrenWithin(current, start_byte, end_byte);
+    auto other_children =
+        ChildrenWithin(current_counterpart, start_byte, end_byte);
+    if (!std::equal(children.begin(), children.end(), other_children.begin(),
+                    other_children.end(), IsSameChild)) {
+      widen_from(std::move(current));
+      continue;
+    }
+    for (size_t i = 0; i < children.size(); ++i) {
+      node_pairs.emplace_back(std::move(children[i].first),
+                              std::move(other_children[i].first));
+    }
+  }
+  return widened_range;
+}
+
+// The index of the first of `ranges`, which are sorted and disjoint, that
+// `start_byte` to `end_byte` overlaps or touches, or `ranges.size()`. A match
+// touching a changed range may have changed, e.g.) a node deleted at its end.
+auto FindIntersectingRange(
+    const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+    const uint32_t start_byte, const uint32_t end_byte) noexcept -> size_t {
+  const auto it = std::lower_bound(
+      ranges.begin(), ranges.end(), start_byte,
+      [](const std::pair<uint32_t, uint32_t> &range, const uint32_t byte) {
+        return range.second < byte;
+      });
+  if (it != ranges.end() && it->first <= end_byte) {
+    return static_cast<size_t>(it - ranges.begin());
+  }
+  return ranges.size();
+}
+
+} // namespace
+
+// IncrementalQueryIndex
+// --------
+
+ts::IncrementalQueryIndex::IncrementalQueryIndex(
+    const ts::Query &query) noexcept
+    : query_{query}, query_cursor_{}, is_non_local_patterns_{},
+      local_depth_{0}, non_local_depth_{0}, has_non_local_patterns_{false},
+      entries_{}, captures_{}, dropped_capture_count_{0}, edited_bytes_{},
+      stats_{} {
+  assert(!query.IsNull() &&
+         "IncrementalQueryIndex::IncrementalQueryIndex: query is null");
+  const auto pattern_count = query.PatternCount();
+  is_non_local_patterns_.reserve(pattern_count);
+  for (uint32_t i = 0; i < pattern_count; ++i) {
+    const auto is_non_local = query.IsPatternNonLocal(i);
+    is_non_local_patterns_.push_back(is_non_local);
+    if (is_non_local) {
+      has_non_local_patterns_ = true;
+      non_local_depth_ = std::max(non_local_depth_, query.PatternDepth(i) + 1);
+    } else {
+      local_depth_ = std::max(local_depth_, query.PatternDepth(i));
+    }
+  }
+}
+
+auto ts::IncrementalQueryIndex::Reset(const ts::Tree &tree,
+                                      const std::string_view source) noexcept
+    -> void {
+  assert(!tree.IsNull() && "IncrementalQueryIndex::Reset: tree is null");
+  entries_.clear();
+  captures_.clear();
+  dropped_capture_count_ = 0;
+  edited_bytes_.clear();
+
+  const auto root_node = tree.RootNode();
+  const auto whole_range =
+      ts::IncrementalQueryIndex::ByteRanges{{0, UINT32_MAX - 1}};
+  Execute(root_node, source, whole_range, false, entries_);
+  if (has_non_local_patterns_) {
+    Execute(root_node, source, whole_range, true, entries_);
+  }
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const ts::IncrementalQueryIndex::Entry &a,
+                      const ts::IncrementalQueryIndex::Entry &b) {
+                     return std::pair{a.start_byte, a.pattern_index} <
+                            std::pair{b.start_byte, b.pattern_index};
+                   });
+  stats_ = ts::IncrementalQueryStats{0, static_cast<uint32_t>(entries_.size()),
+                                     source.size()};
+}
+
+auto ts::IncrementalQueryIndex::Edit(const ts::InputEdit &input_edit) noexcept
+    -> void {
+  for (auto &entry : entries_) {
+    entry.start_byte = input_edit.EditByte(entry.start_byte);
+    entry.end_byte = input_edit.EditByte(entry.end_byte);
+  }
+  for (auto &capture : captures_) {
+    auto &range = capture.range;
+    range.start_point =
+        input_edit.EditPoint(range.start_point, range.start_byte);
+    range.end_point = input_edit.EditPoint(range.end_point, range.end_byte);
+    range.start_byte = input_edit.EditByte(range.start_byte);
+    range.end_byte = input_edit.EditByte(range.end_byte);
+  }
+  input_edit.EditByteRanges(edited_bytes_);
+}
+
+auto ts::IncrementalQueryIndex::Update(const ts::Tree &old_tree,
+                                       const ts::Tree &new_tree,
+                                       const std::string_view source) noexcept
+    -> void {
+  assert(!old_tree.IsNull() &&
+         "IncrementalQueryIndex::Update: old_tree is null");
+  assert(!new_tree.IsNull() &&
+         "IncrementalQueryIndex::Update: new_tree is null");
+  stats_ = ts::IncrementalQueryStats{};
+
+  // The text of a token can change without changing the structure of the
+  // tree, which matters to text predicates.
+  auto changed_ranges = std::move(edited_bytes_);
+  edited_bytes_.clear();
+  for (const auto &range : old_tree.ChangedRanges(new_tree)) {
+    changed_ranges.emplace_back(range.start_byte, range.end_byte);
+  }
+  // Zero-width nodes, e.g.) missing ones inserted by error recovery, are not
+  // in the changed ranges, so the ranges take in the bytes next to them.
+  for (auto &[start_byte, end_byte] : changed_ranges) {
+    start_byte = start_byte == 0 ? 0 : start_byte - 1;
+    end_byte = end_byte == UINT32_MAX ? end_byte : end_byte + 1;
+  }
+  MergeRanges(changed_ranges);
+  if (changed_ranges.empty()) {
+    return;
+  }
+
+  const auto widen = [&changed_ranges, &old_tree,
+                      &new_tree](const uint32_t depth) {
+    auto ranges = ts::IncrementalQueryIndex::ByteRanges{};
+    ranges.reserve(changed_ranges.size() * 2);
+    for (const auto &[start_byte, end_byte] : changed_ranges) {
+      ranges.push_back(
+          WidenRange(new_tree, old_tree, start_byte, end_byte, depth));
+      ranges.push_back(
+          WidenRange(old_tree, new_tree, start_byte, end_byte, depth));
+    }
+    MergeRanges(ranges);
+    return ranges;
+  };
+  const auto local_ranges = widen(local_depth_);
+  const auto non_local_ranges = has_non_local_patterns_
+                                    ? widen(non_local_depth_)
+                                    : ts::IncrementalQueryIndex::ByteRanges{};
+
+  // Drop the matches intersecting the changed ranges.
+  const auto old_size = entries_.size();
+  std::erase_if(entries_, [this, &local_ranges, &non_local_ranges](
+                              const ts::IncrementalQueryIndex::Entry &entry) {
+    const auto &ranges = is_non_local_patterns_[entry.pattern_index]
+                             ? non_local_ranges
+                             : local_ranges;
+    if (FindIntersectingRange(ranges, entry.start_byte, entry.end_byte) ==
+        ranges.size()) {
+      return false;
+    }
+    dropped_capture_count_ += entry.capture_count;
+    return true;
+  });
+  stats_.invalidated_count = static_cast<uint32_t>(old_size - entries_.size());
+
+  // Find the matches of the changed ranges again.
+  auto found_entries = std::vector<ts::IncrementalQueryIndex::Entry>{};
+  const auto root_node = new_tree.RootNode();
+  Execute(root_node, source, local_ranges, false, found_entries);
+  if (has_non_local_patterns_) {
+    Execute(root_node, source, non_local_ranges, true, found_entries);
+  }
+  for (const auto &ranges : {&local_ranges, &non_local_ranges}) {
+    for (const auto &[start_byte, end_byte] : *ranges) {
+      stats_.executed_bytes += end_byte - start_byte;
+    }
+  }
+  stats_.found_count = static_cast<uint32_t>(found_entries.size());
+
+  const auto is_before = [](const ts::IncrementalQueryIndex::Entry &a,
+                            const ts::IncrementalQueryIndex::Entry &b) {
+    return std::pair{a.start_byte, a.pattern_index} <
+           std::pair{b.start_byte, b.pattern_index};
+  };
+  std::stable_sort(found_entries.begin(), found_entries.end(), is_before);
+  const auto middle = entries_.insert(entries_.end(), found_entries.begin(),
+                                      found_entries.end());
+  std::inplace_merge(entries_.begin(), middle, entries_.end(), is_before);
+  if (dropped_capture_count_ > captures_.size() / 2) {
+    Compact();
+  }
+}
+
+auto ts::IncrementalQueryIndex::Size() const noexcept -> size_t {
+  return entries_.size();
+}
+
+auto ts::IncrementalQueryIndex::PatternIndex(const size_t index) const noexcept
+    -> uint32_t {
+  return entries_[index].pattern_index;
+}
+
+auto ts::IncrementalQueryIndex::StartByte(const size_t index) const noexcept
+    -> uint32_t {
+  return entries_[index].start_byte;
+}
+
+auto ts::IncrementalQueryIndex::EndByte(const size_t index) const noexcept
+    -> uint32_t {
+  return entries_[index].end_byte;
+}
+
+auto ts::IncrementalQueryIndex::Captures(const size_t index) const noexcept
+    -> std::span<const ts::IndexedCapture> {
+  const auto &entry = entries_[index];
+  return std::span{captures_}.subspan(entry.capture_offset,
+                                      entry.capture_count);
+}
+
+auto ts::IncrementalQueryIndex::Stats() const noexcept
+    -> const ts::IncrementalQueryStats & {
+  return stats_;
+}
+
+auto ts::IncrementalQueryIndex::ResolveNode(
+    const ts::Tree &tree, const ts::IndexedCapture &capture) noexcept
+    -> ts::Node {
+  const auto &range = capture.range;
+  auto node =
+      tree.RootNode().DescendantForByteRange(range.start_byte, range.end_byte);
+  // The smallest node of the range may be a child with the same range.
+  while (!node.IsNull() && node.StartByte() == range.start_byte &&
+         node.EndByte() == range.end_byte) {
+    if (node.Symbol() == capture.symbol) {
+      return node;
+    }
+    node = node.Parent();
+  }
+  return ts::Node{TSNode{}};
+}
+
+auto ts::IncrementalQueryIndex::Execute(
+    const ts::Node &root_node, const std::string_view source,
+    const ts::IncrementalQueryIndex::ByteRanges &ranges,
+    const bool is_non_local,
+    std::vector<ts::IncrementalQueryIndex::Entry> &entries) noexcept -> void {
+  auto match = ts::QueryMatch{};
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    // A node intersects the byte range of a cursor if it overlaps it, so the
+    // range is a byte larger on both sides to find the nodes that touch it.
+    const auto [start_byte, end_byte] = ranges[i];
+    query_cursor_.Exec(query_, root_node, source);
+    query_cursor_.SetByteRange(start_byte == 0 ? 0 : start_byte - 1,
+                               end_byte + 1);
+    while (query_cursor_.NextMatch(match)) {
+      const auto captures = match.Captures();
+      if (is_non_local_patterns_[match.PatternIndex()] != is_non_local ||
+          captures.empty()) {
+        continue;
+      }
+      auto match_start_byte = UINT32_MAX;
+      uint32_t match_end_byte = 0;
+      for (const auto capture : captures) {
+        const auto node = capture.Node();
+        match_start_byte = std::min(match_start_byte, node.StartByte());
+        match_end_byte = std::max(match_end_byte, node.EndByte());
+      }
+      if (FindIntersectingRange(ranges, match_start_byte, match_end_byte) !=
+          i) {
+        continue;
+      }
+
+      entries.push_back(ts::IncrementalQueryIndex::Entry{
+          match.PatternIndex(), match_start_byte, match_end_byte,
+          static_cast<uint32_t>(captures_.size()), captures.size()});
+      for (const auto capture : captures) {
+        const auto node = capture.Node();
+        captures_.push_back(ts::IndexedCapture{
+            ts::Range{TSRange{node.StartPoint(), node.EndPoint(),
+                              node.StartByte(), node.EndByte()}},
+            node.Symbol(), capture.Index()});
+      }
+    }
+  }
+}
+
+auto ts::IncrementalQueryIndex::Compact() noexcept -> void {
+  auto captures = std::vector<ts::IndexedCapture>{};
+  captures.reserve(captures_.size() - dropped_capture_count_);
+  for (auto &entry : entries_) {
+    const auto offset = static_cast<uint32_t>(captures.size());
+    captures.insert(captures.end(), captures_.begin() + entry.capture_offset,
+                    captures_.begin() + entry.capture_offset +
+                        entry.capture_count);
+    entry.capture_offset = offset;
+  }
+  captures_ = std::move(captures);
+  dropped_capture_count_ = 0;
+}
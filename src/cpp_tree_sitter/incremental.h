@@ -0,0 +1,141 @@
+#ifndef CPP_TREE_SITTER_INCREMENTAL_H
+#define CPP_TREE_SITTER_INCREMENTAL_H
+
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "api.h"
+#include "query.h"
+
+namespace ts {
+
+// IndexedCapture
+// --------
+
+// A capture kept by position, so it stays valid across reparses. See
+// `ts::IncrementalQueryIndex::ResolveNode`.
+struct IndexedCapture {
+  ts::Range range;
+  ts::Symbol symbol;
+  // The capture id, which can be passed to `ts::Query::CaptureNameForId`.
+  uint32_t index;
+};
+
+struct IncrementalQueryStats {
+  // Cached matches dropped because they may have changed.
+  uint32_t invalidated_count = 0;
+  // Matches found by executing the query again over the changed ranges.
+  uint32_t found_count = 0;
+  // The bytes of the ranges the query was executed over.
+  uint64_t executed_bytes = 0;
+};
+
+// IncrementalQueryIndex
+// --------
+
+// Keeps the matches of a query over a document up to date across edits,
+// executing the query only around the changed ranges:
+//
+//   index.Reset(tree, source);
+//   ...
+//   tree.Edit(input_edit);
+//   index.Edit(input_edit);
+//   auto new_tree = parser.ParseString(tree.Copy(), new_source);
+//   index.Update(tree, new_tree, new_source);
+//
+// A changed node can only affect the matches whose root nodes are at most
+// `ts::Query::PatternDepth` levels above it, so each range changed by the
+// reparse or the edits is widened to that ancestor of the nodes whose types or
+// children changed within it, in both trees. A range without such nodes, e.g.)
+// of whitespace, is not widened, since its text only matters to the captures
+// touching it. The matches within the widened ranges are dropped and found
+// again with `ts::QueryCursor::SetByteRange`. The matches of non-local
+// patterns span sibling sequences, so their ranges are widened one more level,
+// to the parent of the siblings.
+//
+// Matches without captures are not kept.
+class IncrementalQueryIndex {
+public:
+  // `query` must outlive the index.
+  explicit IncrementalQueryIndex(const ts::Query &query) noexcept;
+  IncrementalQueryIndex(const ts::IncrementalQueryIndex &) = delete;
+  IncrementalQueryIndex(ts::IncrementalQueryIndex &&) = delete;
+  ~IncrementalQueryIndex() noexcept = default;
+
+  auto operator=(const ts::IncrementalQueryIndex &)
+      -> ts::IncrementalQueryIndex & = delete;
+  auto operator=(ts::IncrementalQueryIndex &&)
+      -> ts::IncrementalQueryIndex & = delete;
+
+  // Executes the query over the whole `tree`, parsed from `source`.
+  auto Reset(const ts::Tree &tree, const std::string_view source) noexcept
+      -> void;
+  // Call it with each edit of the source between two updates, as with
+  // `ts::Tree::Edit` on the old tree. The positions of the matches are moved.
+  auto Edit(const ts::InputEdit &input_edit) noexcept -> void;
+  // `old_tree` is the edited tree that `new_tree` was reparsed from, and
+  // `source` is the text of `new_tree`.
+  auto Update(const ts::Tree &old_tree, const ts::Tree &new_tree,
+              const std::string_view source) noexcept -> void;
+
+  // The matches are sorted by their start bytes, then by their patterns.
+  auto Size() const noexcept -> size_t;
+  auto PatternIndex(const size_t index) const noexcept -> uint32_t;
+  // The smallest start byte and the largest end byte of the captures.
+  auto StartByte(const size_t index) const noexcept -> uint32_t;
+  auto EndByte(const size_t index) const noexcept -> uint32_t;
+  auto Captures(const size_t index) const noexcept
+      -> std::span<const ts::IndexedCapture>;
+  // Of the last `Update`.
+  auto Stats() const noexcept -> const ts::IncrementalQueryStats &;
+
+  // The node of `tree` that `capture` was taken from. If the tree has changed
+  // there since, it may be null.
+  static auto ResolveNode(const ts::Tree &tree,
+                          const ts::IndexedCapture &capture) noexcept
+      -> ts::Node;
+
+private:
+  struct Entry {
+    uint32_t pattern_index;
+    uint32_t start_byte;
+    uint32_t end_byte;
+    uint32_t capture_offset;
+    uint32_t capture_count;
+  };
+
+  using ByteRanges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+  // Executes the query over each of `ranges`, and appends the matches of the
+  // local or non-local patterns whose captures intersect the range to
+  // `entries` and `captures_`. A match is appended by the first range it
+  // intersects.
+  auto Execute(const ts::Node &root_node, const std::string_view source,
+               const ts::IncrementalQueryIndex::ByteRanges &ranges,
+               const bool is_non_local,
+               std::vector<ts::IncrementalQueryIndex::Entry> &entries) noexcept
+      -> void;
+  // Moves the live captures to the front of `captures_`.
+  auto Compact() noexcept -> void;
+
+  const ts::Query &query_;
+  ts::QueryCursor query_cursor_;
+  std::vector<bool> is_non_local_patterns_;
+  uint32_t local_depth_;
+  uint32_t non_local_depth_;
+  bool has_non_local_patterns_;
+  std::vector<ts::IncrementalQueryIndex::Entry> entries_;
+  std::vector<ts::IndexedCapture> captures_;
+  // The captures of dropped matches, still in `captures_`.
+  size_t dropped_capture_count_;
+  // The bytes changed by the edits since the last update, in the coordinates
+  // of the edited source.
+  ts::IncrementalQueryIndex::ByteRanges edited_bytes_;
+  ts::IncrementalQueryStats stats_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_INCREMENTAL_H
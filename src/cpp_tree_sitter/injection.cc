@@ -0,0 +1,240 @@
+#include "injection.h"
+
+#include <algorithm>
+#include <cassert>
+#include <future>
+#include <iterator>
+
+namespace {
+
+auto RangeBetween(const uint32_t start_byte, const ts::Point start_point,
+                  const uint32_t end_byte, const ts::Point end_point) noexcept
+    -> ts::Range {
+  return ts::Range{TSRange{start_point, end_point, start_byte, end_byte}};
+}
+
+} // namespace
+
+// InjectionEngine
+// --------
+
+ts::InjectionEngine::InjectionEngine(const ts::Query &query,
+                                     ts::InjectionLanguageResolver resolver,
+                                     ts::BatchParser &batch_parser) noexcept
+    : query_{query}, resolver_{std::move(resolver)},
+      batch_parser_{batch_parser}, pattern_settings_{},
+      content_capture_id_{query.CaptureIdForName("injection.content")},
+      language_capture_id_{query.CaptureIdForName("injection.language")},
+      injections_{}, edited_bytes_{}, stats_{} {
+  assert(!query.IsNull() && "InjectionEngine::InjectionEngine: query is null");
+  const auto pattern_count = query.PatternCount();
+  pattern_settings_.reserve(pattern_count);
+  for (uint32_t i = 0; i < pattern_count; ++i) {
+    auto settings = ts::InjectionEngine::PatternSettings{{}, false, false};
+    for (const auto &predicate : query.GeneralPredicates(i)) {
+      if (predicate.name != "set!" || predicate.arguments.empty()) {
+        continue;
+      }
+      const auto key = predicate.arguments[0].value;
+      if (key == "injection.language" && predicate.arguments.size() > 1) {
+        settings.language = predicate.arguments[1].value;
+      } else if (key == "injection.combined") {
+        settings.is_combined = true;
+      } else if (key == "injection.include-children") {
+        settings.is_including_children = true;
+      }
+    }
+    pattern_settings_.push_back(settings);
+  }
+}
+
+auto ts::InjectionEngine::Update(const ts::Tree &host_tree,
+                                 const std::string_view source) noexcept
+    -> void {
+  assert(!host_tree.IsNull() && "InjectionEngine::Update: host_tree is null");
+
+  // The injections of the new tree, before they are matched to the old ones.
+  auto found_injections = std::vector<ts::Injection>{};
+  auto query_cursor = ts::QueryCursor{};
+  query_cursor.Exec(query_, host_tree.RootNode(), source);
+  auto match = ts::QueryMatch{};
+  while (query_cursor.NextMatch(match)) {
+    const auto &settings = pattern_settings_[match.PatternIndex()];
+    auto language_name = settings.language;
+    auto ranges = std::vector<ts::Range>{};
+    for (const auto capture : match.Captures()) {
+      const auto node = capture.Node();
+      if (capture.Index() == content_capture_id_) {
+        AppendContentRanges(node, settings.is_including_children, ranges);
+      } else if (capture.Index() == language_capture_id_) {
+        language_name =
+            source.substr(node.StartByte(), node.EndByte() - node.StartByte());
+      }
+    }
+    const auto ts_language =
+        language_name.empty() ? nullptr : resolver_(language_name);
+    if (ts_language == nullptr || ranges.empty()) {
+      continue;
+    }
+
+    if (settings.is_combined) {
+      const auto it = std::find_if(
+          found_injections.begin(), found_injections.end(),
+          [&match, ts_language](const ts::Injection &injection) {
+            return injection.pattern_index == match.PatternIndex() &&
+                   injection.ts_language == ts_language;
+          });
+      if (it != found_injections.end()) {
+        it->ranges.insert(it->ranges.end(), ranges.begin(), ranges.end());
+        continue;
+      }
+    }
+    found_injections.push_back(ts::Injection{ts_language, match.PatternIndex(),
+                                             std::move(ranges),
+                                             ts::Tree::Null()});
+  }
+
+  // The ranges of a combined injection come from several matches, and the
+  // content nodes of a match may overlap.
+  for (auto &injection : found_injections) {
+    auto &ranges = injection.ranges;
+    std::sort(ranges.begin(), ranges.end(),
+              [](const ts::Range &a, const ts::Range &b) {
+                return a.start_byte < b.start_byte;
+              });
+    auto merged_end = ranges.begin();
+    for (auto it = std::next(ranges.begin()); it != ranges.end(); ++it) {
+      if (it->start_byte < merged_end->end_byte) {
+        if (it->end_byte > merged_end->end_byte) {
+          merged_end->end_byte = it->end_byte;
+          merged_end->end_point = it->end_point;
+        }
+      } else {
+        *++merged_end = *it;
+      }
+    }
+    ranges.erase(std::next(merged_end), ranges.end());
+  }
+  std::sort(found_injections.begin(), found_injections.end(),
+            [](const ts::Injection &a, const ts::Injection &b) {
+              return std::pair{a.ranges.front().start_byte, a.pattern_index} <
+                     std::pair{b.ranges.front().start_byte, b.pattern_index};
+            });
+
+  // An old injection is matched to the new one of the same language and
+  // pattern whose ranges overlap it. Both lists are in document order.
+  stats_ = ts::InjectionStats{};
+  auto parses = std::vector<std::pair<size_t, std::future<ts::Tree>>>{};
+  auto is_matched = std::vector<bool>(injections_.size(), false);
+  size_t first_old_index = 0;
+  for (size_t index = 0; index < found_injections.size(); ++index) {
+    auto &injection = found_injections[index];
+    const auto start_byte = injection.ranges.front().start_byte;
+    const auto end_byte = injection.ranges.back().end_byte;
+    while (first_old_index < injections_.size() &&
+           injections_[first_old_index].ranges.back().end_byte <= start_byte) {
+      ++first_old_index;
+    }
+    auto old_injection = static_cast<ts::Injection *>(nullptr);
+    for (auto i = first_old_index; i < injections_.size() &&
+                                   injections_[i].ranges.front().start_byte <
+                                       end_byte;
+         ++i) {
+      if (!is_matched[i] &&
+          injections_[i].ts_language == injection.ts_language &&
+          injections_[i].pattern_index == injection.pattern_index &&
+          !injections_[i].tree.IsNull()) {
+        is_matched[i] = true;
+        old_injection = &injections_[i];
+        break;
+      }
+    }
+
+    if (old_injection == nullptr) {
+      ++stats_.parsed_count;
+      parses.emplace_back(
+          index, batch_parser_.Parse(
+                     ts::Language::FromRaw(injection.ts_language), source,
+                     ts::Tree::Null(), injection.ranges));
+    } else if (old_injection->ranges.size() == injection.ranges.size() &&
+               std::equal(injection.ranges.begin(), injection.ranges.end(),
+                          old_injection->ranges.begin(),
+                          [](const ts::Range &a, const ts::Range &b) {
+                            return a.start_byte == b.start_byte &&
+                                   a.end_byte == b.end_byte;
+                          }) &&
+               !IsEdited(injection.ranges)) {
+      ++stats_.reused_count;
+      injection.tree = std::move(old_injection->tree);
+    } else {
+      ++stats_.reparsed_count;
+      parses.emplace_back(
+          index, batch_parser_.Parse(
+                     ts::Language::FromRaw(injection.ts_language), source,
+                     std::move(old_injection->tree), injection.ranges));
+    }
+  }
+
+  for (auto &[index, tree] : parses) {
+    found_injections[index].tree = tree.get();
+  }
+  injections_ = std::move(found_injections);
+  edited_bytes_.clear();
+}
+
+auto ts::InjectionEngine::Edit(const ts::InputEdit &input_edit) noexcept
+    -> void {
+  for (auto &injection : injections_) {
+    if (!injection.tree.IsNull()) {
+      injection.tree.Edit(input_edit);
+      injection.ranges = injection.tree.IncludedRanges();
+    }
+  }
+  input_edit.EditByteRanges(edited_bytes_);
+}
+
+auto ts::InjectionEngine::Injections() const noexcept
+    -> std::span<const ts::Injection> {
+  return injections_;
+}
+
+auto ts::InjectionEngine::Stats() const noexcept
+    -> const ts::InjectionStats & {
+  return stats_;
+}
+
+auto ts::InjectionEngine::AppendContentRanges(
+    const ts::Node &node, const bool is_including_children,
+    std::vector<ts::Range> &ranges) noexcept -> void {
+  auto start_byte = node.StartByte();
+  auto start_point = node.StartPoint();
+  if (!is_including_children) {
+    auto cursor = ts::TreeCursor{node};
+    for (auto has_child = cursor.GotoFirstChild(); has_child;
+         has_child = cursor.GotoNextSibling()) {
+      const auto child = cursor.CurrentNode();
+      if (child.StartByte() > start_byte) {
+        ranges.push_back(RangeBetween(start_byte, start_point,
+                                      child.StartByte(), child.StartPoint()));
+      }
+      start_byte = child.EndByte();
+      start_point = child.EndPoint();
+    }
+  }
+  if (node.EndByte() > start_byte) {
+    ranges.push_back(
+        RangeBetween(start_byte, start_point, node.EndByte(), node.EndPoint()));
+  }
+}
+
+auto ts::InjectionEngine::IsEdited(
+    const std::span<const ts::Range> ranges) const noexcept -> bool {
+  for (const auto &[start_byte, end_byte] : edited_bytes_) {
+    for (const auto &range : ranges) {
+      if (start_byte <= range.end_byte && end_byte >= range.start_byte) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
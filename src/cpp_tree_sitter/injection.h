@@ -0,0 +1,122 @@
+#ifndef CPP_TREE_SITTER_INJECTION_H
+#define CPP_TREE_SITTER_INJECTION_H
+
+#include <functional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "api.h"
+#include "batch.h"
+#include "query.h"
+
+namespace ts {
+
+// Injection
+// --------
+
+// Returns the language of a name, e.g.) "javascript", or `nullptr` if it is
+// unknown.
+using InjectionLanguageResolver =
+    std::function<const TSLanguage *(std::string_view name)>;
+
+// A region of the host document parsed by an embedded language.
+struct Injection {
+  const TSLanguage *ts_language;
+  // The pattern of the injection query that found it.
+  uint32_t pattern_index;
+  // In order, not overlapping and not empty.
+  std::vector<ts::Range> ranges;
+  // If the parse failed, it is null.
+  ts::Tree tree;
+};
+
+struct InjectionStats {
+  // Injections parsed from scratch.
+  uint32_t parsed_count = 0;
+  // Injections whose ranges or text changed, reparsed from their edited trees.
+  uint32_t reparsed_count = 0;
+  // Injections whose ranges and text did not change, kept as they were.
+  uint32_t reused_count = 0;
+};
+
+// InjectionEngine
+// --------
+
+// Finds the injections of a host tree with a query and parses each embedded
+// language over its ranges. The query follows the conventions of
+// `injections.scm` files:
+//
+//   - `@injection.content` captures the nodes whose text is injected.
+//   - `@injection.language` captures a node whose text is the language name,
+//     or `(#set! injection.language "name")` sets it for the pattern.
+//   - `(#set! injection.combined)` parses all the matches of the pattern with
+//     the same language as one document, e.g.) the `<?php` blocks of a file.
+//   - `(#set! injection.include-children)` keeps the children of the content
+//     nodes. Otherwise, only the text between them is injected.
+//
+// The parses run on a `ts::BatchParser`. After an edit, only the injections
+// whose ranges or text changed are reparsed, incrementally.
+// The injections of embedded languages are not followed. Run another engine
+// over an injection tree for that.
+class InjectionEngine {
+public:
+  // `query`, a query of the host language, and `batch_parser` must outlive
+  // the engine.
+  explicit InjectionEngine(const ts::Query &query,
+                           ts::InjectionLanguageResolver resolver,
+                           ts::BatchParser &batch_parser) noexcept;
+  InjectionEngine(const ts::InjectionEngine &) = delete;
+  InjectionEngine(ts::InjectionEngine &&) = delete;
+  ~InjectionEngine() noexcept = default;
+
+  auto operator=(const ts::InjectionEngine &) -> ts::InjectionEngine & = delete;
+  auto operator=(ts::InjectionEngine &&) -> ts::InjectionEngine & = delete;
+
+  // Finds the injections of `host_tree`, parsed from `source`, and parses
+  // them. The injections found by the previous call are reused or reparsed.
+  auto Update(const ts::Tree &host_tree,
+              const std::string_view source) noexcept -> void;
+  // Call it with each edit of the source between two updates, as with
+  // `ts::Tree::Edit` on the host tree.
+  auto Edit(const ts::InputEdit &input_edit) noexcept -> void;
+
+  // In the order of their first ranges.
+  auto Injections() const noexcept -> std::span<const ts::Injection>;
+  // Of the last `Update`.
+  auto Stats() const noexcept -> const ts::InjectionStats &;
+
+private:
+  struct PatternSettings {
+    std::string_view language;
+    bool is_combined;
+    bool is_including_children;
+  };
+
+  // The ranges of `node`, without its children unless `is_including_children`
+  // is set, are appended to `ranges`.
+  static auto AppendContentRanges(const ts::Node &node,
+                                  const bool is_including_children,
+                                  std::vector<ts::Range> &ranges) noexcept
+      -> void;
+  // Whether an edit since the last update touches one of `ranges`.
+  auto IsEdited(const std::span<const ts::Range> ranges) const noexcept
+      -> bool;
+
+  const ts::Query &query_;
+  const ts::InjectionLanguageResolver resolver_;
+  ts::BatchParser &batch_parser_;
+  std::vector<ts::InjectionEngine::PatternSettings> pattern_settings_;
+  uint32_t content_capture_id_;
+  uint32_t language_capture_id_;
+  std::vector<ts::Injection> injections_;
+  // The bytes changed by the edits since the last update, in the coordinates
+  // of the edited source.
+  std::vector<std::pair<uint32_t, uint32_t>> edited_bytes_;
+  ts::InjectionStats stats_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_INJECTION_H
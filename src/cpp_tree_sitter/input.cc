@@ -0,0 +1,250 @@
+#include "input.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <utility>
+
+// MappedFile
+// --------
+
+ts::MappedFile::MappedFile(const char *data, const size_t size) noexcept
+    : data_{data}, size_{size} {}
+
+ts::MappedFile::MappedFile(ts::MappedFile &&other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)} {}
+
+ts::MappedFile::~MappedFile() noexcept {
+  // An empty file is not mapped.
+  if (data_ != nullptr && size_ != 0) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+auto ts::MappedFile::operator=(ts::MappedFile &&other) noexcept
+    -> ts::MappedFile & {
+  if (this == &other) {
+    return *this;
+  }
+  if (data_ != nullptr && size_ != 0) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+  data_ = std::exchange(other.data_, nullptr);
+  size_ = std::exchange(other.size_, 0);
+  return *this;
+}
+
+auto ts::MappedFile::Open(const std::string &path) noexcept -> ts::MappedFile {
+  const auto file_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor == -1) {
+    return ts::MappedFile{nullptr, 0};
+  }
+
+  struct stat file_stat;
+  if (fstat(file_descriptor, &file_stat) == -1) {
+    close(file_descriptor);
+    return ts::MappedFile{nullptr, 0};
+  }
+  const auto size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0) {
+    close(file_descriptor);
+    return ts::MappedFile{"", 0};
+  }
+
+  const auto data =
+      mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  // The mapping keeps the file alive.
+  close(file_descriptor);
+  if (data == MAP_FAILED) {
+    return ts::MappedFile{nullptr, 0};
+  }
+  madvise(data, size, MADV_WILLNEED);
+  return ts::MappedFile{static_cast<const char *>(data), size};
+}
+
+auto ts::MappedFile::Advise(const ts::MappedFile::Access access) const noexcept
+    -> void {
+  assert(!IsNull() && "MappedFile::Advise: mapped file is null");
+  if (size_ == 0) {
+    return;
+  }
+  auto advice = MADV_NORMAL;
+  switch (access) {
+  case ts::MappedFile::Access::kNormal:
+    break;
+  case ts::MappedFile::Access::kSequential:
+    advice = MADV_SEQUENTIAL;
+    break;
+  case ts::MappedFile::Access::kRandom:
+    advice = MADV_RANDOM;
+    break;
+  }
+  madvise(const_cast<char *>(data_), size_, advice);
+}
+
+auto ts::MappedFile::Read(const uint32_t byte_index,
+                          const ts::Point &) const noexcept
+    -> std::string_view {
+  assert(!IsNull() && "MappedFile::Read: mapped file is null");
+  return Text().substr(std::min<size_t>(byte_index, size_));
+}
+
+auto ts::MappedFile::Text() const noexcept -> std::string_view {
+  assert(!IsNull() && "MappedFile::Text: mapped file is null");
+  return std::string_view{data_, size_};
+}
+
+auto ts::MappedFile::IsNull() const noexcept -> bool {
+  return data_ == nullptr;
+}
+
+// RopeReader
+// --------
+
+ts::RopeReader::RopeReader(
+    const std::span<const std::string_view> pieces) noexcept
+    : pieces_{pieces}, piece_offsets_{}, piece_index_{0}, seam_{} {
+  piece_offsets_.reserve(pieces.size() + 1);
+  uint32_t offset = 0;
+  for (const auto &piece : pieces) {
+    piece_offsets_.push_back(offset);
+    offset += static_cast<uint32_t>(piece.size());
+  }
+  piece_offsets_.push_back(offset);
+}
+
+auto ts::RopeReader::Read(const uint32_t byte_index,
+                          const ts::Point &) noexcept -> std::string_view {
+  if (byte_index >= piece_offsets_.back()) {
+    return std::string_view{};
+  }
+
+  if (byte_index < piece_offsets_[piece_index_] ||
+      byte_index >= piece_offsets_[piece_index_ + 1]) {
+    // The last piece starting at or before `byte_index` is not empty.
+    const auto it = std::upper_bound(piece_offsets_.begin(),
+                                     piece_offsets_.end(), byte_index);
+    piece_index_ = static_cast<size_t>(it - piece_offsets_.begin()) - 1;
+  }
+
+  const auto tail =
+      pieces_[piece_index_].substr(byte_index - piece_offsets_[piece_index_]);
+  if (tail.size() >= kSeamSize || piece_index_ + 1 == pieces_.size()) {
+    return tail;
+  }
+
+  // The tail may end in the middle of a character, so it is joined with the
+  // head of the following pieces.
+  auto seam_size = tail.copy(seam_.data(), kSeamSize);
+  for (auto index = piece_index_ + 1;
+       index < pieces_.size() && seam_size < kSeamSize; ++index) {
+    seam_size +=
+        pieces_[index].copy(seam_.data() + seam_size, kSeamSize - seam_size);
+  }
+  return std::string_view{seam_.data(), seam_size};
+}
+
+// FileReader
+// --------
+
+ts::FileReader::FileReader(const int file_descriptor,
+                           const size_t buffer_size) noexcept
+    : file_descriptor_{file_descriptor},
+      buffer_{file_descriptor == -1 ? nullptr : new char[buffer_size]},
+      buffer_size_{buffer_size}, buffer_offset_{0}, buffer_length_{0},
+      is_end_in_buffer_{false}, has_error_{false} {}
+
+ts::FileReader::FileReader(ts::FileReader &&other) noexcept
+    : file_descriptor_{std::exchange(other.file_descriptor_, -1)},
+      buffer_{std::move(other.buffer_)}, buffer_size_{other.buffer_size_},
+      buffer_offset_{other.buffer_offset_},
+      buffer_length_{std::exchange(other.buffer_length_, 0)},
+      is_end_in_buffer_{other.is_end_in_buffer_},
+      has_error_{other.has_error_} {}
+
+ts::FileReader::~FileReader() noexcept {
+  if (file_descriptor_ != -1) {
+    close(file_descriptor_);
+  }
+}
+
+auto ts::FileReader::operator=(ts::FileReader &&other) noexcept
+    -> ts::FileReader & {
+  if (this == &other) {
+    return *this;
+  }
+  if (file_descriptor_ != -1) {
+    close(file_descriptor_);
+  }
+  file_descriptor_ = std::exchange(other.file_descriptor_, -1);
+  buffer_ = std::move(other.buffer_);
+  buffer_size_ = other.buffer_size_;
+  buffer_offset_ = other.buffer_offset_;
+  buffer_length_ = std::exchange(other.buffer_length_, 0);
+  is_end_in_buffer_ = other.is_end_in_buffer_;
+  has_error_ = other.has_error_;
+  return *this;
+}
+
+auto ts::FileReader::Open(const std::string &path,
+                          const size_t buffer_size) noexcept
+    -> ts::FileReader {
+  // A chunk must be able to hold the longest UTF-8 character.
+  assert(buffer_size >= 4 && "FileReader::Open: buffer_size is too small");
+  const auto file_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor != -1) {
+    posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  return ts::FileReader{file_descriptor, buffer_size};
+}
+
+auto ts::FileReader::Read(const uint32_t byte_index,
+                          const ts::Point &) noexcept -> std::string_view {
+  assert(!IsNull() && "FileReader::Read: file reader is null");
+  const auto buffer_end = buffer_offset_ + buffer_length_;
+  const auto is_buffered =
+      byte_index >= buffer_offset_ && byte_index < buffer_end &&
+      (is_end_in_buffer_ || buffer_end - byte_index >= 4);
+  if (!is_buffered && !Fill(byte_index)) {
+    return std::string_view{};
+  }
+  const auto position = static_cast<size_t>(byte_index - buffer_offset_);
+  return std::string_view{buffer_.get() + position, buffer_length_ - position};
+}
+
+auto ts::FileReader::Fill(const uint32_t byte_index) noexcept -> bool {
+  buffer_offset_ = byte_index;
+  buffer_length_ = 0;
+  is_end_in_buffer_ = false;
+  while (buffer_length_ < buffer_size_) {
+    const auto result =
+        pread(file_descriptor_, buffer_.get() + buffer_length_,
+              buffer_size_ - buffer_length_,
+              static_cast<off_t>(buffer_offset_ + buffer_length_));
+    if (result == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      has_error_ = true;
+      break;
+    }
+    if (result == 0) {
+      is_end_in_buffer_ = true;
+      break;
+    }
+    buffer_length_ += static_cast<size_t>(result);
+  }
+  return buffer_length_ != 0;
+}
+
+auto ts::FileReader::HasError() const noexcept -> bool { return has_error_; }
+
+auto ts::FileReader::IsNull() const noexcept -> bool {
+  return file_descriptor_ == -1;
+}
@@ -0,0 +1,141 @@
+#ifndef CPP_TREE_SITTER_INPUT_H
+#define CPP_TREE_SITTER_INPUT_H
+
+#include <array>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+
+namespace ts {
+
+// MappedFile
+// --------
+
+// A read-only memory mapping of a whole file. `Open` asks the kernel to read
+// it in ahead, and `Advise` tells it how the mapping is read from then on:
+// `ts::Parser::ParseFile` advises sequential access for the parse only and
+// normal access after it, since the tree then reads its text at random.
+// As a reader, it returns the rest of the file in one chunk, so nothing is
+// copied.
+class MappedFile {
+public:
+  MappedFile(const ts::MappedFile &) = delete;
+  MappedFile(ts::MappedFile &&other) noexcept;
+  ~MappedFile() noexcept;
+
+  auto operator=(const ts::MappedFile &) -> ts::MappedFile & = delete;
+  auto operator=(ts::MappedFile &&other) noexcept -> ts::MappedFile &;
+
+  // How the mapping is read from now on, passed to `madvise`.
+  enum class Access : uint8_t {
+    kNormal,
+    // From the start to the end, e.g.) by a lexer. The kernel can read ahead
+    // aggressively and drop the pages behind.
+    kSequential,
+    // e.g.) the parent and sibling lookups of a `ts::FlatTree`.
+    kRandom,
+  };
+
+  // If the file cannot be opened or mapped, it returns a null mapping.
+  [[nodiscard]] static auto Open(const std::string &path) noexcept
+      -> ts::MappedFile;
+
+  auto Advise(const ts::MappedFile::Access access) const noexcept -> void;
+
+  auto Read(const uint32_t byte_index, const ts::Point &position) const noexcept
+      -> std::string_view;
+  auto Text() const noexcept -> std::string_view;
+
+  auto IsNull() const noexcept -> bool;
+
+private:
+  explicit MappedFile(const char *data, const size_t size) noexcept;
+
+  const char *data_;
+  size_t size_;
+};
+
+// RopeReader
+// --------
+
+// Reads a document split into pieces, e.g. the leaves of a rope or the pieces
+// of a piece table, in order. The pieces are borrowed.
+// A character split between two pieces is stitched in a small internal buffer,
+// so the pieces can be split at any byte.
+class RopeReader {
+public:
+  explicit RopeReader(const std::span<const std::string_view> pieces) noexcept;
+  RopeReader(const ts::RopeReader &) = delete;
+  RopeReader(ts::RopeReader &&) noexcept = default;
+  ~RopeReader() noexcept = default;
+
+  auto operator=(const ts::RopeReader &) -> ts::RopeReader & = delete;
+  auto operator=(ts::RopeReader &&) noexcept -> ts::RopeReader & = default;
+
+  auto Read(const uint32_t byte_index, const ts::Point &position) noexcept
+      -> std::string_view;
+
+private:
+  // The longest UTF-8 character.
+  static constexpr size_t kSeamSize = 4;
+
+  std::span<const std::string_view> pieces_;
+  // The start byte of each piece, followed by the size of the document.
+  std::vector<uint32_t> piece_offsets_;
+  // Reads are mostly sequential, so the last piece is checked first.
+  size_t piece_index_;
+  std::array<char, ts::RopeReader::kSeamSize> seam_;
+};
+
+// FileReader
+// --------
+
+// Reads a file in chunks through a fixed size buffer, so a document of any
+// size is parsed with bounded memory. Rewinds are served from the buffer when
+// possible and re-read from the file otherwise.
+class FileReader {
+public:
+  static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+  FileReader(const ts::FileReader &) = delete;
+  FileReader(ts::FileReader &&other) noexcept;
+  ~FileReader() noexcept;
+
+  auto operator=(const ts::FileReader &) -> ts::FileReader & = delete;
+  auto operator=(ts::FileReader &&other) noexcept -> ts::FileReader &;
+
+  // If the file cannot be opened, it returns a null reader.
+  [[nodiscard]] static auto
+  Open(const std::string &path,
+       const size_t buffer_size = ts::FileReader::kDefaultBufferSize) noexcept
+      -> ts::FileReader;
+
+  auto Read(const uint32_t byte_index, const ts::Point &position) noexcept
+      -> std::string_view;
+
+  // If a read failed, the document was truncated at that point.
+  auto HasError() const noexcept -> bool;
+  auto IsNull() const noexcept -> bool;
+
+private:
+  explicit FileReader(const int file_descriptor,
+                      const size_t buffer_size) noexcept;
+
+  auto Fill(const uint32_t byte_index) noexcept -> bool;
+
+  int file_descriptor_;
+  std::unique_ptr<char[]> buffer_;
+  size_t buffer_size_;
+  uint64_t buffer_offset_;
+  size_t buffer_length_;
+  bool is_end_in_buffer_;
+  bool has_error_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_INPUT_H
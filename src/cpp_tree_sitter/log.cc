@@ -0,0 +1,208 @@
+#include "log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+auto LogTypeName(const uint8_t log_type) noexcept -> std::string_view {
+  switch (log_type) {
+  case TSLogTypeParse:
+    return "Parse";
+  case TSLogTypeLex:
+    return "Lex";
+  }
+  return "Unknown";
+}
+
+template <typename T>
+auto WriteLittleEndian(std::ostream &output, const T value) noexcept -> void {
+  char bytes[sizeof(T)];
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bytes[i] = static_cast<char>((static_cast<uint64_t>(value) >> (i * 8)) &
+                                 0xff);
+  }
+  output.write(bytes, sizeof(T));
+}
+
+} // namespace
+
+// AsyncLogSink
+// --------
+
+auto ts::AsyncLogSink::Create(std::ostream &output,
+                              const ts::AsyncLogOptions &options) noexcept
+    -> std::shared_ptr<ts::AsyncLogSink> {
+  return std::shared_ptr<ts::AsyncLogSink>{
+      new ts::AsyncLogSink{output, options}};
+}
+
+ts::AsyncLogSink::AsyncLogSink(std::ostream &output,
+                               const ts::AsyncLogOptions &options) noexcept
+    : output_{output}, options_{options},
+      start_{std::chrono::steady_clock::now()}, buffers_mutex_{}, buffers_{},
+      next_logger_id_{1}, drain_mutex_{}, dropped_count_{0}, written_count_{0},
+      stop_mutex_{}, stop_{}, is_stopping_{false}, thread_{} {
+  thread_ = std::thread{[this] { Run(); }};
+}
+
+ts::AsyncLogSink::~AsyncLogSink() noexcept {
+  {
+    auto lock = std::lock_guard{stop_mutex_};
+    is_stopping_ = true;
+  }
+  stop_.notify_one();
+  thread_.join();
+  Flush();
+}
+
+auto ts::AsyncLogSink::Flush() noexcept -> void {
+  Drain();
+  auto lock = std::lock_guard{drain_mutex_};
+  output_.flush();
+}
+
+auto ts::AsyncLogSink::DroppedCount() const noexcept -> uint64_t {
+  return dropped_count_.load(std::memory_order_relaxed);
+}
+
+auto ts::AsyncLogSink::WrittenCount() const noexcept -> uint64_t {
+  return written_count_.load(std::memory_order_relaxed);
+}
+
+auto ts::AsyncLogSink::Options() const noexcept -> const ts::AsyncLogOptions & {
+  return options_;
+}
+
+ts::AsyncLogSink::Buffer::Buffer(const uint32_t logger_id,
+                                 const size_t capacity) noexcept
+    : logger_id{logger_id}, mask{capacity - 1},
+      records{std::make_unique<ts::AsyncLogSink::Record[]>(capacity)}, head{0},
+      tail{0}, dropped_count{0}, reported_dropped_count{0} {}
+
+auto ts::AsyncLogSink::AddBuffer() noexcept
+    -> std::shared_ptr<ts::AsyncLogSink::Buffer> {
+  const auto capacity =
+      std::bit_ceil(std::max<size_t>(options_.buffer_capacity, 2));
+  auto lock = std::lock_guard{buffers_mutex_};
+  auto buffer =
+      std::make_shared<ts::AsyncLogSink::Buffer>(next_logger_id_++, capacity);
+  buffers_.push_back(buffer);
+  return buffer;
+}
+
+auto ts::AsyncLogSink::Drain() noexcept -> void {
+  auto buffers = std::vector<std::shared_ptr<ts::AsyncLogSink::Buffer>>{};
+  {
+    auto lock = std::lock_guard{buffers_mutex_};
+    buffers = buffers_;
+  }
+
+  auto lock = std::lock_guard{drain_mutex_};
+  for (const auto &buffer : buffers) {
+    const auto head = buffer->head.load(std::memory_order_acquire);
+    auto tail = buffer->tail.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+      Write(buffer->logger_id, buffer->records[tail & buffer->mask]);
+    }
+    buffer->tail.store(tail, std::memory_order_release);
+    const auto dropped_count =
+        buffer->dropped_count.load(std::memory_order_relaxed);
+    dropped_count_.fetch_add(dropped_count - buffer->reported_dropped_count,
+                             std::memory_order_relaxed);
+    buffer->reported_dropped_count = dropped_count;
+  }
+  buffers.clear();
+
+  // The buffers of destroyed loggers are released once they are drained.
+  auto buffers_lock = std::lock_guard{buffers_mutex_};
+  std::erase_if(buffers_, [](const auto &buffer) {
+    return buffer.use_count() == 1 &&
+           buffer->head.load(std::memory_order_acquire) ==
+               buffer->tail.load(std::memory_order_relaxed);
+  });
+}
+
+auto ts::AsyncLogSink::Write(const uint32_t logger_id,
+                             const ts::AsyncLogSink::Record &record) noexcept
+    -> void {
+  const auto message = std::string_view{record.message, record.size};
+  switch (options_.format) {
+  case ts::LogFormat::kText:
+    output_ << "parser=" << logger_id
+            << " type=" << LogTypeName(record.log_type)
+            << " t=" << record.nanoseconds << ' ' << message << '\n';
+    break;
+  case ts::LogFormat::kBinary:
+    WriteLittleEndian(output_, record.nanoseconds);
+    WriteLittleEndian(output_, logger_id);
+    WriteLittleEndian(output_, record.log_type);
+    WriteLittleEndian(output_, record.size);
+    output_.write(message.data(), message.size());
+    break;
+  }
+  written_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto ts::AsyncLogSink::Run() noexcept -> void {
+  while (true) {
+    {
+      auto lock = std::unique_lock{stop_mutex_};
+      if (stop_.wait_for(lock, options_.drain_interval,
+                         [this] { return is_stopping_; })) {
+        return;
+      }
+    }
+    Drain();
+  }
+}
+
+// AsyncLogger
+// --------
+
+ts::AsyncLogger::AsyncLogger(std::shared_ptr<ts::AsyncLogSink> sink) noexcept
+    : sink_{std::move(sink)}, buffer_{}, event_count_{0} {
+  assert(sink_ != nullptr && "AsyncLogger::AsyncLogger: sink is null");
+  buffer_ = sink_->AddBuffer();
+}
+
+auto ts::AsyncLogger::Log(const ts::LogType log_type,
+                          const std::string_view buffer) const noexcept
+    -> void {
+  const auto &options = sink_->options_;
+  if ((options.log_type_mask & (1u << log_type)) == 0) {
+    return;
+  }
+  if (options.sample_period > 1 &&
+      event_count_++ % options.sample_period != 0) {
+    return;
+  }
+
+  auto &ring = *buffer_;
+  const auto head = ring.head.load(std::memory_order_relaxed);
+  if (head - ring.tail.load(std::memory_order_acquire) > ring.mask) {
+    ring.dropped_count.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto &record = ring.records[head & ring.mask];
+  record.nanoseconds = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - sink_->start_)
+          .count());
+  record.size = static_cast<uint16_t>(
+      std::min(buffer.size(), ts::AsyncLogSink::kMaxMessageSize));
+  record.log_type = static_cast<uint8_t>(log_type);
+  std::memcpy(record.message, buffer.data(), record.size);
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+auto ts::AsyncLogger::Id() const noexcept -> uint32_t {
+  return buffer_->logger_id;
+}
+
+auto ts::AsyncLogger::DroppedCount() const noexcept -> uint64_t {
+  return buffer_->dropped_count.load(std::memory_order_relaxed);
+}
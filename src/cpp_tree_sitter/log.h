@@ -0,0 +1,158 @@
+#ifndef CPP_TREE_SITTER_LOG_H
+#define CPP_TREE_SITTER_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "api.h"
+
+namespace ts {
+
+// AsyncLogOptions
+// --------
+
+enum class LogFormat {
+  // One line per event, e.g.) `parser=1 type=Lex t=1234 skip character:' '`.
+  kText,
+  // Per event, little-endian: uint64 nanoseconds since the sink was created,
+  // uint32 logger id, uint8 log type, uint16 length and the message bytes.
+  kBinary,
+};
+
+struct AsyncLogOptions {
+  // Events per logger that may wait to be written. It is rounded up to a power
+  // of two. Events logged while the buffer is full are dropped and counted.
+  uint32_t buffer_capacity = 4096;
+  // A bit per `ts::LogType`, e.g.) `1u << TSLogTypeLex`.
+  uint32_t log_type_mask = (1u << TSLogTypeParse) | (1u << TSLogTypeLex);
+  // Every Nth event of each logger is kept. 1 keeps all of them.
+  uint32_t sample_period = 1;
+  ts::LogFormat format = ts::LogFormat::kText;
+  // How often the background thread writes the buffered events.
+  std::chrono::milliseconds drain_interval{10};
+};
+
+// AsyncLogSink
+// --------
+
+// A background thread that writes the events of many `ts::AsyncLogger`s to
+// `output`. `output` must outlive the sink, and it is written by one thread at
+// a time, the sink's or one calling `Flush`. The sink lives as long as its
+// loggers, which share it.
+class AsyncLogSink {
+public:
+  // The longest message kept, in bytes, so a record is 256 bytes. Longer ones
+  // are truncated.
+  static constexpr size_t kMaxMessageSize = 245;
+
+  [[nodiscard]] static auto Create(std::ostream &output,
+                                   const ts::AsyncLogOptions &options) noexcept
+      -> std::shared_ptr<ts::AsyncLogSink>;
+
+  AsyncLogSink(const ts::AsyncLogSink &) = delete;
+  AsyncLogSink(ts::AsyncLogSink &&) = delete;
+  // Writes the remaining events and joins the thread.
+  ~AsyncLogSink() noexcept;
+
+  auto operator=(const ts::AsyncLogSink &) -> ts::AsyncLogSink & = delete;
+  auto operator=(ts::AsyncLogSink &&) -> ts::AsyncLogSink & = delete;
+
+  // Writes the events buffered so far on the calling thread, and flushes
+  // `output`.
+  auto Flush() noexcept -> void;
+
+  // The events dropped by all the loggers because their buffers were full, as
+  // of the last time the buffers were drained.
+  auto DroppedCount() const noexcept -> uint64_t;
+  auto WrittenCount() const noexcept -> uint64_t;
+  auto Options() const noexcept -> const ts::AsyncLogOptions &;
+
+private:
+  friend class AsyncLogger;
+
+  struct Record {
+    uint64_t nanoseconds;
+    uint16_t size;
+    uint8_t log_type;
+    char message[ts::AsyncLogSink::kMaxMessageSize];
+  };
+
+  // A single-producer, single-consumer queue of records. The logger's parser
+  // thread pushes and the sink pops while holding `drain_mutex_`.
+  struct Buffer {
+    explicit Buffer(const uint32_t logger_id, const size_t capacity) noexcept;
+
+    const uint32_t logger_id;
+    const size_t mask;
+    std::unique_ptr<ts::AsyncLogSink::Record[]> records;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) std::atomic<uint64_t> dropped_count;
+    // The part of `dropped_count` already added to the sink's count.
+    uint64_t reported_dropped_count;
+  };
+
+  explicit AsyncLogSink(std::ostream &output,
+                        const ts::AsyncLogOptions &options) noexcept;
+
+  auto AddBuffer() noexcept -> std::shared_ptr<ts::AsyncLogSink::Buffer>;
+  auto Drain() noexcept -> void;
+  auto Write(const uint32_t logger_id,
+             const ts::AsyncLogSink::Record &record) noexcept -> void;
+  auto Run() noexcept -> void;
+
+  std::ostream &output_;
+  const ts::AsyncLogOptions options_;
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex buffers_mutex_;
+  std::vector<std::shared_ptr<ts::AsyncLogSink::Buffer>> buffers_;
+  uint32_t next_logger_id_;
+  std::mutex drain_mutex_;
+  std::atomic<uint64_t> dropped_count_;
+  std::atomic<uint64_t> written_count_;
+  std::mutex stop_mutex_;
+  std::condition_variable stop_;
+  bool is_stopping_;
+  std::thread thread_;
+};
+
+// AsyncLogger
+// --------
+
+// A logger for one parser that copies each event into a buffer drained by an
+// `ts::AsyncLogSink`. It never blocks the parser: events are filtered and
+// sampled first, and dropped if the buffer is full.
+class AsyncLogger : public ts::Logger {
+public:
+  explicit AsyncLogger(std::shared_ptr<ts::AsyncLogSink> sink) noexcept;
+  AsyncLogger(const ts::AsyncLogger &) = delete;
+  AsyncLogger(ts::AsyncLogger &&) = delete;
+  virtual ~AsyncLogger() noexcept override = default;
+
+  auto operator=(const ts::AsyncLogger &) -> ts::AsyncLogger & = delete;
+  auto operator=(ts::AsyncLogger &&) -> ts::AsyncLogger & = delete;
+
+  virtual auto Log(const ts::LogType log_type,
+                   const std::string_view buffer) const noexcept
+      -> void override;
+
+  // The id written with each event of this logger.
+  auto Id() const noexcept -> uint32_t;
+  auto DroppedCount() const noexcept -> uint64_t;
+
+private:
+  std::shared_ptr<ts::AsyncLogSink> sink_;
+  std::shared_ptr<ts::AsyncLogSink::Buffer> buffer_;
+  mutable uint64_t event_count_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_LOG_H
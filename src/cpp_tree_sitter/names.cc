@@ -0,0 +1,164 @@
+#include "names.h"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+// `ts_builtin_sym_error` of the Tree-sitter core.
+constexpr ts::Symbol kErrorSymbol = UINT16_MAX;
+
+// FNV-1a, with `is_named` mixed in so a named and an anonymous symbol with the
+// same name land in different slots.
+auto Hash(const std::string_view name, const bool is_named) noexcept
+    -> uint64_t {
+  uint64_t hash = 14695981039346656037ull;
+  for (const auto c : name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  hash ^= is_named ? 1 : 0;
+  hash *= 1099511628211ull;
+  return hash;
+}
+
+auto SlotCount(const size_t count) noexcept -> size_t {
+  auto slot_count = size_t{4};
+  while (slot_count < count * 2) {
+    slot_count *= 2;
+  }
+  return slot_count;
+}
+
+// Registry
+// --------
+
+std::shared_mutex registry_mutex;
+std::unordered_map<const TSLanguage *, std::unique_ptr<const ts::NameIndex>>
+    registry;
+
+// Most threads use one language at a time, so the last index found skips the
+// registry lock.
+thread_local const TSLanguage *last_ts_language = nullptr;
+thread_local const ts::NameIndex *last_name_index = nullptr;
+
+} // namespace
+
+// NameIndex
+// --------
+
+ts::NameIndex::NameIndex(const TSLanguage *const ts_language) noexcept
+    : symbol_slots_{}, field_slots_{} {
+  // The core returns the first visible (or supertype) symbol with the name
+  // and kind, so the first symbol that the core resolves for a key is kept.
+  const auto symbol_count = ts_language_symbol_count(ts_language);
+  symbol_slots_.assign(SlotCount(symbol_count + 1),
+                       ts::NameIndex::Slot{0, {}, 0, false, false});
+  for (uint32_t i = 0; i < symbol_count; ++i) {
+    const auto symbol = static_cast<ts::Symbol>(i);
+    const auto name = std::string_view{ts_language_symbol_name(ts_language,
+                                                               symbol)};
+    const auto is_named =
+        ts_language_symbol_type(ts_language, symbol) != TSSymbolTypeAnonymous;
+    if (Find(symbol_slots_, name, is_named) != nullptr) {
+      continue;
+    }
+    const auto resolved = ts_language_symbol_for_name(
+        ts_language, name.data(), static_cast<uint32_t>(name.size()),
+        is_named);
+    if (resolved != ts::Language::kSymbolNotFound) {
+      Insert(symbol_slots_, ts::NameIndex::Slot{Hash(name, is_named), name,
+                                                resolved, is_named, true});
+    }
+  }
+  // The core resolves "ERROR" regardless of the kind.
+  const auto error_name = std::string_view{"ERROR"};
+  for (const auto is_named : {true, false}) {
+    Insert(symbol_slots_,
+           ts::NameIndex::Slot{Hash(error_name, is_named), error_name,
+                               kErrorSymbol, is_named, true});
+  }
+
+  const auto field_count = ts_language_field_count(ts_language);
+  field_slots_.assign(SlotCount(field_count),
+                      ts::NameIndex::Slot{0, {}, 0, false, false});
+  for (uint32_t i = 1; i <= field_count; ++i) {
+    const auto field_id = static_cast<ts::FieldId>(i);
+    const auto name = std::string_view{
+        ts_language_field_name_for_id(ts_language, field_id)};
+    Insert(field_slots_, ts::NameIndex::Slot{Hash(name, false), name, field_id,
+                                             false, true});
+  }
+}
+
+auto ts::NameIndex::For(const TSLanguage *const ts_language) noexcept
+    -> const ts::NameIndex & {
+  if (last_ts_language == ts_language) {
+    return *last_name_index;
+  }
+
+  auto name_index = static_cast<const ts::NameIndex *>(nullptr);
+  {
+    auto lock = std::shared_lock{registry_mutex};
+    if (const auto it = registry.find(ts_language); it != registry.end()) {
+      name_index = it->second.get();
+    }
+  }
+  if (name_index == nullptr) {
+    // Built outside the lock. If another thread wins the race, its index is
+    // kept and this one is dropped.
+    auto new_name_index =
+        std::unique_ptr<const ts::NameIndex>{new ts::NameIndex{ts_language}};
+    auto lock = std::unique_lock{registry_mutex};
+    name_index = registry.try_emplace(ts_language, std::move(new_name_index))
+                     .first->second.get();
+  }
+
+  last_ts_language = ts_language;
+  last_name_index = name_index;
+  return *name_index;
+}
+
+auto ts::NameIndex::SymbolForName(const std::string_view name,
+                                  const bool is_named) const noexcept
+    -> ts::Symbol {
+  const auto slot = Find(symbol_slots_, name, is_named);
+  return slot != nullptr ? slot->id : ts::Language::kSymbolNotFound;
+}
+
+auto ts::NameIndex::FieldIdForName(const std::string_view name) const noexcept
+    -> ts::FieldId {
+  const auto slot = Find(field_slots_, name, false);
+  return slot != nullptr ? slot->id : 0;
+}
+
+auto ts::NameIndex::Insert(std::vector<ts::NameIndex::Slot> &slots,
+                           const ts::NameIndex::Slot &slot) noexcept -> void {
+  const auto mask = slots.size() - 1;
+  auto index = slot.hash & mask;
+  for (; slots[index].is_used; index = (index + 1) & mask) {
+    if (slots[index].hash == slot.hash && slots[index].name == slot.name &&
+        slots[index].is_named == slot.is_named) {
+      return;
+    }
+  }
+  slots[index] = slot;
+}
+
+auto ts::NameIndex::Find(const std::vector<ts::NameIndex::Slot> &slots,
+                         const std::string_view name,
+                         const bool is_named) noexcept
+    -> const ts::NameIndex::Slot * {
+  const auto mask = slots.size() - 1;
+  const auto hash = Hash(name, is_named);
+  for (auto index = hash & mask; slots[index].is_used;
+       index = (index + 1) & mask) {
+    if (slots[index].hash == hash && slots[index].name == name &&
+        slots[index].is_named == is_named) {
+      return &slots[index];
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,174 @@
+#ifndef CPP_TREE_SITTER_NAMES_H
+#define CPP_TREE_SITTER_NAMES_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+
+namespace ts {
+
+// NameIndex
+// --------
+
+// Hash tables from symbol and field names to ids of one language. The names are
+// borrowed from the language, which holds them in static storage.
+// `ts::Language::SymbolForName` and `ts::Language::FieldIdForName` use it
+// instead of the linear scans of the Tree-sitter core.
+class NameIndex {
+public:
+  NameIndex(const ts::NameIndex &) = delete;
+  NameIndex(ts::NameIndex &&) = delete;
+  ~NameIndex() noexcept = default;
+
+  auto operator=(const ts::NameIndex &) -> ts::NameIndex & = delete;
+  auto operator=(ts::NameIndex &&) -> ts::NameIndex & = delete;
+
+  // The index of a language is built on the first call and kept for the life of
+  // the process, so it is safe to call from many threads. A language loaded
+  // from a shared library must not be unloaded while the process uses it.
+  static auto For(const TSLanguage *const ts_language) noexcept
+      -> const ts::NameIndex &;
+
+  // Same results as `ts_language_symbol_for_name` and
+  // `ts_language_field_id_for_name`, except that only "ERROR" itself, not any
+  // prefix of it, resolves to the error symbol.
+  auto SymbolForName(const std::string_view name,
+                     const bool is_named) const noexcept -> ts::Symbol;
+  auto FieldIdForName(const std::string_view name) const noexcept
+      -> ts::FieldId;
+
+private:
+  struct Slot {
+    uint64_t hash;
+    std::string_view name;
+    uint16_t id;
+    bool is_named;
+    bool is_used;
+  };
+
+  explicit NameIndex(const TSLanguage *const ts_language) noexcept;
+
+  static auto Insert(std::vector<ts::NameIndex::Slot> &slots,
+                     const ts::NameIndex::Slot &slot) noexcept -> void;
+  static auto Find(const std::vector<ts::NameIndex::Slot> &slots,
+                   const std::string_view name, const bool is_named) noexcept
+      -> const ts::NameIndex::Slot *;
+
+  std::vector<ts::NameIndex::Slot> symbol_slots_;
+  std::vector<ts::NameIndex::Slot> field_slots_;
+};
+
+// FixedString
+// --------
+
+// A string literal usable as a template argument, e.g.)
+// `ts::SymbolTable<"identifier", "call_expression">`.
+template <size_t N> struct FixedString {
+  constexpr FixedString(const char (&string)[N]) noexcept {
+    std::copy_n(string, N, value);
+  }
+
+  constexpr auto View() const noexcept -> std::string_view {
+    return std::string_view{value, N - 1};
+  }
+
+  char value[N];
+};
+
+// SymbolTable
+// --------
+
+// Resolves a fixed list of symbol names once, e.g.) in a static variable at
+// startup, so hot code looks symbols up by a compile-time index instead of a
+// string:
+//
+//   using Symbols = ts::SymbolTable<"identifier", "(">;
+//   static const auto symbols = Symbols{language};
+//   if (node.Symbol() == symbols.Get<"identifier">()) { ... }
+//
+// A name is looked up as a named symbol first and as an anonymous one if there
+// is no such named symbol. A name that is not found is
+// `ts::Language::kSymbolNotFound`.
+template <ts::FixedString... Names> class SymbolTable {
+public:
+  explicit SymbolTable(const ts::Language &language) noexcept {
+    const auto &name_index = ts::NameIndex::For(language.AsRaw());
+    symbols_ = {Resolve(name_index, Names.View())...};
+  }
+
+  // Fails to compile if `Name` is not in the list.
+  template <ts::FixedString Name>
+  static constexpr auto IndexOf() noexcept -> size_t {
+    constexpr auto names = std::array<std::string_view, sizeof...(Names)>{
+        Names.View()...};
+    constexpr auto index = static_cast<size_t>(
+        std::find(names.begin(), names.end(), Name.View()) - names.begin());
+    static_assert(index < sizeof...(Names), "SymbolTable: unknown name");
+    return index;
+  }
+
+  template <ts::FixedString Name> auto Get() const noexcept -> ts::Symbol {
+    return symbols_[IndexOf<Name>()];
+  }
+
+  auto operator[](const size_t index) const noexcept -> ts::Symbol {
+    return symbols_[index];
+  }
+
+  static constexpr auto Size() noexcept -> size_t { return sizeof...(Names); }
+
+private:
+  static auto Resolve(const ts::NameIndex &name_index,
+                      const std::string_view name) noexcept -> ts::Symbol {
+    const auto symbol = name_index.SymbolForName(name, true);
+    return symbol != ts::Language::kSymbolNotFound
+               ? symbol
+               : name_index.SymbolForName(name, false);
+  }
+
+  std::array<ts::Symbol, sizeof...(Names)> symbols_;
+};
+
+// FieldTable
+// --------
+
+// Like `ts::SymbolTable`, for field names. A name that is not found is 0.
+template <ts::FixedString... Names> class FieldTable {
+public:
+  explicit FieldTable(const ts::Language &language) noexcept {
+    const auto &name_index = ts::NameIndex::For(language.AsRaw());
+    field_ids_ = {name_index.FieldIdForName(Names.View())...};
+  }
+
+  // Fails to compile if `Name` is not in the list.
+  template <ts::FixedString Name>
+  static constexpr auto IndexOf() noexcept -> size_t {
+    constexpr auto names = std::array<std::string_view, sizeof...(Names)>{
+        Names.View()...};
+    constexpr auto index = static_cast<size_t>(
+        std::find(names.begin(), names.end(), Name.View()) - names.begin());
+    static_assert(index < sizeof...(Names), "FieldTable: unknown name");
+    return index;
+  }
+
+  template <ts::FixedString Name> auto Get() const noexcept -> ts::FieldId {
+    return field_ids_[IndexOf<Name>()];
+  }
+
+  auto operator[](const size_t index) const noexcept -> ts::FieldId {
+    return field_ids_[index];
+  }
+
+  static constexpr auto Size() noexcept -> size_t { return sizeof...(Names); }
+
+private:
+  std::array<ts::FieldId, sizeof...(Names)> field_ids_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_NAMES_H
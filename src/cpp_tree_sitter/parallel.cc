@@ -0,0 +1,207 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <cassert>
+
+// ParallelQueryExecutor
+// --------
+
+ts::ParallelQueryExecutor::ParallelQueryExecutor(
+    const ts::ParallelQueryOptions &options) noexcept
+    : options_{options}, pool_{0} {
+  pool_.Start(options.thread_count, [this] { RunWorker(); });
+}
+
+ts::ParallelQueryExecutor::~ParallelQueryExecutor() noexcept { pool_.Stop(); }
+
+auto ts::ParallelQueryExecutor::Matches(
+    const ts::Query &query, const ts::Node &node, ts::QueryMatchList &matches,
+    const ts::CancellationToken &token) noexcept -> bool {
+  return Run(query, node, nullptr, matches, token);
+}
+
+auto ts::ParallelQueryExecutor::Matches(
+    const ts::Query &query, const ts::Node &node,
+    const std::string_view source, ts::QueryMatchList &matches,
+    const ts::CancellationToken &token) noexcept -> bool {
+  return Run(query, node, &source, matches, token);
+}
+
+auto ts::ParallelQueryExecutor::Shards(const ts::Node &node,
+                                       const uint32_t shard_count) noexcept
+    -> std::vector<uint32_t> {
+  assert(!node.IsNull() && "ParallelQueryExecutor::Shards: node is null");
+  auto boundaries = std::vector<uint32_t>{node.StartByte()};
+  const auto end_byte = node.EndByte();
+  const uint64_t total_count = node.DescendantCount();
+  auto cursor = ts::TreeCursor{node};
+  if (shard_count > 1 && cursor.GotoFirstChild()) {
+    // The nodes before the current one in pre-order, with `node`.
+    uint64_t count = 1;
+    uint32_t shard_index = 1;
+    auto target_count = total_count * shard_index / shard_count;
+    auto is_done = false;
+    while (!is_done) {
+      const auto child = cursor.CurrentNode();
+      const uint64_t child_count = child.DescendantCount();
+      if (count + child_count > target_count && cursor.GotoFirstChild()) {
+        ++count;
+        continue;
+      }
+      count += child_count;
+      if (count >= target_count) {
+        if (child.EndByte() > boundaries.back() && child.EndByte() < end_byte) {
+          boundaries.push_back(child.EndByte());
+        }
+        while (shard_index < shard_count && count >= target_count) {
+          ++shard_index;
+          target_count = total_count * shard_index / shard_count;
+        }
+        if (shard_index == shard_count) {
+          break;
+        }
+      }
+      while (!cursor.GotoNextSibling()) {
+        if (!cursor.GotoParent()) {
+          is_done = true;
+          break;
+        }
+      }
+    }
+  }
+  if (end_byte > boundaries.back() || boundaries.size() == 1) {
+    boundaries.push_back(end_byte);
+  }
+  return boundaries;
+}
+
+auto ts::ParallelQueryExecutor::ThreadCount() const noexcept -> uint32_t {
+  return pool_.ThreadCount();
+}
+
+auto ts::ParallelQueryExecutor::Run(
+    const ts::Query &query, const ts::Node &node,
+    const std::string_view *source, ts::QueryMatchList &matches,
+    const ts::CancellationToken &token) noexcept -> bool {
+  assert(!query.IsNull() && "ParallelQueryExecutor::Matches: query is null");
+  assert(!node.IsNull() && "ParallelQueryExecutor::Matches: node is null");
+  const auto node_count = node.DescendantCount();
+  const auto shard_count = std::clamp<uint32_t>(
+      node_count / std::max(options_.min_shard_node_count, 1u), 1,
+      ThreadCount() * std::max(options_.shards_per_thread, 1u));
+  const auto boundaries = Shards(node, shard_count);
+
+  // The first and last shards are not limited, as a cursor over the whole
+  // tree. A zero-width node at a boundary intersects neither of two ranges
+  // that meet there, so each range ends a byte after its boundary.
+  auto shard_matches = std::vector<ts::QueryMatchList>(boundaries.size() - 1);
+  auto futures = std::vector<std::future<bool>>{};
+  futures.reserve(shard_matches.size());
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    const auto start_byte = i == 0 ? 0 : boundaries[i];
+    const auto end_byte =
+        i + 2 == boundaries.size() ? UINT32_MAX : boundaries[i + 1] + 1;
+    auto promise = std::promise<bool>{};
+    futures.push_back(promise.get_future());
+    pool_.Push(ts::ParallelQueryExecutor::Job{
+        &query, node, source, start_byte, end_byte, &shard_matches[i], token,
+        std::move(promise)});
+  }
+
+  auto is_complete = true;
+  for (auto &future : futures) {
+    is_complete = future.get() && is_complete;
+  }
+  matches.Clear();
+  if (shard_matches.size() == 1) {
+    matches = std::move(shard_matches[0]);
+  } else {
+    Merge(shard_matches, matches);
+  }
+  return is_complete;
+}
+
+auto ts::ParallelQueryExecutor::Merge(
+    const std::span<const ts::QueryMatchList> shard_matches,
+    ts::QueryMatchList &matches) noexcept -> void {
+  auto next_indices = std::vector<size_t>(shard_matches.size(), 0);
+  const auto is_after = [&shard_matches, &next_indices](const size_t a,
+                                                        const size_t b) {
+    const auto order = ts::QueryMatchList::Compare(
+        shard_matches[a], next_indices[a], shard_matches[b], next_indices[b]);
+    return order != 0 ? order > 0 : a > b;
+  };
+  // A min-heap of the shards by their next match.
+  auto heap = std::vector<size_t>{};
+  for (size_t i = 0; i < shard_matches.size(); ++i) {
+    if (shard_matches[i].Size() != 0) {
+      heap.push_back(i);
+    }
+  }
+  std::make_heap(heap.begin(), heap.end(), is_after);
+
+  while (!heap.empty()) {
+    // The copies of a match found by several shards are next to each other.
+    // The shard with the most copies has all the distinct matches among them.
+    std::pop_heap(heap.begin(), heap.end(), is_after);
+    const auto first_shard = heap.back();
+    const auto first_index = next_indices[first_shard];
+    auto best_shard = first_shard;
+    size_t best_count = 0;
+    do {
+      const auto shard = heap.back();
+      const auto &list = shard_matches[shard];
+      const auto start_index = next_indices[shard];
+      auto &index = next_indices[shard];
+      while (index < list.Size() &&
+             ts::QueryMatchList::Compare(list, index,
+                                         shard_matches[first_shard],
+                                         first_index) == 0) {
+        ++index;
+      }
+      if (index - start_index > best_count) {
+        best_shard = shard;
+        best_count = index - start_index;
+      }
+      if (index < list.Size()) {
+        std::push_heap(heap.begin(), heap.end(), is_after);
+      } else {
+        heap.pop_back();
+      }
+      if (heap.empty()) {
+        break;
+      }
+      std::pop_heap(heap.begin(), heap.end(), is_after);
+      if (ts::QueryMatchList::Compare(
+              shard_matches[heap.back()], next_indices[heap.back()],
+              shard_matches[first_shard], first_index) != 0) {
+        std::push_heap(heap.begin(), heap.end(), is_after);
+        break;
+      }
+    } while (true);
+
+    const auto best_start_index = next_indices[best_shard] - best_count;
+    for (size_t i = 0; i < best_count; ++i) {
+      matches.Append(shard_matches[best_shard], best_start_index + i);
+    }
+  }
+}
+
+auto ts::ParallelQueryExecutor::RunWorker() noexcept -> void {
+  // Reused across jobs, so its buffers are allocated once.
+  auto cursor = ts::QueryCursor{};
+
+  while (auto popped_job = pool_.Pop()) {
+    auto &job = *popped_job;
+    if (job.source != nullptr) {
+      cursor.Exec(*job.query, job.node, *job.source);
+    } else {
+      cursor.Exec(*job.query, job.node);
+    }
+    cursor.SetByteRange(job.start_byte, job.end_byte);
+    cursor.SetCancellationToken(job.token);
+    job.matches->AppendAll(cursor);
+    job.matches->Sort();
+    job.promise.set_value(!cursor.WasCancelled());
+  }
+}
@@ -0,0 +1,109 @@
+#ifndef CPP_TREE_SITTER_PARALLEL_H
+#define CPP_TREE_SITTER_PARALLEL_H
+
+#include <future>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+#include "pool.h"
+#include "query.h"
+
+namespace ts {
+
+// ParallelQueryOptions
+// --------
+
+struct ParallelQueryOptions {
+  // If it is 0, `std::thread::hardware_concurrency` threads are used.
+  uint32_t thread_count = 0;
+  // The shards per thread, so a shard with many matches does not leave the
+  // other threads idle.
+  uint32_t shards_per_thread = 4;
+  // A tree is split into fewer shards so that each has at least this many
+  // nodes. Small trees are queried on one thread.
+  uint32_t min_shard_node_count = 16384;
+};
+
+// ParallelQueryExecutor
+// --------
+
+// Executes a query over one large tree on a pool of threads. The tree is split
+// into byte ranges with about the same numbers of nodes, and each thread runs a
+// `ts::QueryCursor` limited to a range with `ts::QueryCursor::SetByteRange`.
+//
+// A match is found by every range that its first node intersects, so the
+// ranges of a shard overlap the next one by a byte, and the matches found by
+// neighbouring shards are deduplicated when they are merged. The result is the
+// same as the matches of one cursor over the whole tree, sorted by
+// `ts::QueryMatchList::Sort`, for the patterns of typical queries. Matches
+// without captures cannot be told apart, so they are only counted once per
+// shard boundary they straddle.
+class ParallelQueryExecutor {
+public:
+  explicit ParallelQueryExecutor(
+      const ts::ParallelQueryOptions &options) noexcept;
+  ParallelQueryExecutor(const ts::ParallelQueryExecutor &) = delete;
+  ParallelQueryExecutor(ts::ParallelQueryExecutor &&) = delete;
+  // Joins the threads.
+  ~ParallelQueryExecutor() noexcept;
+
+  auto operator=(const ts::ParallelQueryExecutor &)
+      -> ts::ParallelQueryExecutor & = delete;
+  auto operator=(ts::ParallelQueryExecutor &&)
+      -> ts::ParallelQueryExecutor & = delete;
+
+  // Replaces `matches` with the matches of `query` under `node`, in document
+  // order. Text predicates are not evaluated. It must not be called from the
+  // threads of the executor. If `token` is cancelled, the matches are
+  // incomplete and it returns false.
+  auto Matches(const ts::Query &query, const ts::Node &node,
+               ts::QueryMatchList &matches,
+               const ts::CancellationToken &token =
+                   ts::CancellationToken::Null()) noexcept -> bool;
+  // Same as above, but matches which do not satisfy the text predicates of the
+  // `query` are skipped.
+  auto Matches(const ts::Query &query, const ts::Node &node,
+               const std::string_view source, ts::QueryMatchList &matches,
+               const ts::CancellationToken &token =
+                   ts::CancellationToken::Null()) noexcept -> bool;
+
+  // The boundaries of up to `shard_count` byte ranges under `node`, from its
+  // start byte to its end byte, with about the same numbers of descendants.
+  // A subtree is only split if it does not fit the rest of a shard.
+  static auto Shards(const ts::Node &node, const uint32_t shard_count) noexcept
+      -> std::vector<uint32_t>;
+
+  auto ThreadCount() const noexcept -> uint32_t;
+
+private:
+  struct Job {
+    const ts::Query *query;
+    ts::Node node;
+    // If it is null, text predicates are not evaluated.
+    const std::string_view *source;
+    uint32_t start_byte;
+    uint32_t end_byte;
+    ts::QueryMatchList *matches;
+    ts::CancellationToken token;
+    std::promise<bool> promise;
+  };
+
+  auto Run(const ts::Query &query, const ts::Node &node,
+           const std::string_view *source, ts::QueryMatchList &matches,
+           const ts::CancellationToken &token) noexcept -> bool;
+  // Merges the sorted matches of the shards, dropping the ones found by the
+  // previous shard too.
+  static auto Merge(const std::span<const ts::QueryMatchList> shard_matches,
+                    ts::QueryMatchList &matches) noexcept -> void;
+  auto RunWorker() noexcept -> void;
+
+  const ts::ParallelQueryOptions options_;
+  // Last, so its threads are joined before the other members are destroyed.
+  ts::WorkerPool<ts::ParallelQueryExecutor::Job> pool_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_PARALLEL_H
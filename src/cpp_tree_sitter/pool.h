@@ -0,0 +1,112 @@
+#ifndef CPP_TREE_SITTER_POOL_H
+#define CPP_TREE_SITTER_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+// WorkerPool
+// --------
+
+// A queue of jobs and the threads that take them. The owner runs its own loop
+// on each thread, popping jobs with `Pop`, so a thread can keep its state,
+// e.g.) parsers or query cursors, across the jobs it takes.
+template <typename Job> class WorkerPool {
+public:
+  // If `queue_capacity` is 0, `Push` never blocks.
+  explicit WorkerPool(const size_t queue_capacity) noexcept
+      : queue_capacity_{queue_capacity}, mutex_{}, not_empty_{}, not_full_{},
+        jobs_{}, is_stopping_{false}, threads_{} {}
+  WorkerPool(const ts::WorkerPool<Job> &) = delete;
+  WorkerPool(ts::WorkerPool<Job> &&) = delete;
+  ~WorkerPool() noexcept { Stop(); }
+
+  auto operator=(const ts::WorkerPool<Job> &) -> ts::WorkerPool<Job> & = delete;
+  auto operator=(ts::WorkerPool<Job> &&) -> ts::WorkerPool<Job> & = delete;
+
+  // If it is 0, `std::thread::hardware_concurrency` threads are used.
+  static auto ResolveThreadCount(const uint32_t thread_count) noexcept
+      -> uint32_t {
+    return thread_count != 0
+               ? thread_count
+               : std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // Runs `run_worker` on `ResolveThreadCount(thread_count)` threads. It should
+  // return once `Pop` returns no job.
+  auto Start(const uint32_t thread_count,
+             const std::function<void()> &run_worker) noexcept -> void {
+    const auto resolved_thread_count = ResolveThreadCount(thread_count);
+    threads_.reserve(resolved_thread_count);
+    for (uint32_t i = 0; i < resolved_thread_count; ++i) {
+      threads_.emplace_back(run_worker);
+    }
+  }
+
+  // Lets the threads finish the queued jobs and joins them.
+  auto Stop() noexcept -> void {
+    {
+      auto lock = std::lock_guard{mutex_};
+      is_stopping_ = true;
+    }
+    not_empty_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  // Blocks while `queue_capacity` jobs are queued.
+  auto Push(Job &&job) noexcept -> void {
+    {
+      auto lock = std::unique_lock{mutex_};
+      not_full_.wait(lock, [this] {
+        return queue_capacity_ == 0 || jobs_.size() < queue_capacity_;
+      });
+      jobs_.push_back(std::move(job));
+    }
+    not_empty_.notify_one();
+  }
+
+  // Blocks until a job is queued. Once the pool is stopping and the queue is
+  // empty, it returns no job.
+  auto Pop() noexcept -> std::optional<Job> {
+    auto lock = std::unique_lock{mutex_};
+    not_empty_.wait(lock, [this] { return is_stopping_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      return std::nullopt;
+    }
+    auto job = std::optional<Job>{std::move(jobs_.front())};
+    jobs_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return job;
+  }
+
+  auto ThreadCount() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(threads_.size());
+  }
+
+private:
+  const size_t queue_capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<Job> jobs_;
+  bool is_stopping_;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_POOL_H
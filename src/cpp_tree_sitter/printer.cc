@@ -0,0 +1,422 @@
+#include "printer.h"
+
+#include <cassert>
+#include <charconv>
+
+#include "walk.h"
+
+using namespace ts;
+
+// TreePrinter
+// --------
+
+ts::TreePrinter::TreePrinter(const ts::PrintOptions &options) noexcept
+    : options_{options} {}
+
+auto ts::TreePrinter::Print(const ts::Tree &tree) noexcept -> void {
+  if (tree.IsNull()) {
+    switch (options_.format) {
+    case ts::PrintFormat::kSExpression:
+      buffer_.append("(null)");
+      break;
+    case ts::PrintFormat::kJson:
+      buffer_.append("null");
+      break;
+    case ts::PrintFormat::kVerbose:
+      buffer_.append("Tree{null}");
+      break;
+    }
+    return;
+  }
+
+  if (options_.format == ts::PrintFormat::kVerbose) {
+    buffer_.append("Tree{root_node=");
+  }
+  is_tree_ = true;
+  Print(tree.RootNode());
+  is_tree_ = false;
+}
+
+auto ts::TreePrinter::Print(const ts::Node &node) noexcept -> void {
+  assert(!node.IsNull() && "TreePrinter::Print: node is null");
+  struct Visitor {
+    ts::TreePrinter &printer;
+
+    auto Enter(const ts::TreeCursor &cursor) -> ts::WalkAction {
+      printer.Enter(cursor);
+      return ts::WalkAction::kContinue;
+    }
+    auto Leave(const ts::TreeCursor &cursor) -> ts::WalkAction {
+      printer.Leave(cursor);
+      return ts::WalkAction::kContinue;
+    }
+  };
+
+  frames_.clear();
+  ts::Walk(node, Visitor{*this});
+}
+
+auto ts::TreePrinter::Buffer() const noexcept -> std::string_view {
+  return buffer_;
+}
+
+auto ts::TreePrinter::Clear() noexcept -> void { buffer_.clear(); }
+
+auto ts::TreePrinter::Enter(const ts::TreeCursor &cursor) noexcept -> void {
+  const auto is_root = frames_.empty();
+  uint32_t child_index = 0;
+  if (!is_root) {
+    child_index = frames_.back().next_child_index++;
+  }
+
+  const auto node = cursor.CurrentNode();
+  const auto is_printed =
+      is_root || !options_.named_only || node.IsNamed() || node.IsMissing();
+  frames_.push_back(Frame{0, is_printed, false});
+  if (!is_printed) {
+    return;
+  }
+
+  switch (options_.format) {
+  case ts::PrintFormat::kSExpression:
+    EnterSExpression(cursor, node, is_root);
+    break;
+  case ts::PrintFormat::kJson:
+    EnterJson(cursor, node, is_root);
+    break;
+  case ts::PrintFormat::kVerbose:
+    EnterVerbose(cursor, node, child_index, is_root);
+    break;
+  }
+}
+
+auto ts::TreePrinter::Leave(const ts::TreeCursor &) noexcept -> void {
+  const auto frame = frames_.back();
+  frames_.pop_back();
+  if (!frame.is_printed) {
+    return;
+  }
+
+  switch (options_.format) {
+  case ts::PrintFormat::kSExpression:
+    buffer_.push_back(')');
+    break;
+  case ts::PrintFormat::kJson:
+    if (frame.has_printed_children) {
+      buffer_.push_back(']');
+    }
+    buffer_.push_back('}');
+    break;
+  case ts::PrintFormat::kVerbose:
+    break;
+  }
+}
+
+auto ts::TreePrinter::EnterSExpression(const ts::TreeCursor &cursor,
+                                       const ts::Node &node,
+                                       const bool is_root) noexcept -> void {
+  if (!is_root) {
+    buffer_.push_back(' ');
+    const auto field_name = cursor.CurrentFieldName();
+    if (Has(ts::PrintField::kFieldName) && !field_name.empty()) {
+      buffer_.append(field_name);
+      buffer_.append(": ");
+    }
+  }
+
+  buffer_.push_back('(');
+  if (node.IsMissing()) {
+    buffer_.append("MISSING ");
+  }
+  if (node.IsNamed()) {
+    buffer_.append(node.Type());
+  } else {
+    WriteJsonString(node.Type());
+  }
+
+  if (Has(ts::PrintField::kSymbol)) {
+    buffer_.append(" symbol=");
+    WriteNumber(node.Symbol());
+  }
+  if (Has(ts::PrintField::kGrammar)) {
+    buffer_.append(" grammar_symbol=");
+    WriteNumber(node.GrammarSymbol());
+    buffer_.append(" grammar_type=");
+    buffer_.append(node.GrammarType());
+  }
+  if (Has(ts::PrintField::kChildIndex) && !is_root) {
+    buffer_.append(" index=");
+    WriteNumber(frames_[frames_.size() - 2].next_child_index - 1);
+  }
+  if (Has(ts::PrintField::kByteRange)) {
+    buffer_.append(" start_byte=");
+    WriteNumber(node.StartByte());
+    buffer_.append(" end_byte=");
+    WriteNumber(node.EndByte());
+  }
+  if (Has(ts::PrintField::kPointRange)) {
+    // Same as the output of `tree-sitter parse`.
+    const auto start_point = node.StartPoint();
+    const auto end_point = node.EndPoint();
+    buffer_.append(" [");
+    WriteNumber(start_point.row);
+    buffer_.append(", ");
+    WriteNumber(start_point.column);
+    buffer_.append("] - [");
+    WriteNumber(end_point.row);
+    buffer_.append(", ");
+    WriteNumber(end_point.column);
+    buffer_.push_back(']');
+  }
+  if (Has(ts::PrintField::kFlags)) {
+    buffer_.append(node.IsExtra() ? " extra" : "");
+    buffer_.append(node.HasChanges() ? " has_changes" : "");
+    buffer_.append(node.HasError() ? " has_error" : "");
+  }
+  if (Has(ts::PrintField::kDescendantCount)) {
+    buffer_.append(" descendant_count=");
+    WriteNumber(node.DescendantCount());
+  }
+  if (Has(ts::PrintField::kParseState)) {
+    buffer_.append(" parse_state=");
+    WriteNumber(node.ParseState());
+    buffer_.append(" next_parse_state=");
+    WriteNumber(node.NextParseState());
+  }
+}
+
+auto ts::TreePrinter::EnterJson(const ts::TreeCursor &cursor,
+                                const ts::Node &node,
+                                const bool is_root) noexcept -> void {
+  if (!is_root) {
+    // Skip the frames of the ancestors which are not printed.
+    auto parent = frames_.end() - 2;
+    while (!parent->is_printed) {
+      --parent;
+    }
+    buffer_.append(parent->has_printed_children ? "," : ",\"children\":[");
+    parent->has_printed_children = true;
+  }
+
+  // Every field is prefixed with a comma, so open with a field always printed.
+  buffer_.append("{\"type\":");
+  WriteJsonString(node.Type());
+
+  const auto field_name = cursor.CurrentFieldName();
+  if (Has(ts::PrintField::kFieldName) && !field_name.empty()) {
+    buffer_.append(",\"field_name\":");
+    WriteJsonString(field_name);
+  }
+  if (Has(ts::PrintField::kChildIndex) && !is_root) {
+    buffer_.append(",\"index\":");
+    WriteNumber(frames_[frames_.size() - 2].next_child_index - 1);
+  }
+  if (Has(ts::PrintField::kSymbol)) {
+    buffer_.append(",\"symbol\":");
+    WriteNumber(node.Symbol());
+  }
+  if (Has(ts::PrintField::kGrammar)) {
+    buffer_.append(",\"grammar_symbol\":");
+    WriteNumber(node.GrammarSymbol());
+    buffer_.append(",\"grammar_type\":");
+    WriteJsonString(node.GrammarType());
+  }
+  if (Has(ts::PrintField::kByteRange)) {
+    buffer_.append(",\"start_byte\":");
+    WriteNumber(node.StartByte());
+    buffer_.append(",\"end_byte\":");
+    WriteNumber(node.EndByte());
+  }
+  if (Has(ts::PrintField::kPointRange)) {
+    const auto start_point = node.StartPoint();
+    const auto end_point = node.EndPoint();
+    buffer_.append(",\"start_point\":{\"row\":");
+    WriteNumber(start_point.row);
+    buffer_.append(",\"column\":");
+    WriteNumber(start_point.column);
+    buffer_.append("},\"end_point\":{\"row\":");
+    WriteNumber(end_point.row);
+    buffer_.append(",\"column\":");
+    WriteNumber(end_point.column);
+    buffer_.push_back('}');
+  }
+  if (Has(ts::PrintField::kFlags)) {
+    const auto write_flag = [this](const std::string_view key,
+                                   const bool value) {
+      buffer_.append(key);
+      buffer_.append(value ? "true" : "false");
+    };
+    write_flag(",\"is_extra\":", node.IsExtra());
+    write_flag(",\"is_named\":", node.IsNamed());
+    write_flag(",\"is_missing\":", node.IsMissing());
+    write_flag(",\"has_changes\":", node.HasChanges());
+    write_flag(",\"has_error\":", node.HasError());
+    write_flag(",\"is_error\":", node.IsError());
+  }
+  if (Has(ts::PrintField::kDescendantCount)) {
+    buffer_.append(",\"descendant_count\":");
+    WriteNumber(node.DescendantCount());
+  }
+  if (Has(ts::PrintField::kParseState)) {
+    buffer_.append(",\"parse_state\":");
+    WriteNumber(node.ParseState());
+    buffer_.append(",\"next_parse_state\":");
+    WriteNumber(node.NextParseState());
+  }
+}
+
+auto ts::TreePrinter::EnterVerbose(const ts::TreeCursor &cursor,
+                                   const ts::Node &node,
+                                   const uint32_t child_index,
+                                   const bool is_root) noexcept -> void {
+  if (is_root) {
+    WriteVerboseNode(node);
+    // Close `Tree{root_node=` opened by `Print(const ts::Tree &)`.
+    if (is_tree_) {
+      buffer_.push_back('}');
+    }
+    if (node.ChildCount() != 0) {
+      buffer_.push_back('\n');
+    }
+    return;
+  }
+
+  buffer_.append(2 * (frames_.size() - 1), ' ');
+  buffer_.append("Child{");
+  if (Has(ts::PrintField::kChildIndex)) {
+    buffer_.append("index=");
+    WriteNumber(child_index);
+    buffer_.append(", ");
+  }
+  const auto field_name = cursor.CurrentFieldName();
+  if (Has(ts::PrintField::kFieldName) && !field_name.empty()) {
+    buffer_.append("field_name=");
+    buffer_.append(field_name);
+    buffer_.append(", ");
+  }
+  buffer_.append("node=");
+  WriteVerboseNode(node);
+  buffer_.append("}\n");
+}
+
+auto ts::TreePrinter::WriteVerboseNode(const ts::Node &node) noexcept -> void {
+  auto separator = std::string_view{};
+  const auto write_key = [this, &separator](const std::string_view key) {
+    buffer_.append(separator);
+    buffer_.append(key);
+    buffer_.push_back('=');
+    separator = ", ";
+  };
+
+  buffer_.append("Node{");
+  if (Has(ts::PrintField::kByteRange)) {
+    write_key("start_byte");
+    WriteNumber(node.StartByte());
+  }
+  if (Has(ts::PrintField::kPointRange)) {
+    write_key("start_point");
+    WritePoint(node.StartPoint());
+  }
+  if (Has(ts::PrintField::kByteRange)) {
+    write_key("end_byte");
+    WriteNumber(node.EndByte());
+  }
+  if (Has(ts::PrintField::kPointRange)) {
+    write_key("end_point");
+    WritePoint(node.EndPoint());
+  }
+  if (Has(ts::PrintField::kSymbol)) {
+    write_key("symbol");
+    WriteNumber(node.Symbol());
+  }
+  if (Has(ts::PrintField::kType)) {
+    write_key("type");
+    buffer_.append(node.Type());
+  }
+  if (Has(ts::PrintField::kGrammar)) {
+    write_key("grammar_symbol");
+    WriteNumber(node.GrammarSymbol());
+    write_key("grammar_type");
+    buffer_.append(node.GrammarType());
+  }
+  if (Has(ts::PrintField::kFlags)) {
+    write_key("is_null");
+    WriteNumber(node.IsNull());
+    write_key("is_extra");
+    WriteNumber(node.IsExtra());
+    write_key("is_named");
+    WriteNumber(node.IsNamed());
+    write_key("is_missing");
+    WriteNumber(node.IsMissing());
+    write_key("has_changes");
+    WriteNumber(node.HasChanges());
+    write_key("has_error");
+    WriteNumber(node.HasError());
+    write_key("is_error");
+    WriteNumber(node.IsError());
+  }
+  if (Has(ts::PrintField::kDescendantCount)) {
+    write_key("descendant_count");
+    WriteNumber(node.DescendantCount());
+  }
+  if (Has(ts::PrintField::kParseState)) {
+    write_key("parse_state");
+    WriteNumber(node.ParseState());
+    write_key("next_parse_state");
+    WriteNumber(node.NextParseState());
+  }
+  buffer_.push_back('}');
+}
+
+auto ts::TreePrinter::WriteJsonString(const std::string_view string) noexcept
+    -> void {
+  constexpr char kHexDigits[] = "0123456789abcdef";
+  buffer_.push_back('"');
+  for (const auto c : string) {
+    switch (c) {
+    case '"':
+      buffer_.append("\\\"");
+      break;
+    case '\\':
+      buffer_.append("\\\\");
+      break;
+    case '\n':
+      buffer_.append("\\n");
+      break;
+    case '\r':
+      buffer_.append("\\r");
+      break;
+    case '\t':
+      buffer_.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        buffer_.append("\\u00");
+        buffer_.push_back(kHexDigits[(c >> 4) & 0xf]);
+        buffer_.push_back(kHexDigits[c & 0xf]);
+      } else {
+        buffer_.push_back(c);
+      }
+      break;
+    }
+  }
+  buffer_.push_back('"');
+}
+
+auto ts::TreePrinter::WriteNumber(const uint64_t number) noexcept -> void {
+  char digits[20];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+  buffer_.append(digits, result.ptr);
+}
+
+auto ts::TreePrinter::WritePoint(const ts::Point &point) noexcept -> void {
+  buffer_.append("Point{row=");
+  WriteNumber(point.row);
+  buffer_.append(", column=");
+  WriteNumber(point.column);
+  buffer_.push_back('}');
+}
+
+auto ts::TreePrinter::Has(const ts::PrintField field) const noexcept -> bool {
+  return (options_.fields & field) != ts::PrintField::kNone;
+}
@@ -0,0 +1,131 @@
+#ifndef CPP_TREE_SITTER_PRINTER_H
+#define CPP_TREE_SITTER_PRINTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+
+namespace ts {
+
+// PrintFormat
+// --------
+
+enum class PrintFormat {
+  // e.g.) (source_file (function_definition name: (identifier)))
+  kSExpression,
+  // e.g.) {"type":"source_file","children":[{"type":"function_definition"}]}
+  kJson,
+  // The `Tree{root_node=Node{...}}` form of `ts::operator<<`.
+  kVerbose,
+};
+
+// PrintField
+// --------
+
+enum class PrintField : uint32_t {
+  kNone = 0,
+  // `type`
+  kType = 1u << 0,
+  // `symbol`
+  kSymbol = 1u << 1,
+  // `grammar_symbol`, `grammar_type`
+  kGrammar = 1u << 2,
+  // The field name of the node in its parent.
+  kFieldName = 1u << 3,
+  // The index of the node in its parent.
+  kChildIndex = 1u << 4,
+  // `start_byte`, `end_byte`
+  kByteRange = 1u << 5,
+  // `start_point`, `end_point`
+  kPointRange = 1u << 6,
+  // `is_null`, `is_extra`, `is_named`, `is_missing`, `has_changes`,
+  // `has_error`, `is_error`
+  kFlags = 1u << 7,
+  // `descendant_count`
+  kDescendantCount = 1u << 8,
+  // `parse_state`, `next_parse_state`
+  kParseState = 1u << 9,
+  kAll = (1u << 10) - 1,
+};
+
+constexpr auto operator|(const ts::PrintField lhs,
+                         const ts::PrintField rhs) noexcept -> ts::PrintField {
+  return static_cast<ts::PrintField>(static_cast<uint32_t>(lhs) |
+                                     static_cast<uint32_t>(rhs));
+}
+
+constexpr auto operator&(const ts::PrintField lhs,
+                         const ts::PrintField rhs) noexcept -> ts::PrintField {
+  return static_cast<ts::PrintField>(static_cast<uint32_t>(lhs) &
+                                     static_cast<uint32_t>(rhs));
+}
+
+// PrintOptions
+// --------
+
+struct PrintOptions {
+  ts::PrintFormat format = ts::PrintFormat::kSExpression;
+  ts::PrintField fields = ts::PrintField::kType | ts::PrintField::kFieldName;
+  // If it is set, anonymous nodes are not printed, but their named
+  // descendants are.
+  bool named_only = true;
+};
+
+// TreePrinter
+// --------
+
+// Prints a tree by walking it with a `ts::TreeCursor`, so printing is linear
+// in the number of nodes and is not limited by the depth of the tree.
+// The output is appended to an internal buffer that keeps its capacity across
+// `Clear` calls, so a printer can be reused for many trees.
+class TreePrinter {
+public:
+  explicit TreePrinter(const ts::PrintOptions &options) noexcept;
+  TreePrinter(const ts::TreePrinter &) = delete;
+  TreePrinter(ts::TreePrinter &&) noexcept = default;
+  ~TreePrinter() noexcept = default;
+
+  auto operator=(const ts::TreePrinter &) -> ts::TreePrinter & = delete;
+  auto operator=(ts::TreePrinter &&) noexcept -> ts::TreePrinter & = default;
+
+  auto Print(const ts::Tree &tree) noexcept -> void;
+  auto Print(const ts::Node &node) noexcept -> void;
+
+  auto Buffer() const noexcept -> std::string_view;
+  auto Clear() noexcept -> void;
+
+private:
+  struct Frame {
+    uint32_t next_child_index;
+    bool is_printed;
+    bool has_printed_children;
+  };
+
+  auto Enter(const ts::TreeCursor &cursor) noexcept -> void;
+  auto Leave(const ts::TreeCursor &cursor) noexcept -> void;
+
+  auto EnterSExpression(const ts::TreeCursor &cursor, const ts::Node &node,
+                        const bool is_root) noexcept -> void;
+  auto EnterJson(const ts::TreeCursor &cursor, const ts::Node &node,
+                 const bool is_root) noexcept -> void;
+  auto EnterVerbose(const ts::TreeCursor &cursor, const ts::Node &node,
+                    const uint32_t child_index, const bool is_root) noexcept
+      -> void;
+
+  auto WriteVerboseNode(const ts::Node &node) noexcept -> void;
+  auto WriteJsonString(const std::string_view string) noexcept -> void;
+  auto WriteNumber(const uint64_t number) noexcept -> void;
+  auto WritePoint(const ts::Point &point) noexcept -> void;
+  auto Has(const ts::PrintField field) const noexcept -> bool;
+
+  ts::PrintOptions options_;
+  std::string buffer_;
+  std::vector<ts::TreePrinter::Frame> frames_;
+  bool is_tree_ = false;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_PRINTER_H
@@ -0,0 +1,1074 @@
+#include "query.h"
+
+#include <regex.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <ranges>
+#include <string>
+
+using namespace ts;
+
+static_assert(std::ranges::forward_range<ts::QueryCaptures>);
+static_assert(std::ranges::input_range<ts::QueryMatches>);
+static_assert(std::ranges::input_range<ts::QueryMatchCaptures>);
+
+// TSQueryDeleter
+// --------
+
+void ts::TSQueryDeleter::operator()(TSQuery *ts_query_raw) const noexcept {
+  ts_query_delete(ts_query_raw);
+}
+
+// QueryPredicates
+// --------
+
+namespace {
+
+// A POSIX extended regular expression. It is matched in place with
+// `REG_STARTEND` where the C library has it, e.g.) glibc and the BSDs, and on
+// a NUL-terminated copy of the text otherwise, e.g.) musl.
+class Regex {
+public:
+  explicit Regex() noexcept = default;
+  Regex(const Regex &) = delete;
+  Regex(Regex &&) = delete;
+  ~Regex() noexcept {
+    if (is_compiled_) {
+      regfree(&regex_);
+    }
+  }
+
+  auto operator=(const Regex &) -> Regex & = delete;
+  auto operator=(Regex &&) -> Regex & = delete;
+
+  auto Compile(const std::string_view pattern) noexcept -> bool {
+    // `\d` and `\D` are common in Tree-sitter queries but not in POSIX.
+    auto translated = std::string{};
+    translated.reserve(pattern.size());
+    auto is_in_bracket = false;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      const auto c = pattern[i];
+      if (c == '\\' && i + 1 < pattern.size()) {
+        const auto next = pattern[i + 1];
+        if (next == 'd') {
+          translated.append(is_in_bracket ? "0-9" : "[0-9]");
+          ++i;
+          continue;
+        }
+        if (next == 'D' && !is_in_bracket) {
+          translated.append("[^0-9]");
+          ++i;
+          continue;
+        }
+        translated.push_back(c);
+        translated.push_back(next);
+        ++i;
+        continue;
+      }
+      if (c == '[' && !is_in_bracket) {
+        is_in_bracket = true;
+      } else if (c == ']' && is_in_bracket) {
+        is_in_bracket = false;
+      }
+      translated.push_back(c);
+    }
+    is_compiled_ =
+        regcomp(&regex_, translated.c_str(), REG_EXTENDED | REG_NOSUB) == 0;
+    return is_compiled_;
+  }
+
+  auto Matches(const std::string_view text) const noexcept -> bool {
+#ifdef REG_STARTEND
+    regmatch_t range{0, static_cast<regoff_t>(text.size())};
+    return regexec(&regex_, text.data(), 1, &range, REG_STARTEND) == 0;
+#else
+    const auto terminated_text = std::string{text};
+    return regexec(&regex_, terminated_text.c_str(), 0, nullptr, 0) == 0;
+#endif
+  }
+
+private:
+  regex_t regex_;
+  bool is_compiled_ = false;
+};
+
+// An open addressing hash set of the string literals of an `#any-of?`. The
+// strings are owned by the `TSQuery`.
+class StringSet {
+public:
+  auto Build(const std::span<const std::string_view> values) noexcept -> void {
+    auto capacity = size_t{4};
+    while (capacity < values.size() * 2) {
+      capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{0, std::string_view{}, false});
+    for (const auto value : values) {
+      const auto hash = Hash(value);
+      auto index = hash & (capacity - 1);
+      while (slots_[index].is_used) {
+        if (slots_[index].hash == hash && slots_[index].value == value) {
+          break;
+        }
+        index = (index + 1) & (capacity - 1);
+      }
+      slots_[index] = Slot{hash, value, true};
+    }
+  }
+
+  auto Contains(const std::string_view value) const noexcept -> bool {
+    const auto mask = slots_.size() - 1;
+    const auto hash = Hash(value);
+    for (auto index = hash & mask; slots_[index].is_used;
+         index = (index + 1) & mask) {
+      if (slots_[index].hash == hash && slots_[index].value == value) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Slot {
+    uint64_t hash;
+    std::string_view value;
+    bool is_used;
+  };
+
+  // FNV-1a
+  static auto Hash(const std::string_view value) noexcept -> uint64_t {
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto c : value) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  std::vector<Slot> slots_;
+};
+
+enum class Opcode : uint8_t {
+  // operand: index of `strings_`
+  kEqString,
+  // operand: capture id
+  kEqCapture,
+  // operand: index of `regexes_`
+  kMatch,
+  // operand: index of `string_sets_`
+  kAnyOf,
+};
+
+struct Instruction {
+  Opcode opcode;
+  bool is_positive;
+  // `#eq?` requires all the nodes of a quantified capture to satisfy the
+  // predicate, `#any-eq?` requires one of them to.
+  bool is_match_all_nodes;
+  uint32_t capture_id;
+  uint32_t operand;
+};
+
+auto NodeText(const TSNode &node, const std::string_view source) noexcept
+    -> std::string_view {
+  const auto start_byte = std::min<size_t>(ts_node_start_byte(node),
+                                           source.size());
+  const auto end_byte = std::min<size_t>(ts_node_end_byte(node), source.size());
+  return source.substr(start_byte, end_byte - start_byte);
+}
+
+} // namespace
+
+class ts::QueryPredicates {
+public:
+  // If a predicate is invalid, it returns the index of its pattern.
+  static constexpr uint32_t kValid = UINT32_MAX;
+  auto Compile(const TSQuery *ts_query) noexcept -> uint32_t;
+
+  auto Evaluate(const TSQueryMatch &match,
+                const std::string_view source) const noexcept -> bool;
+
+  auto GeneralPredicates(const uint32_t pattern_index) const noexcept
+      -> std::span<const ts::QueryPredicate>;
+
+private:
+  auto CompilePredicate(const TSQuery *ts_query,
+                        const std::span<const TSQueryPredicateStep> steps,
+                        std::vector<ts::QueryPredicateArgument> &arguments)
+      -> bool;
+
+  // The instructions and the general predicates of the pattern `i` are in
+  // `[offsets[i], offsets[i + 1])`.
+  std::vector<uint32_t> instruction_offsets_;
+  std::vector<Instruction> instructions_;
+  std::vector<std::string_view> strings_;
+  std::vector<std::unique_ptr<Regex>> regexes_;
+  std::vector<StringSet> string_sets_;
+  std::vector<uint32_t> general_predicate_offsets_;
+  std::vector<ts::QueryPredicate> general_predicates_;
+};
+
+auto ts::QueryPredicates::Compile(const TSQuery *ts_query) noexcept
+    -> uint32_t {
+  const auto pattern_count = ts_query_pattern_count(ts_query);
+  instruction_offsets_.reserve(pattern_count + 1);
+  general_predicate_offsets_.reserve(pattern_count + 1);
+
+  auto arguments = std::vector<ts::QueryPredicateArgument>{};
+  for (uint32_t pattern_index = 0; pattern_index < pattern_count;
+       ++pattern_index) {
+    instruction_offsets_.push_back(
+        static_cast<uint32_t>(instructions_.size()));
+    general_predicate_offsets_.push_back(
+        static_cast<uint32_t>(general_predicates_.size()));
+
+    uint32_t step_count = 0;
+    const auto steps =
+        ts_query_predicates_for_pattern(ts_query, pattern_index, &step_count);
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i < step_count; ++i) {
+      if (steps[i].type != TSQueryPredicateStepTypeDone) {
+        continue;
+      }
+      if (!CompilePredicate(ts_query,
+                            std::span{steps + begin, steps + i}, arguments)) {
+        return pattern_index;
+      }
+      begin = i + 1;
+    }
+  }
+  instruction_offsets_.push_back(static_cast<uint32_t>(instructions_.size()));
+  general_predicate_offsets_.push_back(
+      static_cast<uint32_t>(general_predicates_.size()));
+  return kValid;
+}
+
+auto ts::QueryPredicates::CompilePredicate(
+    const TSQuery *ts_query, const std::span<const TSQueryPredicateStep> steps,
+    std::vector<ts::QueryPredicateArgument> &arguments) -> bool {
+  if (steps.empty() || steps[0].type != TSQueryPredicateStepTypeString) {
+    return false;
+  }
+
+  const auto value_for_step = [ts_query](const TSQueryPredicateStep &step) {
+    uint32_t length = 0;
+    const auto value =
+        step.type == TSQueryPredicateStepTypeCapture
+            ? ts_query_capture_name_for_id(ts_query, step.value_id, &length)
+            : ts_query_string_value_for_id(ts_query, step.value_id, &length);
+    return std::string_view{value, length};
+  };
+
+  const auto name = value_for_step(steps[0]);
+  arguments.clear();
+  for (const auto &step : steps.subspan(1)) {
+    arguments.push_back(ts::QueryPredicateArgument{
+        step.type == TSQueryPredicateStepTypeCapture, step.value_id,
+        value_for_step(step)});
+  }
+
+  const auto is_positive = !name.starts_with("not-") &&
+                           name.find("-not-") == std::string_view::npos;
+  const auto is_match_all_nodes = !name.starts_with("any-");
+
+  if (name == "eq?" || name == "not-eq?" || name == "any-eq?" ||
+      name == "any-not-eq?") {
+    if (arguments.size() != 2 || !arguments[0].is_capture) {
+      return false;
+    }
+    if (arguments[1].is_capture) {
+      instructions_.push_back(Instruction{Opcode::kEqCapture, is_positive,
+                                          is_match_all_nodes,
+                                          arguments[0].capture_id,
+                                          arguments[1].capture_id});
+    } else {
+      instructions_.push_back(Instruction{
+          Opcode::kEqString, is_positive, is_match_all_nodes,
+          arguments[0].capture_id, static_cast<uint32_t>(strings_.size())});
+      strings_.push_back(arguments[1].value);
+    }
+    return true;
+  }
+
+  if (name == "match?" || name == "not-match?" || name == "any-match?" ||
+      name == "any-not-match?") {
+    if (arguments.size() != 2 || !arguments[0].is_capture ||
+        arguments[1].is_capture) {
+      return false;
+    }
+    auto regex = std::make_unique<Regex>();
+    if (!regex->Compile(arguments[1].value)) {
+      return false;
+    }
+    instructions_.push_back(Instruction{
+        Opcode::kMatch, is_positive, is_match_all_nodes,
+        arguments[0].capture_id, static_cast<uint32_t>(regexes_.size())});
+    regexes_.push_back(std::move(regex));
+    return true;
+  }
+
+  if (name == "any-of?" || name == "not-any-of?") {
+    if (arguments.size() < 2 || !arguments[0].is_capture) {
+      return false;
+    }
+    auto values = std::vector<std::string_view>{};
+    values.reserve(arguments.size() - 1);
+    for (const auto &argument : std::span{arguments}.subspan(1)) {
+      if (argument.is_capture) {
+        return false;
+      }
+      values.push_back(argument.value);
+    }
+    string_sets_.emplace_back().Build(values);
+    instructions_.push_back(Instruction{
+        Opcode::kAnyOf, name == "any-of?", true, arguments[0].capture_id,
+        static_cast<uint32_t>(string_sets_.size() - 1)});
+    return true;
+  }
+
+  general_predicates_.push_back(ts::QueryPredicate{name, arguments});
+  return true;
+}
+
+auto ts::QueryPredicates::Evaluate(
+    const TSQueryMatch &match, const std::string_view source) const noexcept
+    -> bool {
+  const auto begin = instructions_.begin() +
+                     instruction_offsets_[match.pattern_index];
+  const auto end = instructions_.begin() +
+                   instruction_offsets_[match.pattern_index + 1];
+  const auto captures = std::span{match.captures, match.capture_count};
+
+  // Same semantics as the Rust binding: quantified captures are checked node
+  // by node, and a capture without nodes satisfies the predicate.
+  const auto check_nodes = [&captures](const Instruction &instruction,
+                                       const auto &is_satisfied) -> bool {
+    for (const auto &capture : captures) {
+      if (capture.index != instruction.capture_id) {
+        continue;
+      }
+      const auto result = is_satisfied(capture.node);
+      if (result != instruction.is_positive && instruction.is_match_all_nodes) {
+        return false;
+      }
+      if (result == instruction.is_positive &&
+          !instruction.is_match_all_nodes) {
+        return true;
+      }
+    }
+    return true;
+  };
+
+  for (auto it = begin; it != end; ++it) {
+    const auto &instruction = *it;
+    auto is_satisfied = true;
+    switch (instruction.opcode) {
+    case Opcode::kEqString: {
+      const auto string = strings_[instruction.operand];
+      is_satisfied = check_nodes(instruction, [&](const TSNode &node) {
+        return NodeText(node, source) == string;
+      });
+      break;
+    }
+    case Opcode::kEqCapture: {
+      auto lhs = captures.begin();
+      auto rhs = captures.begin();
+      const auto next = [&captures](auto it, const uint32_t capture_id) {
+        while (it != captures.end() && it->index != capture_id) {
+          ++it;
+        }
+        return it;
+      };
+      is_satisfied = true;
+      auto is_decided = false;
+      for (lhs = next(lhs, instruction.capture_id),
+          rhs = next(rhs, instruction.operand);
+           lhs != captures.end() && rhs != captures.end();
+           lhs = next(lhs + 1, instruction.capture_id),
+          rhs = next(rhs + 1, instruction.operand)) {
+        const auto is_equal =
+            NodeText(lhs->node, source) == NodeText(rhs->node, source);
+        if (is_equal != instruction.is_positive &&
+            instruction.is_match_all_nodes) {
+          is_satisfied = false;
+          is_decided = true;
+          break;
+        }
+        if (is_equal == instruction.is_positive &&
+            !instruction.is_match_all_nodes) {
+          is_decided = true;
+          break;
+        }
+      }
+      if (!is_decided) {
+        // Both captures must have the same number of nodes.
+        is_satisfied = (lhs == captures.end()) == (rhs == captures.end());
+      }
+      break;
+    }
+    case Opcode::kMatch: {
+      const auto &regex = *regexes_[instruction.operand];
+      is_satisfied = check_nodes(instruction, [&](const TSNode &node) {
+        return regex.Matches(NodeText(node, source));
+      });
+      break;
+    }
+    case Opcode::kAnyOf: {
+      const auto &string_set = string_sets_[instruction.operand];
+      is_satisfied = check_nodes(instruction, [&](const TSNode &node) {
+        return string_set.Contains(NodeText(node, source));
+      });
+      break;
+    }
+    }
+    if (!is_satisfied) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto ts::QueryPredicates::GeneralPredicates(
+    const uint32_t pattern_index) const noexcept
+    -> std::span<const ts::QueryPredicate> {
+  const auto begin = general_predicate_offsets_[pattern_index];
+  const auto end = general_predicate_offsets_[pattern_index + 1];
+  return std::span{general_predicates_}.subspan(begin, end - begin);
+}
+
+// Query
+// --------
+
+ts::Query::Query(ts::TSQueryPtr &&ts_query,
+                 std::unique_ptr<ts::QueryPredicates> &&predicates) noexcept
+    : ts_query_{std::move(ts_query)}, predicates_{std::move(predicates)} {}
+
+ts::Query::Query(ts::Query &&) noexcept = default;
+
+ts::Query::~Query() noexcept = default;
+
+auto ts::Query::operator=(ts::Query &&) noexcept -> ts::Query & = default;
+
+auto ts::Query::New(const ts::Language &language,
+                    const std::string_view source, uint32_t &error_offset,
+                    ts::QueryError &error_type) noexcept -> ts::Query {
+  auto ts_query = ts::TSQueryPtr{
+      ts_query_new(language.AsRaw(), source.data(),
+                   static_cast<uint32_t>(source.size()), &error_offset,
+                   &error_type)};
+  if (ts_query.get() == nullptr) {
+    return ts::Query::Null();
+  }
+
+  auto predicates = std::make_unique<ts::QueryPredicates>();
+  const auto invalid_pattern_index = predicates->Compile(ts_query.get());
+  if (invalid_pattern_index != ts::QueryPredicates::kValid) {
+    error_offset = ts_query_start_byte_for_pattern(ts_query.get(),
+                                                   invalid_pattern_index);
+    error_type = kErrorPredicate;
+    return ts::Query::Null();
+  }
+  return ts::Query{std::move(ts_query), std::move(predicates)};
+}
+
+auto ts::Query::PatternCount() const noexcept -> uint32_t {
+  assert(!IsNull() && "Query::PatternCount: query is null");
+  return ts_query_pattern_count(ts_query_.get());
+}
+
+auto ts::Query::CaptureCount() const noexcept -> uint32_t {
+  assert(!IsNull() && "Query::CaptureCount: query is null");
+  return ts_query_capture_count(ts_query_.get());
+}
+
+auto ts::Query::StringCount() const noexcept -> uint32_t {
+  assert(!IsNull() && "Query::StringCount: query is null");
+  return ts_query_string_count(ts_query_.get());
+}
+
+auto ts::Query::StartByteForPattern(const uint32_t pattern_index) const noexcept
+    -> uint32_t {
+  assert(!IsNull() && "Query::StartByteForPattern: query is null");
+  return ts_query_start_byte_for_pattern(ts_query_.get(), pattern_index);
+}
+
+auto ts::Query::IsPatternRooted(const uint32_t pattern_index) const noexcept
+    -> bool {
+  assert(!IsNull() && "Query::IsPatternRooted: query is null");
+  return ts_query_is_pattern_rooted(ts_query_.get(), pattern_index);
+}
+
+auto ts::Query::IsPatternNonLocal(const uint32_t pattern_index) const noexcept
+    -> bool {
+  assert(!IsNull() && "Query::IsPatternNonLocal: query is null");
+  return ts_query_is_pattern_non_local(ts_query_.get(), pattern_index);
+}
+
+auto ts::Query::PatternDepth(const uint32_t pattern_index) const noexcept
+    -> uint32_t {
+  assert(!IsNull() && "Query::PatternDepth: query is null");
+  return ts_query_pattern_depth(ts_query_.get(), pattern_index);
+}
+
+auto ts::Query::IsPatternGuaranteedAtStep(
+    const uint32_t byte_offset) const noexcept -> bool {
+  assert(!IsNull() && "Query::IsPatternGuaranteedAtStep: query is null");
+  return ts_query_is_pattern_guaranteed_at_step(ts_query_.get(), byte_offset);
+}
+
+auto ts::Query::CaptureNameForId(const uint32_t capture_id) const noexcept
+    -> std::string_view {
+  assert(!IsNull() && "Query::CaptureNameForId: query is null");
+  uint32_t length = 0;
+  const auto name =
+      ts_query_capture_name_for_id(ts_query_.get(), capture_id, &length);
+  return name != nullptr ? std::string_view{name, length} : std::string_view{};
+}
+
+auto ts::Query::CaptureQuantifierForId(const uint32_t pattern_index,
+                                       const uint32_t capture_id) const noexcept
+    -> ts::Quantifier {
+  assert(!IsNull() && "Query::CaptureQuantifierForId: query is null");
+  return ts_query_capture_quantifier_for_id(ts_query_.get(), pattern_index,
+                                            capture_id);
+}
+
+auto ts::Query::StringValueForId(const uint32_t string_id) const noexcept
+    -> std::string_view {
+  assert(!IsNull() && "Query::StringValueForId: query is null");
+  uint32_t length = 0;
+  const auto value =
+      ts_query_string_value_for_id(ts_query_.get(), string_id, &length);
+  return value != nullptr ? std::string_view{value, length}
+                          : std::string_view{};
+}
+
+auto ts::Query::CaptureIdForName(const std::string_view name) const noexcept
+    -> uint32_t {
+  assert(!IsNull() && "Query::CaptureIdForName: query is null");
+  const auto capture_count = CaptureCount();
+  for (uint32_t i = 0; i < capture_count; ++i) {
+    if (CaptureNameForId(i) == name) {
+      return i;
+    }
+  }
+  return kCaptureNotFound;
+}
+
+auto ts::Query::DisableCapture(const std::string_view name) noexcept -> void {
+  assert(!IsNull() && "Query::DisableCapture: query is null");
+  ts_query_disable_capture(ts_query_.get(), name.data(),
+                           static_cast<uint32_t>(name.size()));
+}
+
+auto ts::Query::DisablePattern(const uint32_t pattern_index) noexcept -> void {
+  assert(!IsNull() && "Query::DisablePattern: query is null");
+  ts_query_disable_pattern(ts_query_.get(), pattern_index);
+}
+
+auto ts::Query::GeneralPredicates(const uint32_t pattern_index) const noexcept
+    -> std::span<const ts::QueryPredicate> {
+  assert(!IsNull() && "Query::GeneralPredicates: query is null");
+  assert(pattern_index < PatternCount() &&
+         "Query::GeneralPredicates: pattern_index out of range");
+  return predicates_->GeneralPredicates(pattern_index);
+}
+
+auto ts::Query::SatisfiesTextPredicates(
+    const ts::QueryMatch &match, const std::string_view source) const noexcept
+    -> bool {
+  assert(!IsNull() && "Query::SatisfiesTextPredicates: query is null");
+  return predicates_->Evaluate(match.AsRaw(), source);
+}
+
+auto ts::Query::IsNull() const noexcept -> bool {
+  return ts_query_.get() == nullptr;
+}
+
+auto ts::Query::AsRaw() const noexcept -> const TSQuery * {
+  return ts_query_.get();
+}
+
+auto ts::Query::Null() noexcept -> ts::Query {
+  return ts::Query{ts::TSQueryPtr{nullptr}, nullptr};
+}
+
+// QueryCapture
+// --------
+
+ts::QueryCapture::QueryCapture(const TSQueryCapture &ts_query_capture) noexcept
+    : ts_query_capture_{ts_query_capture} {}
+
+auto ts::QueryCapture::Node() const noexcept -> ts::Node {
+  return ts::Node{TSNode{ts_query_capture_.node}};
+}
+
+auto ts::QueryCapture::Index() const noexcept -> uint32_t {
+  return ts_query_capture_.index;
+}
+
+auto ts::QueryCapture::AsRaw() const noexcept -> const TSQueryCapture & {
+  return ts_query_capture_;
+}
+
+// QueryCaptures
+// --------
+
+ts::QueryCaptures::Iterator::Iterator(
+    const TSQueryCapture *ts_query_capture) noexcept
+    : ts_query_capture_{ts_query_capture} {}
+
+auto ts::QueryCaptures::Iterator::operator*() const noexcept
+    -> ts::QueryCapture {
+  return ts::QueryCapture{*ts_query_capture_};
+}
+
+auto ts::QueryCaptures::Iterator::operator++() noexcept -> Iterator & {
+  ++ts_query_capture_;
+  return *this;
+}
+
+auto ts::QueryCaptures::Iterator::operator++(int) noexcept -> Iterator {
+  auto previous = *this;
+  ++ts_query_capture_;
+  return previous;
+}
+
+ts::QueryCaptures::QueryCaptures(const TSQueryCapture *ts_query_captures,
+                                 const uint32_t size) noexcept
+    : ts_query_captures_{ts_query_captures}, size_{size} {}
+
+auto ts::QueryCaptures::begin() const noexcept -> Iterator {
+  return Iterator{ts_query_captures_};
+}
+
+auto ts::QueryCaptures::end() const noexcept -> Iterator {
+  return Iterator{ts_query_captures_ + size_};
+}
+
+auto ts::QueryCaptures::size() const noexcept -> uint32_t { return size_; }
+
+auto ts::QueryCaptures::empty() const noexcept -> bool { return size_ == 0; }
+
+auto ts::QueryCaptures::operator[](const uint32_t index) const noexcept
+    -> ts::QueryCapture {
+  assert(index < size_ && "QueryCaptures::operator[]: index out of range");
+  return ts::QueryCapture{ts_query_captures_[index]};
+}
+
+// QueryMatch
+// --------
+
+ts::QueryMatch::QueryMatch() noexcept : ts_query_match_{0, 0, 0, nullptr} {}
+
+ts::QueryMatch::QueryMatch(const TSQueryMatch &ts_query_match) noexcept
+    : ts_query_match_{ts_query_match} {}
+
+auto ts::QueryMatch::Id() const noexcept -> uint32_t {
+  return ts_query_match_.id;
+}
+
+auto ts::QueryMatch::PatternIndex() const noexcept -> uint32_t {
+  return ts_query_match_.pattern_index;
+}
+
+auto ts::QueryMatch::Captures() const noexcept -> ts::QueryCaptures {
+  return ts::QueryCaptures{ts_query_match_.captures,
+                           ts_query_match_.capture_count};
+}
+
+auto ts::QueryMatch::AsRaw() noexcept -> TSQueryMatch & {
+  return ts_query_match_;
+}
+
+auto ts::QueryMatch::AsRaw() const noexcept -> const TSQueryMatch & {
+  return ts_query_match_;
+}
+
+// QueryMatchCapture
+// --------
+
+ts::QueryMatchCapture::QueryMatchCapture() noexcept
+    : match_{}, capture_index_{0} {}
+
+auto ts::QueryMatchCapture::Match() const noexcept -> const ts::QueryMatch & {
+  return match_;
+}
+
+auto ts::QueryMatchCapture::CaptureIndex() const noexcept -> uint32_t {
+  return capture_index_;
+}
+
+auto ts::QueryMatchCapture::Capture() const noexcept -> ts::QueryCapture {
+  return match_.Captures()[capture_index_];
+}
+
+// QueryMatches
+// --------
+
+ts::QueryMatches::Iterator::Iterator(ts::QueryMatches *matches) noexcept
+    : matches_{matches} {}
+
+auto ts::QueryMatches::Iterator::operator*() const noexcept
+    -> const ts::QueryMatch & {
+  return matches_->match_;
+}
+
+auto ts::QueryMatches::Iterator::operator++() noexcept -> Iterator & {
+  matches_->is_done_ = !matches_->cursor_->NextMatch(matches_->match_);
+  return *this;
+}
+
+auto ts::QueryMatches::Iterator::operator++(int) noexcept -> void { ++*this; }
+
+auto ts::QueryMatches::Iterator::operator==(
+    std::default_sentinel_t) const noexcept -> bool {
+  return matches_->is_done_;
+}
+
+ts::QueryMatches::QueryMatches(ts::QueryCursor &cursor) noexcept
+    : cursor_{&cursor}, match_{}, is_done_{false} {}
+
+auto ts::QueryMatches::begin() noexcept -> Iterator {
+  auto iterator = Iterator{this};
+  ++iterator;
+  return iterator;
+}
+
+auto ts::QueryMatches::end() const noexcept -> std::default_sentinel_t {
+  return std::default_sentinel;
+}
+
+// QueryMatchCaptures
+// --------
+
+ts::QueryMatchCaptures::Iterator::Iterator(
+    ts::QueryMatchCaptures *captures) noexcept
+    : captures_{captures} {}
+
+auto ts::QueryMatchCaptures::Iterator::operator*() const noexcept
+    -> const ts::QueryMatchCapture & {
+  return captures_->match_capture_;
+}
+
+auto ts::QueryMatchCaptures::Iterator::operator++() noexcept -> Iterator & {
+  captures_->is_done_ =
+      !captures_->cursor_->NextCapture(captures_->match_capture_);
+  return *this;
+}
+
+auto ts::QueryMatchCaptures::Iterator::operator++(int) noexcept -> void {
+  ++*this;
+}
+
+auto ts::QueryMatchCaptures::Iterator::operator==(
+    std::default_sentinel_t) const noexcept -> bool {
+  return captures_->is_done_;
+}
+
+ts::QueryMatchCaptures::QueryMatchCaptures(ts::QueryCursor &cursor) noexcept
+    : cursor_{&cursor}, match_capture_{}, is_done_{false} {}
+
+auto ts::QueryMatchCaptures::begin() noexcept -> Iterator {
+  auto iterator = Iterator{this};
+  ++iterator;
+  return iterator;
+}
+
+auto ts::QueryMatchCaptures::end() const noexcept -> std::default_sentinel_t {
+  return std::default_sentinel;
+}
+
+// TSQueryCursorDeleter
+// --------
+
+void ts::TSQueryCursorDeleter::operator()(
+    TSQueryCursor *ts_query_cursor_raw) const noexcept {
+  ts_query_cursor_delete(ts_query_cursor_raw);
+}
+
+// QueryCursor
+// --------
+
+ts::QueryCursor::QueryCursor() noexcept
+    : ts_query_cursor_{ts_query_cursor_new()}, query_{nullptr}, source_{},
+      cancellation_token_{ts::CancellationToken::Null()},
+      was_cancelled_{false} {}
+
+auto ts::QueryCursor::Exec(const ts::Query &query,
+                           const ts::Node &node) noexcept -> void {
+  assert(!IsNull() && "QueryCursor::Exec: cursor is null");
+  assert(!query.IsNull() && "QueryCursor::Exec: query is null");
+  query_ = nullptr;
+  source_ = std::string_view{};
+  was_cancelled_ = false;
+  ts_query_cursor_exec(ts_query_cursor_.get(), query.AsRaw(), node.AsRaw());
+}
+
+auto ts::QueryCursor::Exec(const ts::Query &query, const ts::Node &node,
+                           const std::string_view source) noexcept -> void {
+  assert(!IsNull() && "QueryCursor::Exec: cursor is null");
+  assert(!query.IsNull() && "QueryCursor::Exec: query is null");
+  query_ = &query;
+  source_ = source;
+  was_cancelled_ = false;
+  ts_query_cursor_exec(ts_query_cursor_.get(), query.AsRaw(), node.AsRaw());
+}
+
+auto ts::QueryCursor::DidExceedMatchLimit() const noexcept -> bool {
+  assert(!IsNull() && "QueryCursor::DidExceedMatchLimit: cursor is null");
+  return ts_query_cursor_did_exceed_match_limit(ts_query_cursor_.get());
+}
+
+auto ts::QueryCursor::MatchLimit() const noexcept -> uint32_t {
+  assert(!IsNull() && "QueryCursor::MatchLimit: cursor is null");
+  return ts_query_cursor_match_limit(ts_query_cursor_.get());
+}
+
+auto ts::QueryCursor::SetMatchLimit(const uint32_t limit) noexcept -> void {
+  assert(!IsNull() && "QueryCursor::SetMatchLimit: cursor is null");
+  ts_query_cursor_set_match_limit(ts_query_cursor_.get(), limit);
+}
+
+auto ts::QueryCursor::SetByteRange(const uint32_t start_byte,
+                                   const uint32_t end_byte) noexcept -> void {
+  assert(!IsNull() && "QueryCursor::SetByteRange: cursor is null");
+  ts_query_cursor_set_byte_range(ts_query_cursor_.get(), start_byte, end_byte);
+}
+
+auto ts::QueryCursor::SetPointRange(const ts::Point start_point,
+                                    const ts::Point end_point) noexcept
+    -> void {
+  assert(!IsNull() && "QueryCursor::SetPointRange: cursor is null");
+  ts_query_cursor_set_point_range(ts_query_cursor_.get(), start_point,
+                                  end_point);
+}
+
+auto ts::QueryCursor::SetMaxStartDepth(const uint32_t max_start_depth) noexcept
+    -> void {
+  assert(!IsNull() && "QueryCursor::SetMaxStartDepth: cursor is null");
+  ts_query_cursor_set_max_start_depth(ts_query_cursor_.get(), max_start_depth);
+}
+
+auto ts::QueryCursor::SetCancellationToken(
+    const ts::CancellationToken &token) noexcept -> void {
+  assert(!IsNull() && "QueryCursor::SetCancellationToken: cursor is null");
+  cancellation_token_ = token;
+}
+
+auto ts::QueryCursor::AccessCancellationToken() const noexcept
+    -> const ts::CancellationToken & {
+  assert(!IsNull() && "QueryCursor::AccessCancellationToken: cursor is null");
+  return cancellation_token_;
+}
+
+auto ts::QueryCursor::WasCancelled() const noexcept -> bool {
+  assert(!IsNull() && "QueryCursor::WasCancelled: cursor is null");
+  return was_cancelled_;
+}
+
+auto ts::QueryCursor::NextMatch(ts::QueryMatch &match) noexcept -> bool {
+  assert(!IsNull() && "QueryCursor::NextMatch: cursor is null");
+  while (!IsCancelled() &&
+         ts_query_cursor_next_match(ts_query_cursor_.get(), &match.AsRaw())) {
+    if (SatisfiesTextPredicates(match)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ts::QueryCursor::NextCapture(
+    ts::QueryMatchCapture &match_capture) noexcept -> bool {
+  assert(!IsNull() && "QueryCursor::NextCapture: cursor is null");
+  while (!IsCancelled() &&
+         ts_query_cursor_next_capture(ts_query_cursor_.get(),
+                                      &match_capture.match_.AsRaw(),
+                                      &match_capture.capture_index_)) {
+    if (SatisfiesTextPredicates(match_capture.match_)) {
+      return true;
+    }
+    // Drop the rest of the captures of the rejected match.
+    ts_query_cursor_remove_match(ts_query_cursor_.get(),
+                                 match_capture.match_.Id());
+  }
+  return false;
+}
+
+auto ts::QueryCursor::RemoveMatch(const uint32_t match_id) noexcept -> void {
+  assert(!IsNull() && "QueryCursor::RemoveMatch: cursor is null");
+  ts_query_cursor_remove_match(ts_query_cursor_.get(), match_id);
+}
+
+auto ts::QueryCursor::Matches() noexcept -> ts::QueryMatches {
+  assert(!IsNull() && "QueryCursor::Matches: cursor is null");
+  return ts::QueryMatches{*this};
+}
+
+auto ts::QueryCursor::Captures() noexcept -> ts::QueryMatchCaptures {
+  assert(!IsNull() && "QueryCursor::Captures: cursor is null");
+  return ts::QueryMatchCaptures{*this};
+}
+
+auto ts::QueryCursor::IsNull() const noexcept -> bool {
+  return ts_query_cursor_.get() == nullptr;
+}
+
+auto ts::QueryCursor::AsRaw() noexcept -> TSQueryCursor * {
+  return ts_query_cursor_.get();
+}
+
+auto ts::QueryCursor::IsCancelled() noexcept -> bool {
+  if (!was_cancelled_ && !cancellation_token_.IsNull()) {
+    was_cancelled_ = cancellation_token_.IsCancelled();
+  }
+  return was_cancelled_;
+}
+
+auto ts::QueryCursor::SatisfiesTextPredicates(
+    const ts::QueryMatch &match) const noexcept -> bool {
+  return query_ == nullptr || query_->SatisfiesTextPredicates(match, source_);
+}
+
+// QueryMatchList
+// --------
+
+namespace {
+
+// Nodes are ordered by their position, then by their identity, which is
+// stable within a tree.
+auto CompareCaptures(const ts::QueryCapture &capture,
+                     const ts::QueryCapture &other) noexcept
+    -> std::weak_ordering {
+  const auto &node = capture.AsRaw().node;
+  const auto &other_node = other.AsRaw().node;
+  if (const auto order =
+          ts_node_start_byte(node) <=> ts_node_start_byte(other_node);
+      order != 0) {
+    return order;
+  }
+  if (const auto order =
+          ts_node_end_byte(node) <=> ts_node_end_byte(other_node);
+      order != 0) {
+    return order;
+  }
+  if (const auto order = capture.Index() <=> other.Index(); order != 0) {
+    return order;
+  }
+  return std::compare_three_way{}(node.id, other_node.id);
+}
+
+} // namespace
+
+ts::QueryMatchList::QueryMatchList() noexcept : entries_{}, captures_{} {}
+
+auto ts::QueryMatchList::Append(const ts::QueryMatch &match) noexcept -> void {
+  const auto captures = match.Captures();
+  auto start_byte = captures.empty() ? 0 : UINT32_MAX;
+  for (const auto capture : captures) {
+    start_byte = std::min(start_byte, capture.Node().StartByte());
+  }
+  entries_.push_back(ts::QueryMatchList::Entry{
+      match.PatternIndex(), start_byte,
+      static_cast<uint32_t>(captures_.size()), captures.size()});
+  captures_.insert(captures_.end(), captures.begin(), captures.end());
+}
+
+auto ts::QueryMatchList::Append(const ts::QueryMatchList &list,
+                                const size_t index) noexcept -> void {
+  auto entry = list.entries_[index];
+  const auto captures = list.Captures(index);
+  entry.capture_offset = static_cast<uint32_t>(captures_.size());
+  entries_.push_back(entry);
+  captures_.insert(captures_.end(), captures.begin(), captures.end());
+}
+
+auto ts::QueryMatchList::AppendAll(ts::QueryCursor &cursor) noexcept -> void {
+  auto match = ts::QueryMatch{};
+  while (cursor.NextMatch(match)) {
+    Append(match);
+  }
+}
+
+auto ts::QueryMatchList::Clear() noexcept -> void {
+  entries_.clear();
+  captures_.clear();
+}
+
+auto ts::QueryMatchList::Sort() noexcept -> void {
+  // Only the entries move. The captures stay where they were appended.
+  std::sort(entries_.begin(), entries_.end(),
+            [this](const ts::QueryMatchList::Entry &a,
+                   const ts::QueryMatchList::Entry &b) {
+              return CompareEntries(*this, a, *this, b) < 0;
+            });
+}
+
+auto ts::QueryMatchList::Size() const noexcept -> size_t {
+  return entries_.size();
+}
+
+auto ts::QueryMatchList::PatternIndex(const size_t index) const noexcept
+    -> uint32_t {
+  return entries_[index].pattern_index;
+}
+
+auto ts::QueryMatchList::StartByte(const size_t index) const noexcept
+    -> uint32_t {
+  return entries_[index].start_byte;
+}
+
+auto ts::QueryMatchList::Captures(const size_t index) const noexcept
+    -> std::span<const ts::QueryCapture> {
+  return EntryCaptures(entries_[index]);
+}
+
+auto ts::QueryMatchList::Compare(const ts::QueryMatchList &list,
+                                 const size_t index,
+                                 const ts::QueryMatchList &other,
+                                 const size_t other_index) noexcept
+    -> std::weak_ordering {
+  return CompareEntries(list, list.entries_[index], other,
+                        other.entries_[other_index]);
+}
+
+auto ts::QueryMatchList::operator==(
+    const ts::QueryMatchList &other) const noexcept -> bool {
+  if (Size() != other.Size()) {
+    return false;
+  }
+  for (size_t i = 0; i < Size(); ++i) {
+    if (Compare(*this, i, other, i) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto ts::QueryMatchList::EntryCaptures(
+    const ts::QueryMatchList::Entry &entry) const noexcept
+    -> std::span<const ts::QueryCapture> {
+  return std::span{captures_}.subspan(entry.capture_offset,
+                                      entry.capture_count);
+}
+
+auto ts::QueryMatchList::CompareEntries(
+    const ts::QueryMatchList &list, const ts::QueryMatchList::Entry &entry,
+    const ts::QueryMatchList &other,
+    const ts::QueryMatchList::Entry &other_entry) noexcept
+    -> std::weak_ordering {
+  if (const auto order = entry.start_byte <=> other_entry.start_byte;
+      order != 0) {
+    return order;
+  }
+  if (const auto order = entry.pattern_index <=> other_entry.pattern_index;
+      order != 0) {
+    return order;
+  }
+  const auto captures = list.EntryCaptures(entry);
+  const auto other_captures = other.EntryCaptures(other_entry);
+  return std::lexicographical_compare_three_way(
+      captures.begin(), captures.end(), other_captures.begin(),
+      other_captures.end(), CompareCaptures);
+}
@@ -0,0 +1,478 @@
+#ifndef CPP_TREE_SITTER_QUERY_H
+#define CPP_TREE_SITTER_QUERY_H
+
+#include <compare>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+
+namespace ts {
+
+using QueryError = TSQueryError;
+using Quantifier = TSQuantifier;
+
+// TSQueryDeleter
+// --------
+
+class TSQueryDeleter {
+public:
+  void operator()(TSQuery *ts_query_raw) const noexcept;
+};
+
+using TSQueryPtr = std::unique_ptr<TSQuery, ts::TSQueryDeleter>;
+
+// QueryPredicate
+// --------
+
+struct QueryPredicateArgument {
+  bool is_capture;
+  // Only meaningful if `is_capture` is set.
+  uint32_t capture_id;
+  // The capture name or the string literal.
+  std::string_view value;
+};
+
+// A predicate or a directive which is not evaluated by `ts::Query`, e.g.)
+// `#set!`, `#is?`, `#is-not?`.
+struct QueryPredicate {
+  std::string_view name;
+  std::vector<ts::QueryPredicateArgument> arguments;
+};
+
+class QueryMatch;
+class QueryPredicates;
+
+// Query
+// --------
+
+// A query is compiled once and is immutable afterwards, except for
+// `DisableCapture` and `DisablePattern`. So, a query can be shared by const
+// reference across threads, each thread executing it with its own
+// `ts::QueryCursor`.
+//
+// The text predicates `#eq?`, `#not-eq?`, `#any-eq?`, `#any-not-eq?`,
+// `#match?`, `#not-match?`, `#any-match?`, `#any-not-match?`, `#any-of?` and
+// `#not-any-of?` are compiled along with the query: regular expressions (POSIX
+// extended syntax, plus `\d` and `\D`) are compiled once and `#any-of?` lists
+// become hash sets.
+class Query {
+public:
+  Query(const ts::Query &) = delete;
+  Query(ts::Query &&) noexcept;
+  ~Query() noexcept;
+
+  auto operator=(const ts::Query &) -> ts::Query & = delete;
+  auto operator=(ts::Query &&) noexcept -> ts::Query &;
+
+  // An invalid text predicate, e.g.) a wrong number of arguments or an invalid
+  // regular expression. `error_offset` is the start of its pattern.
+  // It is not one of the errors of the core, which never reports it, but the
+  // next value after them, which `ts::QueryError` can still hold.
+  static constexpr ts::QueryError kErrorPredicate =
+      static_cast<ts::QueryError>(TSQueryErrorLanguage + 1);
+
+  // If the `source` is invalid, it returns a null query and sets
+  // `error_offset` and `error_type`.
+  [[nodiscard]] static auto New(const ts::Language &language,
+                                const std::string_view source,
+                                uint32_t &error_offset,
+                                ts::QueryError &error_type) noexcept
+      -> ts::Query;
+
+  auto PatternCount() const noexcept -> uint32_t;
+  auto CaptureCount() const noexcept -> uint32_t;
+  auto StringCount() const noexcept -> uint32_t;
+  auto StartByteForPattern(const uint32_t pattern_index) const noexcept
+      -> uint32_t;
+  auto IsPatternRooted(const uint32_t pattern_index) const noexcept -> bool;
+  auto IsPatternNonLocal(const uint32_t pattern_index) const noexcept -> bool;
+  // The depth of the deepest node of the pattern below its root nodes. See
+  // `ts_query_pattern_depth`.
+  auto PatternDepth(const uint32_t pattern_index) const noexcept -> uint32_t;
+  auto IsPatternGuaranteedAtStep(const uint32_t byte_offset) const noexcept
+      -> bool;
+  auto CaptureNameForId(const uint32_t capture_id) const noexcept
+      -> std::string_view;
+  auto CaptureQuantifierForId(const uint32_t pattern_index,
+                              const uint32_t capture_id) const noexcept
+      -> ts::Quantifier;
+  auto StringValueForId(const uint32_t string_id) const noexcept
+      -> std::string_view;
+
+  static constexpr uint32_t kCaptureNotFound = UINT32_MAX;
+  // If the capture is not found, it returns `kCaptureNotFound`.
+  auto CaptureIdForName(const std::string_view name) const noexcept
+      -> uint32_t;
+
+  auto DisableCapture(const std::string_view name) noexcept -> void;
+  auto DisablePattern(const uint32_t pattern_index) noexcept -> void;
+
+  auto GeneralPredicates(const uint32_t pattern_index) const noexcept
+      -> std::span<const ts::QueryPredicate>;
+  // `source` is the text the matched tree was parsed from. Node texts are
+  // compared in place, without copying.
+  auto SatisfiesTextPredicates(const ts::QueryMatch &match,
+                               const std::string_view source) const noexcept
+      -> bool;
+
+  auto IsNull() const noexcept -> bool;
+
+  auto AsRaw() const noexcept -> const TSQuery *;
+
+  static auto Null() noexcept -> ts::Query;
+
+private:
+  explicit Query(ts::TSQueryPtr &&ts_query,
+                 std::unique_ptr<ts::QueryPredicates> &&predicates) noexcept;
+
+  ts::TSQueryPtr ts_query_;
+  std::unique_ptr<ts::QueryPredicates> predicates_;
+};
+
+// QueryCapture
+// --------
+
+class QueryCapture {
+public:
+  explicit QueryCapture(const TSQueryCapture &ts_query_capture) noexcept;
+  QueryCapture(const ts::QueryCapture &) noexcept = default;
+  QueryCapture(ts::QueryCapture &&) noexcept = default;
+  ~QueryCapture() noexcept = default;
+
+  auto operator=(const ts::QueryCapture &) noexcept
+      -> ts::QueryCapture & = default;
+  auto operator=(ts::QueryCapture &&) noexcept -> ts::QueryCapture & = default;
+
+  auto Node() const noexcept -> ts::Node;
+  // The capture id, which can be passed to `ts::Query::CaptureNameForId`.
+  auto Index() const noexcept -> uint32_t;
+
+  auto AsRaw() const noexcept -> const TSQueryCapture &;
+
+private:
+  TSQueryCapture ts_query_capture_;
+};
+
+// QueryCaptures
+// --------
+
+// A view of the captures of a match. It borrows the capture array of the
+// `ts::QueryCursor` that produced the match, so it is only valid until the
+// cursor is advanced.
+class QueryCaptures {
+public:
+  class Iterator {
+  public:
+    using iterator_concept = std::forward_iterator_tag;
+    using value_type = ts::QueryCapture;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() noexcept = default;
+    explicit Iterator(const TSQueryCapture *ts_query_capture) noexcept;
+
+    auto operator*() const noexcept -> ts::QueryCapture;
+    auto operator++() noexcept -> Iterator &;
+    auto operator++(int) noexcept -> Iterator;
+    auto operator==(const Iterator &other) const noexcept -> bool = default;
+
+  private:
+    const TSQueryCapture *ts_query_capture_ = nullptr;
+  };
+
+  explicit QueryCaptures(const TSQueryCapture *ts_query_captures,
+                         const uint32_t size) noexcept;
+
+  auto begin() const noexcept -> Iterator;
+  auto end() const noexcept -> Iterator;
+  auto size() const noexcept -> uint32_t;
+  auto empty() const noexcept -> bool;
+  auto operator[](const uint32_t index) const noexcept -> ts::QueryCapture;
+
+private:
+  const TSQueryCapture *ts_query_captures_;
+  uint32_t size_;
+};
+
+// QueryMatch
+// --------
+
+class QueryMatch {
+public:
+  explicit QueryMatch() noexcept;
+  explicit QueryMatch(const TSQueryMatch &ts_query_match) noexcept;
+  QueryMatch(const ts::QueryMatch &) noexcept = default;
+  QueryMatch(ts::QueryMatch &&) noexcept = default;
+  ~QueryMatch() noexcept = default;
+
+  auto operator=(const ts::QueryMatch &) noexcept -> ts::QueryMatch & = default;
+  auto operator=(ts::QueryMatch &&) noexcept -> ts::QueryMatch & = default;
+
+  auto Id() const noexcept -> uint32_t;
+  auto PatternIndex() const noexcept -> uint32_t;
+  // Borrowed from the `ts::QueryCursor`. See `ts::QueryCaptures`.
+  auto Captures() const noexcept -> ts::QueryCaptures;
+
+  auto AsRaw() noexcept -> TSQueryMatch &;
+  auto AsRaw() const noexcept -> const TSQueryMatch &;
+
+private:
+  TSQueryMatch ts_query_match_;
+};
+
+// QueryMatchCapture
+// --------
+
+// A match and the index of the capture in the match that has been reached,
+// as returned by `ts::QueryCursor::NextCapture`.
+class QueryMatchCapture {
+public:
+  explicit QueryMatchCapture() noexcept;
+  QueryMatchCapture(const ts::QueryMatchCapture &) noexcept = default;
+  QueryMatchCapture(ts::QueryMatchCapture &&) noexcept = default;
+  ~QueryMatchCapture() noexcept = default;
+
+  auto operator=(const ts::QueryMatchCapture &) noexcept
+      -> ts::QueryMatchCapture & = default;
+  auto operator=(ts::QueryMatchCapture &&) noexcept
+      -> ts::QueryMatchCapture & = default;
+
+  auto Match() const noexcept -> const ts::QueryMatch &;
+  auto CaptureIndex() const noexcept -> uint32_t;
+  auto Capture() const noexcept -> ts::QueryCapture;
+
+private:
+  friend class QueryCursor;
+
+  ts::QueryMatch match_;
+  uint32_t capture_index_;
+};
+
+class QueryCursor;
+
+// QueryMatches
+// --------
+
+// A single-pass range over the remaining matches of a `ts::QueryCursor`.
+// e.g.) for (const auto &match : cursor.Matches()) { ... }
+class QueryMatches {
+public:
+  class Iterator {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = ts::QueryMatch;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() noexcept = default;
+    explicit Iterator(ts::QueryMatches *matches) noexcept;
+
+    auto operator*() const noexcept -> const ts::QueryMatch &;
+    auto operator++() noexcept -> Iterator &;
+    auto operator++(int) noexcept -> void;
+    auto operator==(std::default_sentinel_t) const noexcept -> bool;
+
+  private:
+    ts::QueryMatches *matches_ = nullptr;
+  };
+
+  explicit QueryMatches(ts::QueryCursor &cursor) noexcept;
+
+  auto begin() noexcept -> Iterator;
+  auto end() const noexcept -> std::default_sentinel_t;
+
+private:
+  ts::QueryCursor *cursor_;
+  ts::QueryMatch match_;
+  bool is_done_;
+};
+
+// QueryMatchCaptures
+// --------
+
+// A single-pass range over the remaining captures of a `ts::QueryCursor`, in
+// the order they appear in the document.
+class QueryMatchCaptures {
+public:
+  class Iterator {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = ts::QueryMatchCapture;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() noexcept = default;
+    explicit Iterator(ts::QueryMatchCaptures *captures) noexcept;
+
+    auto operator*() const noexcept -> const ts::QueryMatchCapture &;
+    auto operator++() noexcept -> Iterator &;
+    auto operator++(int) noexcept -> void;
+    auto operator==(std::default_sentinel_t) const noexcept -> bool;
+
+  private:
+    ts::QueryMatchCaptures *captures_ = nullptr;
+  };
+
+  explicit QueryMatchCaptures(ts::QueryCursor &cursor) noexcept;
+
+  auto begin() noexcept -> Iterator;
+  auto end() const noexcept -> std::default_sentinel_t;
+
+private:
+  ts::QueryCursor *cursor_;
+  ts::QueryMatchCapture match_capture_;
+  bool is_done_;
+};
+
+// TSQueryCursorDeleter
+// --------
+
+class TSQueryCursorDeleter {
+public:
+  void operator()(TSQueryCursor *ts_query_cursor_raw) const noexcept;
+};
+
+using TSQueryCursorPtr =
+    std::unique_ptr<TSQueryCursor, ts::TSQueryCursorDeleter>;
+
+// QueryCursor
+// --------
+
+// A cursor keeps its internal buffers across `Exec` calls, so reusing one
+// cursor for many executions does not allocate once the buffers are large
+// enough.
+class QueryCursor {
+public:
+  explicit QueryCursor() noexcept;
+  QueryCursor(const ts::QueryCursor &) = delete;
+  QueryCursor(ts::QueryCursor &&) noexcept = default;
+  ~QueryCursor() noexcept = default;
+
+  auto operator=(const ts::QueryCursor &) -> ts::QueryCursor & = delete;
+  auto operator=(ts::QueryCursor &&) noexcept -> ts::QueryCursor & = default;
+
+  // The `query` must outlive the execution. Text predicates are not evaluated.
+  auto Exec(const ts::Query &query, const ts::Node &node) noexcept -> void;
+  // Same as above, but matches which do not satisfy the text predicates of the
+  // `query` are skipped. The `source` must outlive the execution.
+  auto Exec(const ts::Query &query, const ts::Node &node,
+            const std::string_view source) noexcept -> void;
+
+  auto DidExceedMatchLimit() const noexcept -> bool;
+  auto MatchLimit() const noexcept -> uint32_t;
+  auto SetMatchLimit(const uint32_t limit) noexcept -> void;
+  auto SetByteRange(const uint32_t start_byte,
+                    const uint32_t end_byte) noexcept -> void;
+  auto SetPointRange(const ts::Point start_point,
+                     const ts::Point end_point) noexcept -> void;
+
+  static constexpr uint32_t kNoMaxStartDepth = UINT32_MAX;
+  // If the `max_start_depth` is set to `kNoMaxStartDepth`, the limit will be
+  // disabled.
+  auto SetMaxStartDepth(const uint32_t max_start_depth) noexcept -> void;
+
+  // Once the token is cancelled, `NextMatch` and `NextCapture` return `false`.
+  // It is checked between matches, so a long search for the next match is not
+  // interrupted.
+  auto SetCancellationToken(const ts::CancellationToken &token) noexcept
+      -> void;
+  auto AccessCancellationToken() const noexcept
+      -> const ts::CancellationToken &;
+  auto WasCancelled() const noexcept -> bool;
+
+  auto NextMatch(ts::QueryMatch &match) noexcept -> bool;
+  auto NextCapture(ts::QueryMatchCapture &match_capture) noexcept -> bool;
+  auto RemoveMatch(const uint32_t match_id) noexcept -> void;
+
+  [[nodiscard]] auto Matches() noexcept -> ts::QueryMatches;
+  [[nodiscard]] auto Captures() noexcept -> ts::QueryMatchCaptures;
+
+  auto IsNull() const noexcept -> bool;
+
+  auto AsRaw() noexcept -> TSQueryCursor *;
+
+private:
+  auto IsCancelled() noexcept -> bool;
+  auto SatisfiesTextPredicates(const ts::QueryMatch &match) const noexcept
+      -> bool;
+
+  ts::TSQueryCursorPtr ts_query_cursor_;
+  const ts::Query *query_;
+  std::string_view source_;
+  ts::CancellationToken cancellation_token_;
+  bool was_cancelled_;
+};
+
+// QueryMatchList
+// --------
+
+// Matches copied out of a `ts::QueryCursor`, so they outlive it. The captures
+// of all the matches share one array.
+class QueryMatchList {
+public:
+  explicit QueryMatchList() noexcept;
+  QueryMatchList(const ts::QueryMatchList &) = default;
+  QueryMatchList(ts::QueryMatchList &&) noexcept = default;
+  ~QueryMatchList() noexcept = default;
+
+  auto operator=(const ts::QueryMatchList &) -> ts::QueryMatchList & = default;
+  auto operator=(ts::QueryMatchList &&) noexcept
+      -> ts::QueryMatchList & = default;
+
+  auto Append(const ts::QueryMatch &match) noexcept -> void;
+  // Appends the match at `index` of `list`.
+  auto Append(const ts::QueryMatchList &list, const size_t index) noexcept
+      -> void;
+  // Appends the remaining matches of `cursor`.
+  auto AppendAll(ts::QueryCursor &cursor) noexcept -> void;
+  auto Clear() noexcept -> void;
+
+  // Sorts the matches in document order: by their `StartByte`, then by
+  // pattern, then by their captures. The order of the matches
+  // of a `ts::QueryCursor` depends on when they finish, so lists of the same
+  // matches compare equal once they are sorted.
+  auto Sort() noexcept -> void;
+
+  auto Size() const noexcept -> size_t;
+  auto PatternIndex(const size_t index) const noexcept -> uint32_t;
+  // The smallest start byte of the captures, which come in the order of the
+  // pattern rather than of the source. A match without captures starts at 0.
+  auto StartByte(const size_t index) const noexcept -> uint32_t;
+  auto Captures(const size_t index) const noexcept
+      -> std::span<const ts::QueryCapture>;
+
+  // Compares the match at `index` of `list` and the one at `other_index` of
+  // `other` in the order of `Sort`. Matches of the same pattern with the same
+  // captured nodes are equal.
+  static auto Compare(const ts::QueryMatchList &list, const size_t index,
+                      const ts::QueryMatchList &other,
+                      const size_t other_index) noexcept -> std::weak_ordering;
+
+  // The lists have the same matches in the same order.
+  auto operator==(const ts::QueryMatchList &other) const noexcept -> bool;
+
+private:
+  struct Entry {
+    uint32_t pattern_index;
+    uint32_t start_byte;
+    uint32_t capture_offset;
+    uint32_t capture_count;
+  };
+
+  auto EntryCaptures(const ts::QueryMatchList::Entry &entry) const noexcept
+      -> std::span<const ts::QueryCapture>;
+  static auto
+  CompareEntries(const ts::QueryMatchList &list,
+                 const ts::QueryMatchList::Entry &entry,
+                 const ts::QueryMatchList &other,
+                 const ts::QueryMatchList::Entry &other_entry) noexcept
+      -> std::weak_ordering;
+
+  std::vector<ts::QueryMatchList::Entry> entries_;
+  std::vector<ts::QueryCapture> captures_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_QUERY_H
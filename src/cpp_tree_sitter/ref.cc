@@ -0,0 +1,89 @@
+#include "ref.h"
+
+#include <cassert>
+
+namespace {
+
+auto NullNode() noexcept -> ts::Node { return ts::Node{TSNode{}}; }
+
+} // namespace
+
+// NodeRef
+// --------
+
+auto ts::NodeRef::FromCursor(const ts::TreeCursor &cursor,
+                             const bool is_caching_start_byte) noexcept
+    -> ts::NodeRef {
+  assert(!cursor.IsNull() && "NodeRef::FromCursor: cursor is null");
+  return ts::NodeRef{cursor.CurrentDescendantIndex(),
+                     is_caching_start_byte ? cursor.CurrentNode().StartByte()
+                                           : ts::NodeRef::kNoStartByte};
+}
+
+auto ts::NodeRef::FromNode(const ts::Tree &tree, const ts::Node &node,
+                           const bool is_caching_start_byte) noexcept
+    -> ts::NodeRef {
+  assert(!tree.IsNull() && "NodeRef::FromNode: tree is null");
+  assert(!node.IsNull() && "NodeRef::FromNode: node is null");
+
+  // From `node` up to, but excluding, the root.
+  auto ancestors = std::vector<ts::Node>{};
+  auto ancestor = node;
+  for (auto parent = ancestor.Parent(); !parent.IsNull();
+       parent = ancestor.Parent()) {
+    ancestors.push_back(ancestor);
+    ancestor = parent;
+  }
+
+  const auto root = tree.RootNode();
+  auto cursor = ts::TreeCursor{root};
+  for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+    if (!cursor.GotoFirstChild()) {
+      return ts::NodeRef::Null();
+    }
+    while (!cursor.CurrentNode().Eq(*it)) {
+      if (!cursor.GotoNextSibling()) {
+        // `node` is not in `tree`.
+        return ts::NodeRef::Null();
+      }
+    }
+  }
+  if (!cursor.CurrentNode().Eq(node)) {
+    return ts::NodeRef::Null();
+  }
+  return ts::NodeRef::FromCursor(cursor, is_caching_start_byte);
+}
+
+auto ts::NodeRef::Resolve(const ts::Tree &tree) const noexcept -> ts::Node {
+  return ts::NodeRefResolver{tree}.Resolve(*this);
+}
+
+// NodeRefResolver
+// --------
+
+ts::NodeRefResolver::NodeRefResolver(const ts::Tree &tree) noexcept
+    : cursor_{tree.RootNode()},
+      descendant_count_{tree.RootNode().DescendantCount()} {}
+
+auto ts::NodeRefResolver::Resolve(const ts::NodeRef &ref) noexcept
+    -> ts::Node {
+  if (ref.IsNull() || ref.DescendantIndex() >= descendant_count_) {
+    return NullNode();
+  }
+  cursor_.GotoDescendant(ref.DescendantIndex());
+  auto node = cursor_.CurrentNode();
+  if (ref.HasStartByte() && node.StartByte() != ref.StartByte()) {
+    return NullNode();
+  }
+  return node;
+}
+
+auto ts::NodeRefResolver::ResolveAll(
+    const std::span<const ts::NodeRef> refs) noexcept -> std::vector<ts::Node> {
+  auto nodes = std::vector<ts::Node>{};
+  nodes.reserve(refs.size());
+  for (const auto &ref : refs) {
+    nodes.push_back(Resolve(ref));
+  }
+  return nodes;
+}
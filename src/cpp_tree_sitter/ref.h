@@ -0,0 +1,104 @@
+#ifndef CPP_TREE_SITTER_REF_H
+#define CPP_TREE_SITTER_REF_H
+
+#include <compare>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "api.h"
+
+namespace ts {
+
+// NodeRef
+// --------
+
+// A compact reference to a node of a tree, for indexes that store millions of
+// them. Unlike `ts::Node`, it does not point into the tree. It holds the
+// descendant index of the node in pre-order from the root, which is also its
+// `ts::FlatTree::Index` in a flat tree built from the tree, and optionally the
+// start byte of the node.
+// A reference is only meaningful for the tree it was taken from and its
+// copies. If the start byte is cached, resolving it against another tree
+// results in a null node unless the node there starts at the same byte.
+class NodeRef {
+public:
+  static constexpr uint32_t kNoStartByte = UINT32_MAX;
+
+  constexpr NodeRef() noexcept = default;
+  explicit constexpr NodeRef(
+      const uint32_t descendant_index,
+      const uint32_t start_byte = ts::NodeRef::kNoStartByte) noexcept
+      : descendant_index_{descendant_index}, start_byte_{start_byte} {}
+
+  // `cursor` must have been created or reset with the root node of the tree.
+  static auto FromCursor(const ts::TreeCursor &cursor,
+                         const bool is_caching_start_byte = true) noexcept
+      -> ts::NodeRef;
+  // It looks up the ancestors of `node`, so it is O(depth^2). Prefer
+  // `FromCursor` while walking the tree.
+  static auto FromNode(const ts::Tree &tree, const ts::Node &node,
+                       const bool is_caching_start_byte = true) noexcept
+      -> ts::NodeRef;
+
+  // It creates a cursor per call. Use `ts::NodeRefResolver` to resolve many.
+  auto Resolve(const ts::Tree &tree) const noexcept -> ts::Node;
+
+  constexpr auto DescendantIndex() const noexcept -> uint32_t {
+    return descendant_index_;
+  }
+  constexpr auto StartByte() const noexcept -> uint32_t { return start_byte_; }
+  constexpr auto HasStartByte() const noexcept -> bool {
+    return start_byte_ != ts::NodeRef::kNoStartByte;
+  }
+  constexpr auto IsNull() const noexcept -> bool {
+    return descendant_index_ == UINT32_MAX;
+  }
+
+  static constexpr auto Null() noexcept -> ts::NodeRef { return {}; }
+
+  // Ordered by descendant index, i.e. in pre-order.
+  constexpr auto operator<=>(const ts::NodeRef &) const noexcept = default;
+
+private:
+  uint32_t descendant_index_ = UINT32_MAX;
+  uint32_t start_byte_ = ts::NodeRef::kNoStartByte;
+};
+
+static_assert(sizeof(ts::NodeRef) == 8);
+static_assert(std::is_trivially_copyable_v<ts::NodeRef>);
+
+// NodeRefResolver
+// --------
+
+// Resolves many references against one tree with a single cursor. The cursor
+// only climbs to the lowest common ancestor of consecutive nodes, so resolving
+// references sorted in pre-order touches each node of the tree at most a few
+// times. The tree must outlive the resolver.
+class NodeRefResolver {
+public:
+  explicit NodeRefResolver(const ts::Tree &tree) noexcept;
+  NodeRefResolver(const ts::NodeRefResolver &) = delete;
+  NodeRefResolver(ts::NodeRefResolver &&) noexcept = default;
+  ~NodeRefResolver() noexcept = default;
+
+  auto operator=(const ts::NodeRefResolver &)
+      -> ts::NodeRefResolver & = delete;
+  auto operator=(ts::NodeRefResolver &&) noexcept
+      -> ts::NodeRefResolver & = default;
+
+  // It results in a null node if `ref` is null, out of range or stale.
+  auto Resolve(const ts::NodeRef &ref) noexcept -> ts::Node;
+  // The nodes are in the order of `refs`, which need not be sorted.
+  [[nodiscard]] auto
+  ResolveAll(const std::span<const ts::NodeRef> refs) noexcept
+      -> std::vector<ts::Node>;
+
+private:
+  ts::TreeCursor cursor_;
+  uint32_t descendant_count_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_REF_H
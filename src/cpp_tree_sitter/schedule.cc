@@ -0,0 +1,83 @@
+#include "schedule.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// `RunFor` steps a task for at least 1 microsecond.
+auto ClampOptions(ts::ParseSchedulerOptions options) noexcept
+    -> ts::ParseSchedulerOptions {
+  options.slice = std::max(options.slice, std::chrono::microseconds{1});
+  return options;
+}
+
+} // namespace
+
+// ParseScheduler
+// --------
+
+ts::ParseScheduler::ParseScheduler(
+    const ts::ParseSchedulerOptions &options) noexcept
+    : options_{ClampOptions(options)}, entries_{}, next_id_{1} {}
+
+auto ts::ParseScheduler::Add(
+    ts::ParseTask &&task, ts::ParseDoneCallback done_callback,
+    ts::ParseProgressCallback progress_callback) noexcept
+    -> ts::ParseScheduler::Id {
+  const auto id = next_id_++;
+  entries_.push_back(ts::ParseScheduler::Entry{id, std::move(task),
+                                               std::move(done_callback),
+                                               std::move(progress_callback)});
+  return id;
+}
+
+auto ts::ParseScheduler::Cancel(const ts::ParseScheduler::Id id) noexcept
+    -> bool {
+  const auto it = std::find_if(
+      entries_.begin(), entries_.end(),
+      [id](const ts::ParseScheduler::Entry &entry) { return entry.id == id; });
+  if (it == entries_.end()) {
+    return false;
+  }
+  entries_.erase(it);
+  return true;
+}
+
+auto ts::ParseScheduler::RunFor(const std::chrono::microseconds budget) noexcept
+    -> bool {
+  const auto end = std::chrono::steady_clock::now() + budget;
+  do {
+    if (entries_.empty()) {
+      return false;
+    }
+    // Taken out of the queue, so the callbacks can add and cancel tasks.
+    auto entry = std::move(entries_.front());
+    entries_.pop_front();
+    const auto left = std::chrono::duration_cast<std::chrono::microseconds>(
+        end - std::chrono::steady_clock::now());
+    const auto progress =
+        entry.task.Step(std::clamp(left, std::chrono::microseconds{1},
+                                   options_.slice));
+    if (entry.progress_callback) {
+      entry.progress_callback(progress);
+    }
+    if (progress.is_done) {
+      if (entry.done_callback) {
+        entry.done_callback(entry.task.TakeTree());
+      }
+    } else {
+      entries_.push_back(std::move(entry));
+    }
+  } while (std::chrono::steady_clock::now() < end);
+  return !entries_.empty();
+}
+
+auto ts::ParseScheduler::Size() const noexcept -> size_t {
+  return entries_.size();
+}
+
+auto ts::ParseScheduler::Options() const noexcept
+    -> const ts::ParseSchedulerOptions & {
+  return options_;
+}
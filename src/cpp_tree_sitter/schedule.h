@@ -0,0 +1,88 @@
+#ifndef CPP_TREE_SITTER_SCHEDULE_H
+#define CPP_TREE_SITTER_SCHEDULE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+#include "api.h"
+
+namespace ts {
+
+// ParseSchedulerOptions
+// --------
+
+struct ParseSchedulerOptions {
+  // The time budget of one step of a task, see `ts::ParseTask::Step`. A
+  // shorter slice than 1 microsecond is raised to it.
+  std::chrono::microseconds slice = std::chrono::microseconds{1000};
+};
+
+// Called with the tree of a finished task. If it was cancelled, the tree is
+// null.
+using ParseDoneCallback = std::function<void(ts::Tree &&tree)>;
+// Called with the progress of a task after each of its steps.
+using ParseProgressCallback =
+    std::function<void(const ts::ParseProgress &progress)>;
+
+// ParseScheduler
+// --------
+
+// Runs `ts::ParseTask`s in round-robin slices on the calling thread, so an
+// editor or a language server can keep parsing large documents from its own
+// event loop, between other events:
+//
+//   scheduler.Add(parser.ParseIncrementally(ts::Tree::Null(), source),
+//                 [](ts::Tree &&tree) { ... });
+//   while (HasEvents() || scheduler.Size() != 0) {
+//     HandleEvents();
+//     scheduler.RunFor(std::chrono::milliseconds{4});
+//   }
+//
+// It owns no thread, so it works with any executor. Each task needs its own
+// parser.
+class ParseScheduler {
+public:
+  using Id = uint64_t;
+
+  explicit ParseScheduler(const ts::ParseSchedulerOptions &options) noexcept;
+  ParseScheduler(const ts::ParseScheduler &) = delete;
+  ParseScheduler(ts::ParseScheduler &&) = delete;
+  // The unfinished tasks are discarded without calling their callbacks.
+  ~ParseScheduler() noexcept = default;
+
+  auto operator=(const ts::ParseScheduler &) -> ts::ParseScheduler & = delete;
+  auto operator=(ts::ParseScheduler &&) -> ts::ParseScheduler & = delete;
+
+  auto Add(ts::ParseTask &&task, ts::ParseDoneCallback done_callback,
+           ts::ParseProgressCallback progress_callback = nullptr) noexcept
+      -> ts::ParseScheduler::Id;
+  // Removes the task without calling its callbacks. It returns false if the
+  // task has already finished.
+  auto Cancel(const ts::ParseScheduler::Id id) noexcept -> bool;
+
+  // Steps the tasks in turn until `budget` is spent or none is left, and
+  // returns whether tasks are left. At least one step runs. The callbacks are
+  // called on this thread and may add tasks.
+  auto RunFor(const std::chrono::microseconds budget) noexcept -> bool;
+  auto Size() const noexcept -> size_t;
+  auto Options() const noexcept -> const ts::ParseSchedulerOptions &;
+
+private:
+  struct Entry {
+    ts::ParseScheduler::Id id;
+    ts::ParseTask task;
+    ts::ParseDoneCallback done_callback;
+    ts::ParseProgressCallback progress_callback;
+  };
+
+  const ts::ParseSchedulerOptions options_;
+  // The task to step next is at the front.
+  std::deque<ts::ParseScheduler::Entry> entries_;
+  ts::ParseScheduler::Id next_id_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_SCHEDULE_H
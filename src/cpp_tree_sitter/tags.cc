@@ -0,0 +1,502 @@
+#include "tags.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+constexpr auto kDefinitionPrefix = std::string_view{"definition."};
+constexpr auto kReferencePrefix = std::string_view{"reference."};
+
+auto NodeRange(const ts::Node &node) noexcept -> ts::Range {
+  return ts::Range{TSRange{node.StartPoint(), node.EndPoint(),
+                           node.StartByte(), node.EndByte()}};
+}
+
+auto IsSameRange(const ts::Range &a, const ts::Range &b) noexcept -> bool {
+  return a.start_byte == b.start_byte && a.end_byte == b.end_byte;
+}
+
+// Lists the regular files under `directory` with one of `extensions`, sorted.
+auto ListFiles(const std::string_view directory,
+               const std::span<const std::string> extensions) noexcept
+    -> std::vector<std::string> {
+  auto paths = std::vector<std::string>{};
+  auto error_code = std::error_code{};
+  auto it =
+      std::filesystem::recursive_directory_iterator{directory, error_code};
+  for (; !error_code && it != std::filesystem::recursive_directory_iterator{};
+       it.increment(error_code)) {
+    if (!it->is_regular_file(error_code)) {
+      continue;
+    }
+    const auto &path = it->path();
+    if (!extensions.empty() &&
+        std::find(extensions.begin(), extensions.end(),
+                  path.extension().string()) == extensions.end()) {
+      continue;
+    }
+    paths.push_back(path.string());
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+struct StringHash {
+  using is_transparent = void;
+
+  auto operator()(const std::string_view string) const noexcept -> size_t {
+    return std::hash<std::string_view>{}(string);
+  }
+};
+
+using InternMap =
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>>;
+
+auto Intern(InternMap &map, const std::string_view string) noexcept
+    -> uint32_t {
+  const auto it = map.find(string);
+  if (it != map.end()) {
+    return it->second;
+  }
+  const auto id = static_cast<uint32_t>(map.size());
+  map.emplace(string, id);
+  return id;
+}
+
+// Returns the strings of `map` sorted, and `ids` such that `ids[old_id]` is
+// the index of the string in them.
+auto SortInterned(InternMap &&map, std::vector<uint32_t> &ids) noexcept
+    -> std::vector<std::string> {
+  auto strings = std::vector<std::string>(map.size());
+  for (auto &[string, id] : map) {
+    strings[id] = string;
+  }
+  auto order = std::vector<uint32_t>(strings.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&strings](uint32_t a, uint32_t b) {
+    return strings[a] < strings[b];
+  });
+  ids.assign(order.size(), 0);
+  auto sorted_strings = std::vector<std::string>{};
+  sorted_strings.reserve(order.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    ids[order[i]] = i;
+    sorted_strings.push_back(std::move(strings[order[i]]));
+  }
+  return sorted_strings;
+}
+
+// The tags of one file, with their names copied out of its source.
+struct FileTags {
+  struct Tag {
+    // Of the name in `names`.
+    uint32_t name_offset;
+    uint32_t name_size;
+    std::string_view kind;
+    uint32_t start_byte;
+    ts::Point start_point;
+    bool is_definition;
+  };
+
+  std::string names;
+  std::vector<FileTags::Tag> tags;
+};
+
+} // namespace
+
+// TagsBuffer
+// --------
+
+ts::TagsBuffer::TagsBuffer() noexcept
+    : query_cursor_{}, tags_{}, doc_nodes_{}, chunks_{}, chunk_index_{0},
+      chunk_used_{0} {}
+
+auto ts::TagsBuffer::Tags() const noexcept -> std::span<const ts::Tag> {
+  return tags_;
+}
+
+auto ts::TagsBuffer::Size() const noexcept -> size_t { return tags_.size(); }
+
+auto ts::TagsBuffer::Clear() noexcept -> void {
+  tags_.clear();
+  chunk_index_ = 0;
+  chunk_used_ = 0;
+}
+
+auto ts::TagsBuffer::AllocateText(const size_t size) noexcept -> char * {
+  while (chunk_index_ < chunks_.size()) {
+    auto &chunk = chunks_[chunk_index_];
+    if (chunk.size - chunk_used_ >= size) {
+      const auto text = chunk.data.get() + chunk_used_;
+      chunk_used_ += size;
+      return text;
+    }
+    ++chunk_index_;
+    chunk_used_ = 0;
+  }
+  const auto chunk_size = std::max(size, kChunkSize);
+  chunks_.push_back(ts::TagsBuffer::Chunk{
+      std::make_unique_for_overwrite<char[]>(chunk_size), chunk_size});
+  chunk_index_ = chunks_.size() - 1;
+  chunk_used_ = size;
+  return chunks_.back().data.get();
+}
+
+// Tagger
+// --------
+
+ts::Tagger::Tagger(const ts::Query &query) noexcept
+    : query_{query}, capture_infos_{}, is_selecting_adjacent_{} {
+  assert(!query.IsNull() && "Tagger::Tagger: query is null");
+  const auto capture_count = query.CaptureCount();
+  capture_infos_.reserve(capture_count);
+  for (uint32_t i = 0; i < capture_count; ++i) {
+    const auto name = query.CaptureNameForId(i);
+    auto info = ts::Tagger::CaptureInfo{ts::Tagger::CaptureRole::kNone, {}};
+    if (name == "name") {
+      info.role = ts::Tagger::CaptureRole::kName;
+    } else if (name == "doc") {
+      info.role = ts::Tagger::CaptureRole::kDoc;
+    } else if (name.starts_with(kDefinitionPrefix)) {
+      info = {ts::Tagger::CaptureRole::kDefinition,
+              name.substr(kDefinitionPrefix.size())};
+    } else if (name.starts_with(kReferencePrefix)) {
+      info = {ts::Tagger::CaptureRole::kReference,
+              name.substr(kReferencePrefix.size())};
+    }
+    capture_infos_.push_back(info);
+  }
+
+  const auto pattern_count = query.PatternCount();
+  is_selecting_adjacent_.reserve(pattern_count);
+  for (uint32_t i = 0; i < pattern_count; ++i) {
+    const auto predicates = query.GeneralPredicates(i);
+    is_selecting_adjacent_.push_back(std::any_of(
+        predicates.begin(), predicates.end(),
+        [](const ts::QueryPredicate &predicate) {
+          return predicate.name == "select-adjacent!";
+        }));
+  }
+}
+
+auto ts::Tagger::Tag(const ts::Tree &tree, const std::string_view source,
+                     ts::TagsBuffer &buffer,
+                     const ts::CancellationToken &token) const noexcept
+    -> bool {
+  assert(!tree.IsNull() && "Tagger::Tag: tree is null");
+  buffer.Clear();
+  auto &query_cursor = buffer.query_cursor_;
+  query_cursor.Exec(query_, tree.RootNode(), source);
+  query_cursor.SetCancellationToken(token);
+  auto match = ts::QueryMatch{};
+  while (query_cursor.NextMatch(match)) {
+    AppendTag(match, source, buffer);
+  }
+
+  // Matches come in the order of their first nodes, which are not always the
+  // names, and several patterns can tag the same node.
+  auto &tags = buffer.tags_;
+  std::stable_sort(tags.begin(), tags.end(),
+                   [](const ts::Tag &a, const ts::Tag &b) {
+                     return std::tie(a.name_range.start_byte,
+                                     a.name_range.end_byte, a.range.start_byte,
+                                     a.range.end_byte, a.pattern_index) <
+                            std::tie(b.name_range.start_byte,
+                                     b.name_range.end_byte, b.range.start_byte,
+                                     b.range.end_byte, b.pattern_index);
+                   });
+  const auto last = std::unique(
+      tags.begin(), tags.end(), [](const ts::Tag &a, const ts::Tag &b) {
+        return IsSameRange(a.name_range, b.name_range) &&
+               IsSameRange(a.range, b.range) &&
+               a.is_definition == b.is_definition;
+      });
+  tags.erase(last, tags.end());
+  return !query_cursor.WasCancelled();
+}
+
+auto ts::Tagger::Query() const noexcept -> const ts::Query & { return query_; }
+
+auto ts::Tagger::AppendTag(const ts::QueryMatch &match,
+                           const std::string_view source,
+                           ts::TagsBuffer &buffer) const noexcept -> void {
+  auto name_node = ts::Node{TSNode{}};
+  auto tagged_node = ts::Node{TSNode{}};
+  const ts::Tagger::CaptureInfo *tagged_info = nullptr;
+  auto &doc_nodes = buffer.doc_nodes_;
+  doc_nodes.clear();
+  for (const auto capture : match.Captures()) {
+    const auto &info = capture_infos_[capture.Index()];
+    switch (info.role) {
+    case ts::Tagger::CaptureRole::kName:
+      if (name_node.IsNull()) {
+        name_node = capture.Node();
+      }
+      break;
+    case ts::Tagger::CaptureRole::kDefinition:
+    case ts::Tagger::CaptureRole::kReference:
+      if (tagged_info == nullptr) {
+        tagged_node = capture.Node();
+        tagged_info = &info;
+      }
+      break;
+    case ts::Tagger::CaptureRole::kDoc:
+      doc_nodes.push_back(capture.Node());
+      break;
+    case ts::Tagger::CaptureRole::kNone:
+      break;
+    }
+  }
+  if (name_node.IsNull() || tagged_info == nullptr) {
+    return;
+  }
+
+  // The docs are the texts of the `@doc` nodes in the order of the source.
+  std::sort(doc_nodes.begin(), doc_nodes.end(),
+            [](const ts::Node &a, const ts::Node &b) {
+              return a.StartByte() < b.StartByte();
+            });
+  auto first_doc = doc_nodes.begin();
+  if (is_selecting_adjacent_[match.PatternIndex()]) {
+    // Walks back from the tagged node while each doc node ends on the line
+    // before the start of the next one.
+    auto last_doc = std::partition_point(
+        doc_nodes.begin(), doc_nodes.end(),
+        [&tagged_node](const ts::Node &node) {
+          return node.EndByte() <= tagged_node.StartByte();
+        });
+    doc_nodes.erase(last_doc, doc_nodes.end());
+    auto next_row = tagged_node.StartPoint().row;
+    first_doc = doc_nodes.end();
+    while (first_doc != doc_nodes.begin() &&
+           next_row - std::prev(first_doc)->EndPoint().row <= 1) {
+      --first_doc;
+      next_row = first_doc->StartPoint().row;
+    }
+  }
+  auto docs = std::string_view{};
+  const auto doc_count = std::distance(first_doc, doc_nodes.end());
+  if (doc_count == 1) {
+    docs = source.substr(first_doc->StartByte(),
+                         first_doc->EndByte() - first_doc->StartByte());
+  } else if (doc_count > 1) {
+    auto size = static_cast<size_t>(doc_count - 1);
+    for (auto it = first_doc; it != doc_nodes.end(); ++it) {
+      size += it->EndByte() - it->StartByte();
+    }
+    const auto text = buffer.AllocateText(size);
+    auto offset = size_t{0};
+    for (auto it = first_doc; it != doc_nodes.end(); ++it) {
+      if (it != first_doc) {
+        text[offset++] = '\n';
+      }
+      const auto length = it->EndByte() - it->StartByte();
+      std::memcpy(text + offset, source.data() + it->StartByte(), length);
+      offset += length;
+    }
+    docs = std::string_view{text, size};
+  }
+
+  buffer.tags_.push_back(ts::Tag{
+      NodeRange(tagged_node), NodeRange(name_node),
+      source.substr(name_node.StartByte(),
+                    name_node.EndByte() - name_node.StartByte()),
+      tagged_info->kind, docs, match.PatternIndex(),
+      tagged_info->role == ts::Tagger::CaptureRole::kDefinition});
+}
+
+// SymbolIndex
+// --------
+
+ts::SymbolIndex::SymbolIndex() noexcept
+    : names_{}, name_offsets_{0}, paths_{}, kinds_{}, entries_{},
+      failed_path_count_{0} {}
+
+auto ts::SymbolIndex::Find(const std::string_view name) const noexcept
+    -> std::span<const ts::SymbolEntry> {
+  const auto name_count = NameCount();
+  auto low = uint32_t{0};
+  auto high = name_count;
+  while (low < high) {
+    const auto middle = low + (high - low) / 2;
+    if (Name(middle) < name) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == name_count || Name(low) != name) {
+    return {};
+  }
+  const auto first = std::partition_point(
+      entries_.begin(), entries_.end(),
+      [low](const ts::SymbolEntry &entry) { return entry.name_id < low; });
+  const auto last = std::partition_point(
+      first, entries_.end(),
+      [low](const ts::SymbolEntry &entry) { return entry.name_id == low; });
+  return {first, last};
+}
+
+auto ts::SymbolIndex::Entries() const noexcept
+    -> std::span<const ts::SymbolEntry> {
+  return entries_;
+}
+
+auto ts::SymbolIndex::Name(const uint32_t name_id) const noexcept
+    -> std::string_view {
+  assert(name_id < NameCount() && "SymbolIndex::Name: name_id is out of range");
+  return std::string_view{names_}.substr(
+      name_offsets_[name_id],
+      name_offsets_[name_id + 1] - name_offsets_[name_id]);
+}
+
+auto ts::SymbolIndex::Path(const uint32_t path_id) const noexcept
+    -> std::string_view {
+  assert(path_id < paths_.size() &&
+         "SymbolIndex::Path: path_id is out of range");
+  return paths_[path_id];
+}
+
+auto ts::SymbolIndex::Kind(const uint16_t kind_id) const noexcept
+    -> std::string_view {
+  assert(kind_id < kinds_.size() &&
+         "SymbolIndex::Kind: kind_id is out of range");
+  return kinds_[kind_id];
+}
+
+auto ts::SymbolIndex::NameCount() const noexcept -> uint32_t {
+  return static_cast<uint32_t>(name_offsets_.size() - 1);
+}
+
+auto ts::SymbolIndex::PathCount() const noexcept -> uint32_t {
+  return static_cast<uint32_t>(paths_.size());
+}
+
+auto ts::SymbolIndex::FailedPathCount() const noexcept -> uint32_t {
+  return failed_path_count_;
+}
+
+auto ts::SymbolIndex::MemoryUsage() const noexcept -> size_t {
+  auto size = names_.capacity() +
+              name_offsets_.capacity() * sizeof(uint32_t) +
+              entries_.capacity() * sizeof(ts::SymbolEntry);
+  for (const auto &path : paths_) {
+    size += sizeof(std::string) + path.capacity();
+  }
+  for (const auto &kind : kinds_) {
+    size += sizeof(std::string) + kind.capacity();
+  }
+  return size;
+}
+
+// IndexCorpus
+// --------
+
+auto ts::IndexCorpus(const ts::Tagger &tagger, const ts::Language &language,
+                     const std::string_view directory,
+                     const ts::CorpusIndexOptions &options,
+                     const ts::CancellationToken &token) noexcept
+    -> ts::SymbolIndex {
+  auto index = ts::SymbolIndex{};
+  index.paths_ = ListFiles(directory, options.extensions);
+
+  // Each file is tagged into its own slot without a lock, and the names are
+  // interned once the batch is done.
+  auto file_tags = std::vector<FileTags>(index.paths_.size());
+  // The buffers not in use by a worker. A worker takes one for each file, so
+  // at most one buffer per thread is ever made.
+  auto mutex = std::mutex{};
+  auto free_buffers = std::vector<std::unique_ptr<ts::TagsBuffer>>{};
+  auto failed_path_count = std::atomic<uint32_t>{0};
+  {
+    auto batch_parser =
+        ts::BatchParser{ts::BatchOptions{options.thread_count, 0,
+                                         ts::Parser::kNoTimeout}};
+    batch_parser.ParseFiles(
+        language, index.paths_,
+        [&](const size_t path_id, ts::Tree &&tree) {
+          if (tree.IsNull()) {
+            failed_path_count.fetch_add(1, std::memory_order_relaxed);
+            return;
+          }
+          auto buffer = std::unique_ptr<ts::TagsBuffer>{};
+          {
+            const auto lock = std::lock_guard{mutex};
+            if (!free_buffers.empty()) {
+              buffer = std::move(free_buffers.back());
+              free_buffers.pop_back();
+            }
+          }
+          if (buffer == nullptr) {
+            buffer = std::make_unique<ts::TagsBuffer>();
+          }
+          if (tagger.Tag(tree, tree.Source(), *buffer, token)) {
+            auto &[names, tags] = file_tags[path_id];
+            tags.reserve(buffer->Size());
+            for (const auto &tag : buffer->Tags()) {
+              tags.push_back(FileTags::Tag{
+                  static_cast<uint32_t>(names.size()),
+                  static_cast<uint32_t>(tag.name.size()), tag.kind,
+                  tag.name_range.start_byte,
+                  ts::Point{tag.name_range.start_point}, tag.is_definition});
+              names += tag.name;
+            }
+          } else {
+            failed_path_count.fetch_add(1, std::memory_order_relaxed);
+          }
+          const auto lock = std::lock_guard{mutex};
+          free_buffers.push_back(std::move(buffer));
+        },
+        false, token);
+  }
+  index.failed_path_count_ = failed_path_count.load(std::memory_order_relaxed);
+
+  auto name_ids = InternMap{};
+  auto kind_ids = InternMap{};
+  for (size_t path_id = 0; path_id < file_tags.size(); ++path_id) {
+    auto &[names, tags] = file_tags[path_id];
+    for (const auto &tag : tags) {
+      index.entries_.push_back(ts::SymbolEntry{
+          Intern(name_ids, std::string_view{names}.substr(tag.name_offset,
+                                                          tag.name_size)),
+          static_cast<uint32_t>(path_id), tag.start_byte, tag.start_point,
+          static_cast<uint16_t>(Intern(kind_ids, tag.kind)),
+          tag.is_definition});
+    }
+    file_tags[path_id] = FileTags{};
+  }
+
+  // The ids are given in the order of the names and kinds, and the entries
+  // are sorted, so the index does not depend on the order of the files.
+  auto name_order = std::vector<uint32_t>{};
+  const auto names = SortInterned(std::move(name_ids), name_order);
+  auto kind_order = std::vector<uint32_t>{};
+  index.kinds_ = SortInterned(std::move(kind_ids), kind_order);
+  index.name_offsets_.reserve(names.size() + 1);
+  for (const auto &name : names) {
+    index.names_ += name;
+    index.name_offsets_.push_back(static_cast<uint32_t>(index.names_.size()));
+  }
+  for (auto &entry : index.entries_) {
+    entry.name_id = name_order[entry.name_id];
+    entry.kind_id = static_cast<uint16_t>(kind_order[entry.kind_id]);
+  }
+  std::sort(index.entries_.begin(), index.entries_.end(),
+            [](const ts::SymbolEntry &a, const ts::SymbolEntry &b) {
+              return std::tuple{a.name_id, !a.is_definition, a.path_id,
+                                a.start_byte, a.kind_id} <
+                     std::tuple{b.name_id, !b.is_definition, b.path_id,
+                                b.start_byte, b.kind_id};
+            });
+  index.entries_.shrink_to_fit();
+  return index;
+}
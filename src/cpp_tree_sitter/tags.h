@@ -0,0 +1,229 @@
+#ifndef CPP_TREE_SITTER_TAGS_H
+#define CPP_TREE_SITTER_TAGS_H
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api.h"
+#include "batch.h"
+#include "query.h"
+
+namespace ts {
+
+// Tag
+// --------
+
+// A definition or a reference found by a `ts::Tagger`.
+struct Tag {
+  // The node captured by `@definition.<kind>` or `@reference.<kind>`.
+  ts::Range range;
+  // The node captured by `@name`.
+  ts::Range name_range;
+  // The text of the `@name` node, a view into the source.
+  std::string_view name;
+  // e.g.) "function" of `@definition.function`, a view into the query.
+  std::string_view kind;
+  // The texts of the `@doc` nodes, joined with newlines. It is a view into the
+  // source if there is one node, and into the `ts::TagsBuffer` otherwise.
+  std::string_view docs;
+  uint32_t pattern_index;
+  bool is_definition;
+};
+
+class Tagger;
+
+// TagsBuffer
+// --------
+
+// The tags of one document and the memory to find them. Clearing the buffer
+// keeps its memory, so a buffer reused across documents stops allocating once
+// it has grown to fit them. Use one buffer per thread.
+class TagsBuffer {
+public:
+  explicit TagsBuffer() noexcept;
+  TagsBuffer(const ts::TagsBuffer &) = delete;
+  TagsBuffer(ts::TagsBuffer &&) noexcept = default;
+  ~TagsBuffer() noexcept = default;
+
+  auto operator=(const ts::TagsBuffer &) -> ts::TagsBuffer & = delete;
+  auto operator=(ts::TagsBuffer &&) noexcept -> ts::TagsBuffer & = default;
+
+  // In the order of their names in the source.
+  auto Tags() const noexcept -> std::span<const ts::Tag>;
+  auto Size() const noexcept -> size_t;
+  // The views of the cleared tags into the buffer become invalid.
+  auto Clear() noexcept -> void;
+
+private:
+  friend class Tagger;
+
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  static constexpr size_t kChunkSize = 16 * 1024;
+
+  // Returns `size` bytes which live until the buffer is cleared.
+  auto AllocateText(const size_t size) noexcept -> char *;
+
+  ts::QueryCursor query_cursor_;
+  std::vector<ts::Tag> tags_;
+  // The `@doc` nodes of the current match.
+  std::vector<ts::Node> doc_nodes_;
+  std::vector<ts::TagsBuffer::Chunk> chunks_;
+  size_t chunk_index_;
+  size_t chunk_used_;
+};
+
+// Tagger
+// --------
+
+// Finds the definitions and references of a tree with a query. The query
+// follows the conventions of `tags.scm` files:
+//
+//   - `@definition.<kind>` and `@reference.<kind>` capture the tagged nodes,
+//     e.g.) `@definition.function` or `@reference.call`.
+//   - `@name` captures the node whose text is the name of the tag.
+//   - `@doc` captures the comments documenting a definition.
+//   - `(#select-adjacent! @doc @definition.<kind>)` keeps only the `@doc`
+//     nodes which end on the line before the next one or the definition.
+//
+// Other predicates with `!`, e.g.) `#strip!`, are ignored. If several patterns
+// tag the same name and node, the tag of the first pattern is kept.
+// A tagger is not modified by tagging, so one tagger can be shared by threads
+// that each have their own `ts::TagsBuffer`.
+class Tagger {
+public:
+  // `query` must outlive the tagger.
+  explicit Tagger(const ts::Query &query) noexcept;
+  Tagger(const ts::Tagger &) = delete;
+  Tagger(ts::Tagger &&) = delete;
+  ~Tagger() noexcept = default;
+
+  auto operator=(const ts::Tagger &) -> ts::Tagger & = delete;
+  auto operator=(ts::Tagger &&) -> ts::Tagger & = delete;
+
+  // Replaces the tags of `buffer` with the ones of `tree`, parsed from
+  // `source`. The tags are views into `source` and `buffer`.
+  // If `token` is cancelled or its deadline passes, the tags found so far are
+  // kept and it returns false.
+  auto Tag(const ts::Tree &tree, const std::string_view source,
+           ts::TagsBuffer &buffer,
+           const ts::CancellationToken &token =
+               ts::CancellationToken::Null()) const noexcept -> bool;
+
+  auto Query() const noexcept -> const ts::Query &;
+
+private:
+  enum class CaptureRole : uint8_t {
+    kNone,
+    kName,
+    kDefinition,
+    kReference,
+    kDoc,
+  };
+
+  struct CaptureInfo {
+    ts::Tagger::CaptureRole role;
+    // The part of the capture name after `definition.` or `reference.`.
+    std::string_view kind;
+  };
+
+  // Appends the tag of `match`, if it has one, to `buffer`.
+  auto AppendTag(const ts::QueryMatch &match, const std::string_view source,
+                 ts::TagsBuffer &buffer) const noexcept -> void;
+
+  const ts::Query &query_;
+  // Indexed by capture id.
+  std::vector<ts::Tagger::CaptureInfo> capture_infos_;
+  // Indexed by pattern index.
+  std::vector<bool> is_selecting_adjacent_;
+};
+
+// SymbolIndex
+// --------
+
+// 24 bytes per tag. The ids index the name, path and kind tables of the
+// `ts::SymbolIndex`.
+struct SymbolEntry {
+  uint32_t name_id;
+  uint32_t path_id;
+  uint32_t start_byte;
+  // Of the name.
+  ts::Point start_point;
+  uint16_t kind_id;
+  bool is_definition;
+};
+
+struct CorpusIndexOptions {
+  // If it is 0, `std::thread::hardware_concurrency` threads are used.
+  uint32_t thread_count = 0;
+  // e.g.) ".py". If it is empty, every regular file is indexed.
+  std::vector<std::string> extensions = {};
+};
+
+// The tags of a corpus, with each distinct name, path and kind stored once.
+// Names are sorted, and the entries are sorted by name, path and position, so
+// an index built from the same files is the same whatever the thread count.
+class SymbolIndex {
+public:
+  explicit SymbolIndex() noexcept;
+  SymbolIndex(const ts::SymbolIndex &) = delete;
+  SymbolIndex(ts::SymbolIndex &&) noexcept = default;
+  ~SymbolIndex() noexcept = default;
+
+  auto operator=(const ts::SymbolIndex &) -> ts::SymbolIndex & = delete;
+  auto operator=(ts::SymbolIndex &&) noexcept -> ts::SymbolIndex & = default;
+
+  // The definitions and references named `name`, definitions first.
+  auto Find(const std::string_view name) const noexcept
+      -> std::span<const ts::SymbolEntry>;
+  auto Entries() const noexcept -> std::span<const ts::SymbolEntry>;
+  auto Name(const uint32_t name_id) const noexcept -> std::string_view;
+  auto Path(const uint32_t path_id) const noexcept -> std::string_view;
+  auto Kind(const uint16_t kind_id) const noexcept -> std::string_view;
+  auto NameCount() const noexcept -> uint32_t;
+  auto PathCount() const noexcept -> uint32_t;
+  // The files which could not be read or parsed.
+  auto FailedPathCount() const noexcept -> uint32_t;
+  // The bytes held by the tables.
+  auto MemoryUsage() const noexcept -> size_t;
+
+private:
+  friend auto IndexCorpus(const ts::Tagger &tagger,
+                          const ts::Language &language,
+                          const std::string_view directory,
+                          const ts::CorpusIndexOptions &options,
+                          const ts::CancellationToken &token) noexcept
+      -> ts::SymbolIndex;
+
+  // The names, back to back. Name `i` is `names_[name_offsets_[i],
+  // name_offsets_[i + 1])`.
+  std::string names_;
+  std::vector<uint32_t> name_offsets_;
+  std::vector<std::string> paths_;
+  std::vector<std::string> kinds_;
+  std::vector<ts::SymbolEntry> entries_;
+  uint32_t failed_path_count_;
+};
+
+// Tags every file under `directory`, recursively, on a `ts::BatchParser`.
+// Files are parsed with `language` and tagged by `tagger`, whose query must be
+// of the same language.
+// If `token` is cancelled or its deadline passes, the files that have not
+// been tagged yet are left out and counted as failed.
+[[nodiscard]] auto
+IndexCorpus(const ts::Tagger &tagger, const ts::Language &language,
+            const std::string_view directory,
+            const ts::CorpusIndexOptions &options = ts::CorpusIndexOptions{},
+            const ts::CancellationToken &token =
+                ts::CancellationToken::Null()) noexcept -> ts::SymbolIndex;
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_TAGS_H
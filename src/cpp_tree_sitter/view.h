@@ -0,0 +1,124 @@
+#ifndef CPP_TREE_SITTER_VIEW_H
+#define CPP_TREE_SITTER_VIEW_H
+
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "api.h"
+#include "names.h"
+
+namespace ts {
+
+// Fields
+// --------
+
+// The field names of a `ts::NodeView`.
+template <ts::FixedString... Names> struct Fields {};
+
+// NodeView
+// --------
+
+// A node of a known type with named accessors for its fields, e.g.)
+//
+//   using FunctionView = ts::NodeView<"function_definition",
+//                                     ts::Fields<"name", "body">>;
+//   if (FunctionView::Match(node)) {
+//     const auto body = FunctionView{node}.Field<"body">();
+//   }
+//
+// The symbol and field ids are resolved once per language and cached for the
+// life of the process, so `Match` compares symbol ids and `Field` is a
+// `ts::Node::ChildByFieldId` call. A field name that the language does not
+// have results in a null node.
+template <ts::FixedString Type, typename FieldList = ts::Fields<>>
+class NodeView;
+
+template <ts::FixedString Type, ts::FixedString... FieldNames>
+class NodeView<Type, ts::Fields<FieldNames...>> {
+public:
+  // The ids of the type and the fields in one language.
+  class Schema {
+  public:
+    explicit Schema(const ts::Language &language) noexcept
+        : symbols_{language}, field_ids_{language} {}
+
+    auto Symbol() const noexcept -> ts::Symbol { return symbols_[0]; }
+
+    template <ts::FixedString Name>
+    auto FieldId() const noexcept -> ts::FieldId {
+      return field_ids_.template Get<Name>();
+    }
+
+    auto Match(const ts::Node &node) const noexcept -> bool {
+      return node.Symbol() == Symbol();
+    }
+
+  private:
+    ts::SymbolTable<Type> symbols_;
+    ts::FieldTable<FieldNames...> field_ids_;
+  };
+
+  // `node` must match.
+  explicit NodeView(const ts::Node &node) noexcept
+      : node_{node}, schema_{&SchemaFor(node.Language())} {
+    assert(schema_->Match(node) && "NodeView::NodeView: node does not match");
+  }
+  NodeView(const NodeView &) noexcept = default;
+  NodeView(NodeView &&) noexcept = default;
+  ~NodeView() noexcept = default;
+
+  auto operator=(const NodeView &) noexcept -> NodeView & = default;
+  auto operator=(NodeView &&) noexcept -> NodeView & = default;
+
+  static auto Match(const ts::Node &node) noexcept -> bool {
+    return !node.IsNull() && SchemaFor(node.Language()).Match(node);
+  }
+
+  // The schema of the first language looked up by the calling thread is
+  // cached, so this is a pointer comparison in the common case.
+  static auto SchemaFor(const ts::Language &language) noexcept
+      -> const Schema & {
+    thread_local const TSLanguage *last_ts_language = nullptr;
+    thread_local const Schema *last_schema = nullptr;
+    if (last_ts_language == language.AsRaw()) {
+      return *last_schema;
+    }
+
+    static auto mutex = std::mutex{};
+    static auto schemas = std::vector<
+        std::pair<const TSLanguage *, std::unique_ptr<const Schema>>>{};
+    auto lock = std::lock_guard{mutex};
+    auto schema = static_cast<const Schema *>(nullptr);
+    for (const auto &[ts_language, cached_schema] : schemas) {
+      if (ts_language == language.AsRaw()) {
+        schema = cached_schema.get();
+        break;
+      }
+    }
+    if (schema == nullptr) {
+      schemas.emplace_back(language.AsRaw(),
+                           std::make_unique<const Schema>(language));
+      schema = schemas.back().second.get();
+    }
+    last_ts_language = language.AsRaw();
+    last_schema = schema;
+    return *schema;
+  }
+
+  template <ts::FixedString Name> auto Field() const noexcept -> ts::Node {
+    return node_.ChildByFieldId(schema_->template FieldId<Name>());
+  }
+
+  auto AsNode() const noexcept -> const ts::Node & { return node_; }
+
+private:
+  ts::Node node_;
+  const Schema *schema_;
+};
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_VIEW_H
@@ -0,0 +1,131 @@
+#ifndef CPP_TREE_SITTER_WALK_H
+#define CPP_TREE_SITTER_WALK_H
+
+#include <concepts>
+#include <utility>
+
+#include "api.h"
+
+namespace ts {
+
+// WalkAction
+// --------
+
+enum class WalkAction {
+  kContinue,
+  // Only meaningful when entering a node. The node is still left.
+  kSkipChildren,
+  kStop,
+};
+
+// Visitors
+// --------
+
+// A visitor called once per node. It receives the cursor positioned at the
+// node, so it can read the node, its field and its depth without allocating.
+template <typename Visitor>
+concept NodeVisitor =
+    requires(Visitor &visitor, const ts::TreeCursor &cursor) {
+      { visitor(cursor) } -> std::same_as<ts::WalkAction>;
+    };
+
+// A visitor called when a node is entered (pre-order) and left (post-order).
+template <typename Visitor>
+concept EnterLeaveVisitor =
+    requires(Visitor &visitor, const ts::TreeCursor &cursor) {
+      { visitor.Enter(cursor) } -> std::same_as<ts::WalkAction>;
+      { visitor.Leave(cursor) } -> std::same_as<ts::WalkAction>;
+    };
+
+// Walk
+// --------
+
+// Walks the subtree rooted at the current node of `cursor` iteratively. Apart
+// from the cursor's own stack, no memory is allocated while walking.
+// It returns `false` if the visitor stopped the walk, leaving the cursor at the
+// node it stopped at. Otherwise, it returns `true` and the cursor is back at
+// the node the walk started from.
+template <ts::EnterLeaveVisitor Visitor>
+auto Walk(ts::TreeCursor &cursor, Visitor &&visitor) noexcept -> bool {
+  uint32_t depth = 0;
+  while (true) {
+    const auto enter_action = visitor.Enter(std::as_const(cursor));
+    if (enter_action == ts::WalkAction::kStop) {
+      return false;
+    }
+    if (enter_action != ts::WalkAction::kSkipChildren &&
+        cursor.GotoFirstChild()) {
+      ++depth;
+      continue;
+    }
+
+    while (true) {
+      if (visitor.Leave(std::as_const(cursor)) == ts::WalkAction::kStop) {
+        return false;
+      }
+      if (depth == 0) {
+        return true;
+      }
+      if (cursor.GotoNextSibling()) {
+        break;
+      }
+      cursor.GotoParent();
+      --depth;
+    }
+  }
+}
+
+template <ts::NodeVisitor Visitor>
+auto WalkPreOrder(ts::TreeCursor &cursor, Visitor &&visitor) noexcept -> bool {
+  struct PreOrder {
+    Visitor &visitor;
+
+    auto Enter(const ts::TreeCursor &cursor) -> ts::WalkAction {
+      return visitor(cursor);
+    }
+    auto Leave(const ts::TreeCursor &) -> ts::WalkAction {
+      return ts::WalkAction::kContinue;
+    }
+  };
+  return ts::Walk(cursor, PreOrder{visitor});
+}
+
+// Returning `kSkipChildren` from a post-order visitor has no effect, because
+// the children have already been visited.
+template <ts::NodeVisitor Visitor>
+auto WalkPostOrder(ts::TreeCursor &cursor, Visitor &&visitor) noexcept
+    -> bool {
+  struct PostOrder {
+    Visitor &visitor;
+
+    auto Enter(const ts::TreeCursor &) -> ts::WalkAction {
+      return ts::WalkAction::kContinue;
+    }
+    auto Leave(const ts::TreeCursor &cursor) -> ts::WalkAction {
+      return visitor(cursor);
+    }
+  };
+  return ts::Walk(cursor, PostOrder{visitor});
+}
+
+template <ts::EnterLeaveVisitor Visitor>
+auto Walk(const ts::Node &node, Visitor &&visitor) noexcept -> bool {
+  auto cursor = ts::TreeCursor{node};
+  return ts::Walk(cursor, std::forward<Visitor>(visitor));
+}
+
+template <ts::NodeVisitor Visitor>
+auto WalkPreOrder(const ts::Node &node, Visitor &&visitor) noexcept -> bool {
+  auto cursor = ts::TreeCursor{node};
+  return ts::WalkPreOrder(cursor, std::forward<Visitor>(visitor));
+}
+
+template <ts::NodeVisitor Visitor>
+auto WalkPostOrder(const ts::Node &node, Visitor &&visitor) noexcept -> bool {
+  auto cursor = ts::TreeCursor{node};
+  return ts::WalkPostOrder(cursor, std::forward<Visitor>(visitor));
+}
+
+} // namespace ts
+
+#endif // CPP_TREE_SITTER_WALK_H
@@ -321,6 +321,41 @@ void ts_parser_set_timeout_micros(TSParser *self, uint64_t timeout_micros);
  */
 uint64_t ts_parser_timeout_micros(const TSParser *self);
 
+/**
+ * Counters of the parse loop for the last parse of the parser. They are reset
+ * when a new parse starts, and keep counting when a halted parse is resumed.
+ *
+ * - `lexed_bytes`: The bytes covered by the tokens the lexer produced.
+ * - `reused_bytes`: The bytes covered by the subtrees reused from the old tree.
+ * - `consumed_bytes`: The furthest byte that a stack version has reached, which
+ *   is the progress of a parse halted by a timeout.
+ * - `token_count`: The tokens the lexer produced, including error tokens.
+ * - `node_count`: The leaves and internal nodes the parser created.
+ * - `reused_subtree_count`: The subtrees reused from the old tree.
+ * - `error_recovery_count`: The times a stack version entered error recovery.
+ * - `max_version_count`: The largest number of stack versions at once.
+ * - `error_cost`: The error cost of the resulting tree.
+ * - `did_time_out`, `was_cancelled`: Why the last call halted, if it did.
+ */
+typedef struct TSParseStats {
+  uint64_t lexed_bytes;
+  uint64_t reused_bytes;
+  uint64_t consumed_bytes;
+  uint32_t token_count;
+  uint32_t node_count;
+  uint32_t reused_subtree_count;
+  uint32_t error_recovery_count;
+  uint32_t max_version_count;
+  uint32_t error_cost;
+  bool did_time_out;
+  bool was_cancelled;
+} TSParseStats;
+
+/**
+ * Get the counters of the last parse. See [`TSParseStats`].
+ */
+const TSParseStats *ts_parser_parse_stats(const TSParser *self);
+
 /**
  * Set the parser's current cancellation flag pointer.
  *
@@ -868,6 +903,17 @@ bool ts_query_is_pattern_rooted(const TSQuery *self, uint32_t pattern_index);
  */
 bool ts_query_is_pattern_non_local(const TSQuery *self, uint32_t pattern_index);
 
+/**
+ * Get the depth of the deepest node of the given pattern in the query, below
+ * its root nodes, which are at depth 0.
+ *
+ * A node that affects whether the pattern matches is at most this many levels
+ * below the root nodes of the match, so a change to the tree under a node can
+ * only affect the matches whose root nodes are at most this many levels above
+ * it.
+ */
+uint32_t ts_query_pattern_depth(const TSQuery *self, uint32_t pattern_index);
+
 /*
  * Check if a given pattern is guaranteed to match once a given step is reached.
  * The step is specified by its byte offset in the query's source code.
@@ -1253,6 +1299,13 @@ void ts_set_allocator(
 	void (*new_free)(void *)
 );
 
+/**
+ * Free a string or an array returned by the library, e.g.) by `ts_node_string`
+ * or `ts_tree_included_ranges`, with the free function set by
+ * `ts_set_allocator`.
+ */
+void ts_free_buffer(void *buffer);
+
 #ifdef __cplusplus
 }
 #endif
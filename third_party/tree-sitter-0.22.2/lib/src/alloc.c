@@ -46,3 +46,7 @@ void ts_set_allocator(
   ts_current_realloc = new_realloc ? new_realloc : ts_realloc_default;
   ts_current_free = new_free ? new_free : free;
 }
+
+void ts_free_buffer(void *buffer) {
+  ts_current_free(buffer);
+}
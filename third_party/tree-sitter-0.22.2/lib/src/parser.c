@@ -110,6 +110,7 @@ struct TSParser {
   Subtree old_tree;
   TSRangeArray included_range_differences;
   unsigned included_range_difference_index;
+  TSParseStats stats;
 };
 
 typedef struct {
@@ -665,6 +666,10 @@ static Subtree ts_parser__lex(
     }
   }
 
+  self->stats.token_count++;
+  self->stats.node_count++;
+  self->stats.lexed_bytes += ts_subtree_total_bytes(result);
+
   LOG_LOOKAHEAD(
     SYM_NAME(ts_subtree_symbol(result)),
     ts_subtree_total_size(result).bytes
@@ -794,6 +799,8 @@ static Subtree ts_parser__reuse_node(
     }
 
     LOG("reuse_node symbol:%s", TREE_NAME(result));
+    self->stats.reused_subtree_count++;
+    self->stats.reused_bytes += ts_subtree_total_bytes(result);
     ts_subtree_retain(result);
     return result;
   }
@@ -949,6 +956,7 @@ static StackVersion ts_parser__reduce(
     MutableSubtree parent = ts_subtree_new_node(
       symbol, &children, production_id, self->language
     );
+    self->stats.node_count++;
 
     // This pop operation may have caused multiple stack versions to collapse
     // into one, because they all diverged from a common state. In that case,
@@ -1400,6 +1408,7 @@ static void ts_parser__handle_error(
   Subtree lookahead
 ) {
   uint32_t previous_version_count = ts_stack_version_count(self->stack);
+  self->stats.error_recovery_count++;
 
   // Perform any reductions that can happen in this state, regardless of the lookahead. After
   // skipping one or more invalid tokens, the parser might find a token that would have allowed
@@ -1546,11 +1555,13 @@ static bool ts_parser__advance(
     if (++self->operation_count == OP_COUNT_PER_TIMEOUT_CHECK) {
       self->operation_count = 0;
     }
-    if (
-      self->operation_count == 0 &&
-      ((self->cancellation_flag && atomic_load(self->cancellation_flag)) ||
-       (!clock_is_null(self->end_clock) && clock_is_gt(clock_now(), self->end_clock)))
-    ) {
+    if (self->operation_count == 0) {
+      self->stats.was_cancelled = self->cancellation_flag && atomic_load(self->cancellation_flag);
+      self->stats.did_time_out =
+        !self->stats.was_cancelled &&
+        !clock_is_null(self->end_clock) && clock_is_gt(clock_now(), self->end_clock);
+    }
+    if (self->stats.was_cancelled || self->stats.did_time_out) {
       if (lookahead.ptr) {
         ts_subtree_release(&self->tree_pool, lookahead);
       }
@@ -1926,6 +1937,10 @@ void ts_parser_set_cancellation_flag(TSParser *self, const size_t *flag) {
   self->cancellation_flag = (const volatile size_t *)flag;
 }
 
+const TSParseStats *ts_parser_parse_stats(const TSParser *self) {
+  return &self->stats;
+}
+
 uint64_t ts_parser_timeout_micros(const TSParser *self) {
   return duration_to_micros(self->timeout_duration);
 }
@@ -1989,7 +2004,10 @@ TSTree *ts_parser_parse(
 
   if (ts_parser_has_outstanding_parse(self)) {
     LOG("resume_parsing");
+    self->stats.did_time_out = false;
+    self->stats.was_cancelled = false;
   } else if (old_tree) {
+    self->stats = (TSParseStats) {0};
     ts_subtree_retain(old_tree->root);
     self->old_tree = old_tree->root;
     ts_range_array_get_changed_ranges(
@@ -2005,6 +2023,7 @@ TSTree *ts_parser_parse(
       LOG("different_included_range %u - %u", range->start_byte, range->end_byte);
     }
   } else {
+    self->stats = (TSParseStats) {0};
     reusable_node_clear(&self->reusable_node);
     LOG("new_parse");
   }
@@ -2024,6 +2043,9 @@ TSTree *ts_parser_parse(
       version < version_count;
       version++
     ) {
+      if (version_count > self->stats.max_version_count) {
+        self->stats.max_version_count = version_count;
+      }
       bool allow_node_reuse = version_count == 1;
       while (ts_stack_is_active(self->stack, version)) {
         LOG(
@@ -2039,6 +2061,9 @@ TSTree *ts_parser_parse(
         LOG_STACK();
 
         position = ts_stack_position(self->stack, version).bytes;
+        if (position > self->stats.consumed_bytes) {
+          self->stats.consumed_bytes = position;
+        }
         if (position > last_position || (version > 0 && position == last_position)) {
           last_position = position;
           break;
@@ -2070,6 +2095,7 @@ TSTree *ts_parser_parse(
   } while (version_count != 0);
 
   assert(self->finished_tree.ptr);
+  self->stats.error_cost = ts_subtree_error_cost(self->finished_tree);
   ts_subtree_balance(self->finished_tree, &self->tree_pool, self->language);
   LOG("done");
   LOG_TREE(self->finished_tree);
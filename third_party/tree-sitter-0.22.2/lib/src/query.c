@@ -2897,6 +2897,22 @@ bool ts_query_is_pattern_non_local(
   }
 }
 
+uint32_t ts_query_pattern_depth(
+  const TSQuery *self,
+  uint32_t pattern_index
+) {
+  if (pattern_index >= self->patterns.size) return 0;
+  Slice steps = self->patterns.contents[pattern_index].steps;
+  uint32_t depth = 0;
+  for (uint32_t i = steps.offset; i < steps.offset + steps.length; i++) {
+    QueryStep *step = &self->steps.contents[i];
+    if (step->depth != PATTERN_DONE_MARKER && step->depth > depth) {
+      depth = step->depth;
+    }
+  }
+  return depth;
+}
+
 bool ts_query_is_pattern_guaranteed_at_step(
   const TSQuery *self,
   uint32_t byte_offset